@@ -0,0 +1,119 @@
+// CSV解析微基准：CsvTokenizer与原来的逐字符解析（QTextStream逐行读取后逐个QChar判断）对比。
+// 两者都把每个字段解码为QString，不写入工作表，只比较解析本身
+#include "../core/CsvTokenizer.h"
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+const int Columns = 10;
+
+// 生成rows行的测试数据：数字、普通文本，以及每行一个含分隔符与转义引号的字段
+QByteArray makeCsv(int rows)
+{
+    QByteArray csv;
+    for (int row = 0; row < rows; ++row) {
+        for (int col = 0; col < Columns; ++col) {
+            if (col > 0) {
+                csv += ',';
+            }
+            if (col == Columns - 1) {
+                csv += "\"quoted, \"\"text\"\" ";
+                csv += QByteArray::number(row);
+                csv += '"';
+            }
+            else if (col % 2 == 0) {
+                csv += QByteArray::number(row * 31 + col);
+            }
+            else {
+                csv += "value";
+                csv += QByteArray::number(col);
+            }
+        }
+        csv += '\n';
+    }
+    return csv;
+}
+
+// 原导入代码的解析循环
+void BM_PerCharacterParser(benchmark::State &state)
+{
+    QByteArray csv = makeCsv(int(state.range(0)));
+    for (auto _ : state) {
+        QTextStream stream(&csv, QIODevice::ReadOnly);
+        qint64 fieldCount = 0;
+        while (!stream.atEnd()) {
+            const QString line = stream.readLine();
+            QStringList fields;
+            bool inQuotes = false;
+            QString currentField;
+            for (int i = 0; i < line.length(); ++i) {
+                const QChar c = line[i];
+                if (c == '"') {
+                    if (inQuotes && i + 1 < line.length() && line[i + 1] == '"') {
+                        currentField += '"';
+                        ++i;
+                    }
+                    else {
+                        inQuotes = !inQuotes;
+                    }
+                }
+                else if (c == ',' && !inQuotes) {
+                    fields << currentField;
+                    currentField.clear();
+                }
+                else {
+                    currentField += c;
+                }
+            }
+            fields << currentField;
+            fieldCount += fields.size();
+        }
+        benchmark::DoNotOptimize(fieldCount);
+    }
+    state.SetBytesProcessed(state.iterations() * csv.size());
+}
+
+void BM_CsvTokenizer(benchmark::State &state)
+{
+    const QByteArray csv = makeCsv(int(state.range(0)));
+    for (auto _ : state) {
+        CsvTokenizer tokenizer;
+        qint64 fieldCount = 0;
+        tokenizer.tokenize(csv.constData(), csv.size(), true, [&fieldCount](int, int, const char *begin, qsizetype length) {
+            QString field = CsvTokenizer::decodeField(begin, length);
+            benchmark::DoNotOptimize(field);
+            ++fieldCount;
+        });
+        benchmark::DoNotOptimize(fieldCount);
+    }
+    state.SetBytesProcessed(state.iterations() * csv.size());
+}
+
+// 只分词不解码：分隔符定位本身的开销
+void BM_CsvTokenizerBoundariesOnly(benchmark::State &state)
+{
+    const QByteArray csv = makeCsv(int(state.range(0)));
+    for (auto _ : state) {
+        CsvTokenizer tokenizer;
+        qint64 bytes = 0;
+        tokenizer.tokenize(csv.constData(), csv.size(), true, [&bytes](int, int, const char *, qsizetype length) {
+            bytes += length;
+        });
+        benchmark::DoNotOptimize(bytes);
+    }
+    state.SetBytesProcessed(state.iterations() * csv.size());
+}
+
+} // namespace
+
+BENCHMARK(BM_PerCharacterParser)->Arg(10000)->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CsvTokenizer)->Arg(10000)->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CsvTokenizerBoundariesOnly)->Arg(10000)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,1120 @@
+#include "ArrowFormat.h"
+#include "Cell.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QDate>
+#include <QDateTime>
+#include <QTimeZone>
+#include <QList>
+#include <QVarLengthArray>
+#include <QtEndian>
+#include <QDebug>
+#include <QtCore/qfloat16.h>
+#include <climits>
+#include <cstring>
+#include <initializer_list>
+
+namespace {
+
+const char Magic[] = "ARROW1"; // 文件首尾的标记（开头补齐到8字节）
+const qsizetype MagicSize = 6;
+const qint16 MetadataVersionV5 = 4;
+
+// Message.header的联合类型
+enum MessageHeader : quint8 {
+    HeaderSchema = 1,
+    HeaderRecordBatch = 3
+};
+
+// Field.type的联合类型（Schema.fbs中Type的顺序）
+enum TypeId : quint8 {
+    TypeNull = 1,
+    TypeInt = 2,
+    TypeFloatingPoint = 3,
+    TypeBinary = 4,
+    TypeUtf8 = 5,
+    TypeBool = 6,
+    TypeDecimal = 7,
+    TypeDate = 8,
+    TypeTime = 9,
+    TypeTimestamp = 10,
+    TypeInterval = 11,
+    TypeList = 12,
+    TypeStruct = 13,
+    TypeUnion = 14,
+    TypeFixedSizeBinary = 15,
+    TypeFixedSizeList = 16,
+    TypeMap = 17,
+    TypeDuration = 18,
+    TypeLargeBinary = 19,
+    TypeLargeUtf8 = 20,
+    TypeLargeList = 21,
+    TypeRunEndEncoded = 22
+};
+
+enum Precision : qint16 { PrecisionHalf = 0, PrecisionSingle = 1, PrecisionDouble = 2 };
+enum DateUnit : qint16 { DateDay = 0, DateMillisecond = 1 };
+enum TimeUnit : qint16 { UnitSecond = 0, UnitMillisecond = 1, UnitMicrosecond = 2, UnitNanosecond = 3 };
+
+const QDate UnixEpoch(1970, 1, 1);
+const qint64 MsecsPerDay = 86400000;
+
+qint64 alignUp(qint64 value, qint64 alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+template <typename T>
+void appendLittleEndian(QByteArray &data, T value)
+{
+    char bytes[sizeof(T)];
+    qToLittleEndian(value, bytes);
+    data.append(bytes, sizeof(T));
+}
+
+// 向下取整的除法（时间值可能早于1970年）
+qint64 floorDivide(qint64 value, qint64 divisor)
+{
+    qint64 quotient = value / divisor;
+    if (value % divisor != 0 && value < 0) {
+        --quotient;
+    }
+    return quotient;
+}
+
+// 正向写出flatbuffer：先写出表，再在其后写出它引用的对象并回填引用
+// （uoffset_t是无符号数，引用总是指向更高的地址）。缓冲区起始处为根表的引用
+class FlatBufferWriter
+{
+public:
+    // 表的一个字段：size为1、2、4、8表示标量，为0表示引用（由writeTable给出其位置，稍后回填）
+    struct Field {
+        int id;
+        int size;
+        quint64 value;
+    };
+
+    FlatBufferWriter() { m_data.fill('\0', 8); }
+
+    // 写出一个表（先写vtable），返回表的位置；fieldPositions[id]为引用字段的位置
+    qsizetype writeTable(std::initializer_list<Field> fields, qsizetype *fieldPositions = nullptr)
+    {
+        int fieldCount = 0;
+        for (const Field &field : fields) {
+            fieldCount = qMax(fieldCount, field.id + 1);
+        }
+
+        // 表内布局：开头是到vtable的soffset_t，之后字段按大小从大到小排列，表本身按8字节对齐
+        QVarLengthArray<quint16, 8> fieldOffsets(fieldCount);
+        std::fill(fieldOffsets.begin(), fieldOffsets.end(), quint16(0));
+        int tableSize = 4;
+        for (int size : {8, 4, 2, 1}) {
+            for (const Field &field : fields) {
+                if ((field.size == 0 ? 4 : field.size) == size) {
+                    tableSize = int(alignUp(tableSize, size));
+                    fieldOffsets[field.id] = quint16(tableSize);
+                    tableSize += size;
+                }
+            }
+        }
+        tableSize = int(alignUp(tableSize, 4));
+
+        align(2);
+        const qsizetype vtable = m_data.size();
+        appendLittleEndian<quint16>(m_data, quint16(4 + 2 * fieldCount));
+        appendLittleEndian<quint16>(m_data, quint16(tableSize));
+        for (quint16 offset : fieldOffsets) {
+            appendLittleEndian<quint16>(m_data, offset);
+        }
+
+        align(8);
+        const qsizetype table = m_data.size();
+        m_data.append(tableSize, '\0');
+        qToLittleEndian<qint32>(qint32(table - vtable), m_data.data() + table);
+        for (const Field &field : fields) {
+            char *target = m_data.data() + table + fieldOffsets[field.id];
+            switch (field.size) {
+            case 0:
+                if (fieldPositions) {
+                    fieldPositions[field.id] = table + fieldOffsets[field.id];
+                }
+                break;
+            case 1:
+                *target = char(field.value);
+                break;
+            case 2:
+                qToLittleEndian<quint16>(quint16(field.value), target);
+                break;
+            case 4:
+                qToLittleEndian<quint32>(quint32(field.value), target);
+                break;
+            default:
+                qToLittleEndian<quint64>(field.value, target);
+                break;
+            }
+        }
+        return table;
+    }
+
+    qsizetype writeString(const QByteArray &utf8)
+    {
+        align(4);
+        const qsizetype position = m_data.size();
+        appendLittleEndian<quint32>(m_data, quint32(utf8.size()));
+        m_data.append(utf8);
+        m_data.append('\0');
+        return position;
+    }
+
+    // 结构体向量（元素已编码为elements），元素起始处按8字节对齐
+    qsizetype writeStructVector(const QByteArray &elements, int count)
+    {
+        align(4);
+        if ((m_data.size() + 4) % 8 != 0) {
+            m_data.append(4, '\0');
+        }
+        const qsizetype position = m_data.size();
+        appendLittleEndian<quint32>(m_data, quint32(count));
+        m_data.append(elements);
+        return position;
+    }
+
+    // 引用向量，第i个引用位于返回值 + 4 + 4 * i
+    qsizetype writeOffsetVector(int count)
+    {
+        align(4);
+        const qsizetype position = m_data.size();
+        appendLittleEndian<quint32>(m_data, quint32(count));
+        m_data.append(4 * qsizetype(count), '\0');
+        return position;
+    }
+
+    void patch(qsizetype slot, qsizetype target)
+    {
+        Q_ASSERT(target > slot);
+        qToLittleEndian<quint32>(quint32(target - slot), m_data.data() + slot);
+    }
+
+    void setRoot(qsizetype table) { patch(0, table); }
+
+    const QByteArray &data() const { return m_data; }
+
+private:
+    void align(int alignment)
+    {
+        m_data.append(alignUp(m_data.size(), alignment) - m_data.size(), '\0');
+    }
+
+    QByteArray m_data;
+};
+
+// 带边界检查的flatbuffer表访问。越界时把共享的valid标记置为false，访问结果为缺省值
+class FlatTable
+{
+public:
+    FlatTable() = default;
+
+    static FlatTable root(const char *data, qsizetype size, bool *valid)
+    {
+        FlatTable buffer(data, size, valid);
+        if (!buffer.check(0, 4)) {
+            return FlatTable();
+        }
+        return buffer.tableAtOffset(0);
+    }
+
+    bool isNull() const { return !m_data; }
+
+    template <typename T>
+    T scalar(int id, T defaultValue = T()) const
+    {
+        const qsizetype position = field(id);
+        if (position < 0 || !check(position, sizeof(T))) {
+            return defaultValue;
+        }
+        return qFromLittleEndian<T>(m_data + position);
+    }
+
+    FlatTable table(int id) const
+    {
+        const qsizetype position = field(id);
+        return position < 0 ? FlatTable() : tableAtOffset(position);
+    }
+
+    QByteArray string(int id) const
+    {
+        qsizetype length = 0;
+        const qsizetype position = vector(id, 1, &length);
+        return position < 0 ? QByteArray() : QByteArray(m_data + position, length);
+    }
+
+    // 向量元素的起始位置与个数，字段不存在或越界时返回-1
+    qsizetype vector(int id, int elementSize, qsizetype *count) const
+    {
+        *count = 0;
+        const qsizetype slot = field(id);
+        if (slot < 0 || !check(slot, 4)) {
+            return -1;
+        }
+        const qsizetype position = slot + qFromLittleEndian<quint32>(m_data + slot);
+        if (!check(position, 4)) {
+            return -1;
+        }
+        const qsizetype length = qFromLittleEndian<quint32>(m_data + position);
+        if (!check(position + 4, length * elementSize)) {
+            return -1;
+        }
+        *count = length;
+        return position + 4;
+    }
+
+    // 引用向量（元素起始位置为elements）中的第index个表
+    FlatTable tableAt(qsizetype elements, qsizetype index) const
+    {
+        return tableAtOffset(elements + 4 * index);
+    }
+
+    const char *data() const { return m_data; }
+
+private:
+    FlatTable(const char *data, qsizetype size, bool *valid)
+        : m_data(data), m_size(size), m_valid(valid)
+    {
+    }
+
+    bool check(qsizetype position, qsizetype length) const
+    {
+        if (position < 0 || length < 0 || position > m_size || length > m_size - position) {
+            *m_valid = false;
+            return false;
+        }
+        return true;
+    }
+
+    // slot处的uoffset_t所引用的表
+    FlatTable tableAtOffset(qsizetype slot) const
+    {
+        if (!check(slot, 4)) {
+            return FlatTable();
+        }
+        const qsizetype position = slot + qFromLittleEndian<quint32>(m_data + slot);
+        if (!check(position, 4)) {
+            return FlatTable();
+        }
+        const qsizetype vtable = position - qFromLittleEndian<qint32>(m_data + position);
+        if (!check(vtable, 4)) {
+            return FlatTable();
+        }
+        const quint16 vtableSize = qFromLittleEndian<quint16>(m_data + vtable);
+        if (vtableSize < 4 || !check(vtable, vtableSize)) {
+            return FlatTable();
+        }
+        FlatTable table(m_data, m_size, m_valid);
+        table.m_position = position;
+        table.m_vtable = vtable;
+        table.m_vtableSize = vtableSize;
+        return table;
+    }
+
+    // 字段在缓冲区中的位置，字段不存在（取缺省值）时返回-1
+    qsizetype field(int id) const
+    {
+        if (!m_data || 4 + 2 * id + 2 > m_vtableSize) {
+            return -1;
+        }
+        const quint16 offset = qFromLittleEndian<quint16>(m_data + m_vtable + 4 + 2 * id);
+        return offset == 0 ? -1 : m_position + offset;
+    }
+
+    const char *m_data = nullptr;
+    qsizetype m_size = 0;
+    bool *m_valid = nullptr;
+    qsizetype m_position = 0;
+    qsizetype m_vtable = 0;
+    quint16 m_vtableSize = 0;
+};
+
+// ---------------------------------------------------------------- 导出
+
+// 列的Arrow类型，由列中的值决定
+enum ColumnKind {
+    EmptyColumn,
+    BoolColumn,
+    IntColumn,
+    DoubleColumn,
+    DateColumn,
+    DateTimeColumn,
+    TextColumn
+};
+
+ColumnKind valueKind(const QVariant &value)
+{
+    switch (value.typeId()) {
+    case QMetaType::UnknownType:
+        return EmptyColumn;
+    case QMetaType::Bool:
+        return BoolColumn;
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::LongLong:
+    case QMetaType::ULongLong:
+    case QMetaType::Short:
+    case QMetaType::UShort:
+        return IntColumn;
+    case QMetaType::Double:
+    case QMetaType::Float:
+        return DoubleColumn;
+    case QMetaType::QDate:
+        return value.toDate().isValid() ? DateColumn : EmptyColumn;
+    case QMetaType::QDateTime:
+        return value.toDateTime().isValid() ? DateTimeColumn : EmptyColumn;
+    default:
+        return value.toString().isEmpty() ? EmptyColumn : TextColumn;
+    }
+}
+
+// 整数与小数合为Float64，日期与日期时间合为Timestamp，其他组合只能保存为文本
+ColumnKind mergeKinds(ColumnKind a, ColumnKind b)
+{
+    if (a == EmptyColumn || a == b) {
+        return b;
+    }
+    if (b == EmptyColumn) {
+        return a;
+    }
+    if ((a == IntColumn && b == DoubleColumn) || (a == DoubleColumn && b == IntColumn)) {
+        return DoubleColumn;
+    }
+    if ((a == DateColumn && b == DateTimeColumn) || (a == DateTimeColumn && b == DateColumn)) {
+        return DateTimeColumn;
+    }
+    return TextColumn;
+}
+
+QString columnName(int col)
+{
+    QString name;
+    for (int n = col + 1; n > 0; n = (n - 1) / 26) {
+        name.prepend(QChar('A' + (n - 1) % 26));
+    }
+    return name;
+}
+
+// 写出Schema表并回填slot处的引用
+void writeSchema(FlatBufferWriter &writer, qsizetype slot, const QList<ColumnKind> &kinds)
+{
+    qsizetype schemaSlots[2] = {};
+    const qsizetype schema = writer.writeTable({{1, 0, 0}}, schemaSlots); // endianness取缺省值Little
+    writer.patch(slot, schema);
+
+    const qsizetype fields = writer.writeOffsetVector(int(kinds.size()));
+    writer.patch(schemaSlots[1], fields);
+
+    for (int col = 0; col < kinds.size(); ++col) {
+        TypeId typeId = TypeUtf8;
+        switch (kinds[col]) {
+        case EmptyColumn: typeId = TypeNull; break;
+        case BoolColumn: typeId = TypeBool; break;
+        case IntColumn: typeId = TypeInt; break;
+        case DoubleColumn: typeId = TypeFloatingPoint; break;
+        case DateColumn: typeId = TypeDate; break;
+        case DateTimeColumn: typeId = TypeTimestamp; break;
+        case TextColumn: typeId = TypeUtf8; break;
+        }
+
+        qsizetype fieldSlots[6] = {};
+        const qsizetype field = writer.writeTable({{0, 0, 0}, {1, 1, 1}, {2, 1, typeId}, {3, 0, 0}, {5, 0, 0}},
+                                                  fieldSlots);
+        writer.patch(fields + 4 + 4 * col, field);
+        writer.patch(fieldSlots[0], writer.writeString(columnName(col).toUtf8()));
+
+        qsizetype typeSlots[2] = {};
+        qsizetype type = 0;
+        switch (typeId) {
+        case TypeInt:
+            type = writer.writeTable({{0, 4, 64}, {1, 1, 1}}); // bitWidth, is_signed
+            break;
+        case TypeFloatingPoint:
+            type = writer.writeTable({{0, 2, quint64(PrecisionDouble)}});
+            break;
+        case TypeDate:
+            type = writer.writeTable({{0, 2, quint64(DateDay)}}); // 缺省单位是毫秒，须明确写出
+            break;
+        case TypeTimestamp:
+            type = writer.writeTable({{0, 2, quint64(UnitMillisecond)}, {1, 0, 0}}, typeSlots);
+            break;
+        default:
+            type = writer.writeTable({});
+            break;
+        }
+        writer.patch(fieldSlots[3], type);
+        if (typeId == TypeTimestamp) {
+            writer.patch(typeSlots[1], writer.writeString("UTC"));
+        }
+        writer.patch(fieldSlots[5], writer.writeOffsetVector(0)); // 没有子字段，但向量不能省略
+    }
+}
+
+// 记录批次中一列的缓冲区
+struct ColumnData {
+    ColumnKind kind = EmptyColumn;
+    QByteArray validity;
+    QByteArray values;
+    QByteArray offsets; // 文本列的int32偏移量
+    QByteArray text;
+    qint64 validCount = 0;
+    qint64 offsetsFilled = 0; // 已填写偏移量的行数
+
+    void reset(ColumnKind columnKind, qint64 rows)
+    {
+        kind = columnKind;
+        validCount = 0;
+        offsetsFilled = 0;
+        validity = QByteArray((rows + 7) / 8, '\0');
+        text.clear();
+        offsets.clear();
+        switch (kind) {
+        case EmptyColumn:
+            values.clear();
+            break;
+        case BoolColumn:
+            values = QByteArray((rows + 7) / 8, '\0');
+            break;
+        case DateColumn:
+            values = QByteArray(rows * 4, '\0');
+            break;
+        case TextColumn:
+            values.clear();
+            offsets = QByteArray((rows + 1) * 4, '\0');
+            break;
+        default:
+            values = QByteArray(rows * 8, '\0');
+            break;
+        }
+    }
+
+    void fillOffsets(qint64 end)
+    {
+        for (; offsetsFilled < end; ++offsetsFilled) {
+            qToLittleEndian<qint32>(qint32(text.size()), offsets.data() + 4 * offsetsFilled);
+        }
+    }
+
+    // 写入第row行的值，值无法表示为该类型时保持为null
+    void set(qint64 row, const QVariant &value)
+    {
+        switch (kind) {
+        case EmptyColumn:
+            return;
+        case BoolColumn:
+            if (value.toBool()) {
+                values[row / 8] = char(values[row / 8] | (1 << (row % 8)));
+            }
+            break;
+        case IntColumn:
+            qToLittleEndian<qint64>(value.toLongLong(), values.data() + 8 * row);
+            break;
+        case DoubleColumn: {
+            const double number = value.toDouble();
+            quint64 bits;
+            std::memcpy(&bits, &number, sizeof(bits));
+            qToLittleEndian<quint64>(bits, values.data() + 8 * row);
+            break;
+        }
+        case DateColumn:
+            qToLittleEndian<qint32>(qint32(UnixEpoch.daysTo(value.toDate())), values.data() + 4 * row);
+            break;
+        case DateTimeColumn: {
+            const QDateTime dateTime = value.typeId() == QMetaType::QDate
+                    ? value.toDate().startOfDay()
+                    : value.toDateTime();
+            qToLittleEndian<qint64>(dateTime.toMSecsSinceEpoch(), values.data() + 8 * row);
+            break;
+        }
+        case TextColumn:
+            fillOffsets(row + 1);
+            text.append(value.toString().toUtf8());
+            break;
+        }
+        validity[row / 8] = char(validity[row / 8] | (1 << (row % 8)));
+        ++validCount;
+    }
+};
+
+// 写出一条封装的消息（续行标记、元数据长度、元数据、消息体），返回文件尾中记录的Block
+bool writeMessage(QIODevice &file, const QByteArray &metadata, const QByteArray &body, QByteArray *block)
+{
+    const qint64 offset = file.pos();
+    const qint32 metadataLength = qint32(alignUp(8 + metadata.size(), 8) - 8);
+
+    QByteArray prefix;
+    appendLittleEndian<quint32>(prefix, 0xFFFFFFFFu);
+    appendLittleEndian<qint32>(prefix, metadataLength);
+    if (file.write(prefix) != prefix.size()
+            || file.write(metadata) != metadata.size()
+            || file.write(QByteArray(metadataLength - metadata.size(), '\0')) != metadataLength - metadata.size()
+            || file.write(body) != body.size()) {
+        return false;
+    }
+
+    if (block) {
+        // Block { offset: long; metaDataLength: int; (补齐) bodyLength: long; }
+        appendLittleEndian<qint64>(*block, offset);
+        appendLittleEndian<qint32>(*block, 8 + metadataLength);
+        appendLittleEndian<qint32>(*block, 0);
+        appendLittleEndian<qint64>(*block, body.size());
+    }
+    return true;
+}
+
+// 写出Message表作为根，*headerSlot为其中header引用的位置
+void writeMessageTable(FlatBufferWriter &writer, MessageHeader headerType, qint64 bodyLength,
+                       qsizetype *headerSlot)
+{
+    qsizetype fieldPositions[4] = {};
+    const qsizetype message = writer.writeTable({{0, 2, quint64(MetadataVersionV5)},
+                                                 {1, 1, headerType},
+                                                 {2, 0, 0},
+                                                 {3, 8, quint64(bodyLength)}}, fieldPositions);
+    writer.setRoot(message);
+    *headerSlot = fieldPositions[2];
+}
+
+// ---------------------------------------------------------------- 导入
+
+// 一种类型在消息体中占用的缓冲区个数（不含子字段），无法处理的类型返回-1
+int bufferCount(quint8 typeId, const FlatTable &type)
+{
+    switch (typeId) {
+    case TypeNull:
+    case TypeRunEndEncoded:
+        return 0;
+    case TypeStruct:
+    case TypeFixedSizeList:
+        return 1;
+    case TypeUnion:
+        return type.scalar<qint16>(0) == 1 ? 2 : 1; // Dense有类型与偏移两个缓冲区，Sparse只有类型
+    case TypeInt:
+    case TypeFloatingPoint:
+    case TypeBool:
+    case TypeDecimal:
+    case TypeDate:
+    case TypeTime:
+    case TypeTimestamp:
+    case TypeInterval:
+    case TypeFixedSizeBinary:
+    case TypeDuration:
+    case TypeList:
+    case TypeMap:
+    case TypeLargeList:
+        return 2;
+    case TypeBinary:
+    case TypeUtf8:
+    case TypeLargeBinary:
+    case TypeLargeUtf8:
+        return 3;
+    default:
+        return -1; // 视图类型的缓冲区个数可变
+    }
+}
+
+// 字段（连同子字段）占用的节点与缓冲区个数
+bool countField(const FlatTable &field, qsizetype *nodes, qsizetype *buffers)
+{
+    *nodes += 1;
+    if (!field.table(4).isNull()) { // 字典编码：消息体中只有索引
+        *buffers += 2;
+        return true;
+    }
+    const int count = bufferCount(field.scalar<quint8>(2), field.table(3));
+    if (count < 0) {
+        return false;
+    }
+    *buffers += count;
+
+    qsizetype childCount = 0;
+    const qsizetype children = field.vector(5, 4, &childCount);
+    for (qsizetype i = 0; i < childCount; ++i) {
+        if (!countField(field.tableAt(children, i), nodes, buffers)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 一个记录批次的消息体
+class RecordBatchBody
+{
+public:
+    RecordBatchBody(const FlatTable &batch, const char *body, qint64 bodyLength)
+        : m_body(body), m_bodyLength(bodyLength)
+    {
+        m_nodes = batch.vector(1, 16, &m_nodeCount);
+        m_buffers = batch.vector(2, 16, &m_bufferCount);
+        m_metadata = batch.data();
+    }
+
+    // FieldNode { length: long; null_count: long; }
+    bool node(qsizetype index, qint64 *length, qint64 *nullCount) const
+    {
+        if (index >= m_nodeCount) {
+            return false;
+        }
+        const char *node = m_metadata + m_nodes + 16 * index;
+        *length = qFromLittleEndian<qint64>(node);
+        *nullCount = qFromLittleEndian<qint64>(node + 8);
+        return *length >= 0 && *nullCount >= 0 && *nullCount <= *length;
+    }
+
+    // Buffer { offset: long; length: long; }，相对于消息体起始
+    bool buffer(qsizetype index, const char **data, qint64 *length) const
+    {
+        if (index >= m_bufferCount) {
+            return false;
+        }
+        const char *buffer = m_metadata + m_buffers + 16 * index;
+        const qint64 offset = qFromLittleEndian<qint64>(buffer);
+        *length = qFromLittleEndian<qint64>(buffer + 8);
+        if (offset < 0 || *length < 0 || offset > m_bodyLength || *length > m_bodyLength - offset) {
+            return false;
+        }
+        *data = m_body + offset;
+        return true;
+    }
+
+private:
+    const char *m_metadata;
+    const char *m_body;
+    qint64 m_bodyLength;
+    qsizetype m_nodes;
+    qsizetype m_nodeCount;
+    qsizetype m_buffers;
+    qsizetype m_bufferCount;
+};
+
+// 读取一个基本类型的列并写入worksheet的col列，从rowBase行开始；不支持的类型不写入
+bool readColumn(const FlatTable &field, const RecordBatchBody &body, qsizetype node, qsizetype buffer,
+                Worksheet *worksheet, qint64 rowBase, int col)
+{
+    if (!field.table(4).isNull()) {
+        return true; // 字典编码的列被跳过
+    }
+    const quint8 typeId = field.scalar<quint8>(2);
+    const FlatTable type = field.table(3);
+    if (bufferCount(typeId, type) < 2 || typeId == TypeNull) {
+        return true;
+    }
+
+    qint64 length = 0;
+    qint64 nullCount = 0;
+    if (!body.node(node, &length, &nullCount)) {
+        return false;
+    }
+    if (rowBase + length > INT_MAX) {
+        return false;
+    }
+
+    const char *validity = nullptr;
+    qint64 validityLength = 0;
+    if (!body.buffer(buffer, &validity, &validityLength)) {
+        return false;
+    }
+    if (validityLength == 0) {
+        if (nullCount != 0) {
+            return false;
+        }
+        validity = nullptr; // 没有null时可以省略有效位图
+    }
+    else if (validityLength < (length + 7) / 8) {
+        return false;
+    }
+
+    const char *values = nullptr;
+    qint64 valuesLength = 0;
+    if (!body.buffer(buffer + 1, &values, &valuesLength)) {
+        return false;
+    }
+
+    auto isValid = [&](qint64 i) {
+        return !validity || (validity[i / 8] >> (i % 8)) & 1;
+    };
+    auto store = [&](qint64 i, const QVariant &value) {
+        worksheet->cell(int(rowBase + i), col)->setValue(value);
+    };
+    auto readValues = [&](int width, auto decode) {
+        if (valuesLength / width < length) {
+            return false;
+        }
+        for (qint64 i = 0; i < length; ++i) {
+            if (isValid(i)) {
+                store(i, decode(values + width * i));
+            }
+        }
+        return true;
+    };
+
+    switch (typeId) {
+    case TypeInt: {
+        const int bitWidth = type.scalar<qint32>(0);
+        const bool isSigned = type.scalar<quint8>(1) != 0;
+        switch (bitWidth) {
+        case 8:
+            return isSigned ? readValues(1, [](const char *p) { return QVariant(qint64(qint8(*p))); })
+                            : readValues(1, [](const char *p) { return QVariant(qint64(quint8(*p))); });
+        case 16:
+            return isSigned ? readValues(2, [](const char *p) { return QVariant(qint64(qFromLittleEndian<qint16>(p))); })
+                            : readValues(2, [](const char *p) { return QVariant(qint64(qFromLittleEndian<quint16>(p))); });
+        case 32:
+            return isSigned ? readValues(4, [](const char *p) { return QVariant(qint64(qFromLittleEndian<qint32>(p))); })
+                            : readValues(4, [](const char *p) { return QVariant(qint64(qFromLittleEndian<quint32>(p))); });
+        case 64:
+            return isSigned ? readValues(8, [](const char *p) { return QVariant(qFromLittleEndian<qint64>(p)); })
+                            : readValues(8, [](const char *p) { return QVariant(qFromLittleEndian<quint64>(p)); });
+        default:
+            return false;
+        }
+    }
+    case TypeFloatingPoint:
+        switch (type.scalar<qint16>(0)) {
+        case PrecisionHalf:
+            return readValues(2, [](const char *p) {
+                const quint16 bits = qFromLittleEndian<quint16>(p);
+                qfloat16 number;
+                std::memcpy(&number, &bits, sizeof(bits));
+                return QVariant(double(float(number)));
+            });
+        case PrecisionSingle:
+            return readValues(4, [](const char *p) {
+                const quint32 bits = qFromLittleEndian<quint32>(p);
+                float number;
+                std::memcpy(&number, &bits, sizeof(bits));
+                return QVariant(double(number));
+            });
+        case PrecisionDouble:
+            return readValues(8, [](const char *p) {
+                const quint64 bits = qFromLittleEndian<quint64>(p);
+                double number;
+                std::memcpy(&number, &bits, sizeof(bits));
+                return QVariant(number);
+            });
+        default:
+            return false;
+        }
+    case TypeBool:
+        if (valuesLength < (length + 7) / 8) {
+            return false;
+        }
+        for (qint64 i = 0; i < length; ++i) {
+            if (isValid(i)) {
+                store(i, bool((values[i / 8] >> (i % 8)) & 1));
+            }
+        }
+        return true;
+    case TypeDate:
+        if (type.scalar<qint16>(0, DateMillisecond) == DateDay) {
+            return readValues(4, [](const char *p) {
+                return QVariant(UnixEpoch.addDays(qFromLittleEndian<qint32>(p)));
+            });
+        }
+        return readValues(8, [](const char *p) {
+            return QVariant(UnixEpoch.addDays(floorDivide(qFromLittleEndian<qint64>(p), MsecsPerDay)));
+        });
+    case TypeTimestamp: {
+        const qint16 unit = type.scalar<qint16>(0, UnitSecond);
+        const bool hasTimeZone = !type.string(1).isEmpty();
+        return readValues(8, [unit, hasTimeZone](const char *p) {
+            const qint64 value = qFromLittleEndian<qint64>(p);
+            qint64 msecs = value;
+            switch (unit) {
+            case UnitSecond: msecs = value * 1000; break;
+            case UnitMicrosecond: msecs = floorDivide(value, 1000); break;
+            case UnitNanosecond: msecs = floorDivide(value, 1000000); break;
+            default: break;
+            }
+            // 带时区的时间戳是UTC时刻，显示为本地时间；不带时区的表示“墙上时间”，按原样显示
+            if (hasTimeZone) {
+                return QVariant(QDateTime::fromMSecsSinceEpoch(msecs));
+            }
+            const QDateTime utc = QDateTime::fromMSecsSinceEpoch(msecs, QTimeZone::utc());
+            return QVariant(QDateTime(utc.date(), utc.time()));
+        });
+    }
+    case TypeUtf8:
+    case TypeLargeUtf8: {
+        const int offsetWidth = typeId == TypeUtf8 ? 4 : 8;
+        const char *text = nullptr;
+        qint64 textLength = 0;
+        if (length == 0) {
+            return true;
+        }
+        if (!body.buffer(buffer + 2, &text, &textLength) || valuesLength / offsetWidth < length + 1) {
+            return false;
+        }
+        auto offsetAt = [&](qint64 i) {
+            return offsetWidth == 4 ? qint64(qFromLittleEndian<qint32>(values + 4 * i))
+                                    : qFromLittleEndian<qint64>(values + 8 * i);
+        };
+        qint64 begin = offsetAt(0);
+        for (qint64 i = 0; i < length; ++i) {
+            const qint64 end = offsetAt(i + 1);
+            if (begin < 0 || end < begin || end > textLength) {
+                return false;
+            }
+            if (isValid(i)) {
+                store(i, QString::fromUtf8(text + begin, end - begin));
+            }
+            begin = end;
+        }
+        return true;
+    }
+    default:
+        return true; // 其他类型（二进制、小数、时间等）的列被跳过
+    }
+}
+
+} // namespace
+
+// 导出：先扫描一遍确定各列类型，再按批次填充各列缓冲区并写出
+bool ArrowFormat::exportWorksheet(const Worksheet *worksheet, const QString &fileName,
+                                  const FileManager::ProgressCallback &progress)
+{
+    int maxRow = -1;
+    int maxCol = -1;
+    worksheet->usedRange(&maxRow, &maxCol);
+
+    QList<ColumnKind> kinds(maxCol + 1, EmptyColumn);
+    const QMap<int, Worksheet::Row> &rows = worksheet->rows();
+    for (auto row = rows.cbegin(); row != rows.cend(); ++row) {
+        for (auto it = row.value().cbegin(); it != row.value().cend(); ++it) {
+            if (it.key() <= maxCol && it.value() && !it.value()->isEmpty()) {
+                kinds[it.key()] = mergeKinds(kinds[it.key()], valueKind(it.value()->value()));
+            }
+        }
+    }
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "Cannot open file for writing:" << fileName;
+        return false;
+    }
+
+    QByteArray header(Magic, MagicSize);
+    header.append(2, '\0');
+    file.write(header);
+
+    // 模式消息
+    {
+        FlatBufferWriter writer;
+        qsizetype headerSlot = 0;
+        writeMessageTable(writer, HeaderSchema, 0, &headerSlot);
+        writeSchema(writer, headerSlot, kinds);
+        if (!writeMessage(file, writer.data(), QByteArray(), nullptr)) {
+            return false;
+        }
+    }
+
+    // 记录批次
+    const qint64 rowCount = maxRow + 1;
+    const qint64 batchRows = qBound<qint64>(1, TargetCells / qMax(1, int(kinds.size())), BatchRows);
+    const qint64 batchCount = kinds.isEmpty() ? 0 : (rowCount + batchRows - 1) / batchRows;
+    QList<ColumnData> columns(kinds.size());
+    QByteArray blocks;
+
+    for (qint64 batch = 0; batch < batchCount; ++batch) {
+        const qint64 first = batch * batchRows;
+        const qint64 length = qMin(batchRows, rowCount - first);
+        for (int col = 0; col < kinds.size(); ++col) {
+            columns[col].reset(kinds[col], length);
+        }
+
+        for (auto row = rows.lowerBound(int(first)); row != rows.cend() && row.key() < first + length; ++row) {
+            for (auto it = row.value().cbegin(); it != row.value().cend() && it.key() <= maxCol; ++it) {
+                if (!it.value() || it.value()->isEmpty()) {
+                    continue;
+                }
+                const QVariant value = it.value()->value();
+                if (valueKind(value) != EmptyColumn) {
+                    columns[it.key()].set(row.key() - first, value);
+                }
+            }
+        }
+
+        // 消息体：各列依次为有效位图（没有null时省略）、值或偏移量、文本
+        QByteArray nodes;
+        QByteArray buffers;
+        QByteArray body;
+        auto addBuffer = [&](const QByteArray &data) {
+            appendLittleEndian<qint64>(buffers, body.size());
+            appendLittleEndian<qint64>(buffers, data.size());
+            body.append(data);
+            body.append(alignUp(body.size(), 8) - body.size(), '\0');
+        };
+        int bufferCount = 0;
+        for (ColumnData &column : columns) {
+            appendLittleEndian<qint64>(nodes, length);
+            appendLittleEndian<qint64>(nodes, length - column.validCount);
+            if (column.kind == EmptyColumn) {
+                continue;
+            }
+            addBuffer(column.validCount == length ? QByteArray() : column.validity);
+            if (column.kind == TextColumn) {
+                if (column.text.size() > INT_MAX) {
+                    qDebug() << "Text column too large for a record batch:" << fileName;
+                    return false;
+                }
+                column.fillOffsets(length + 1);
+                addBuffer(column.offsets);
+                addBuffer(column.text);
+                bufferCount += 3;
+            }
+            else {
+                addBuffer(column.values);
+                bufferCount += 2;
+            }
+        }
+
+        FlatBufferWriter writer;
+        qsizetype headerSlot = 0;
+        writeMessageTable(writer, HeaderRecordBatch, body.size(), &headerSlot);
+        qsizetype batchSlots[3] = {};
+        const qsizetype recordBatch = writer.writeTable({{0, 8, quint64(length)}, {1, 0, 0}, {2, 0, 0}}, batchSlots);
+        writer.patch(headerSlot, recordBatch);
+        writer.patch(batchSlots[1], writer.writeStructVector(nodes, int(kinds.size())));
+        writer.patch(batchSlots[2], writer.writeStructVector(buffers, bufferCount));
+
+        if (!writeMessage(file, writer.data(), body, &blocks)) {
+            return false;
+        }
+        if (progress && !progress(batch + 1, batchCount)) {
+            file.cancelWriting();
+            return false;
+        }
+    }
+
+    // 流结束标记与文件尾
+    QByteArray end;
+    appendLittleEndian<quint32>(end, 0xFFFFFFFFu);
+    appendLittleEndian<qint32>(end, 0);
+
+    FlatBufferWriter writer;
+    qsizetype footerSlots[4] = {};
+    writer.setRoot(writer.writeTable({{0, 2, quint64(MetadataVersionV5)}, {1, 0, 0}, {2, 0, 0}, {3, 0, 0}},
+                                     footerSlots));
+    writeSchema(writer, footerSlots[1], kinds);
+    writer.patch(footerSlots[2], writer.writeStructVector(QByteArray(), 0));
+    writer.patch(footerSlots[3], writer.writeStructVector(blocks, int(batchCount)));
+    end.append(writer.data());
+    appendLittleEndian<qint32>(end, qint32(writer.data().size()));
+    end.append(Magic, MagicSize);
+
+    if (file.write(end) != end.size()) {
+        return false;
+    }
+    return file.commit();
+}
+
+// 导入：从文件尾找到模式与各记录批次，逐批把支持的列写入工作表
+bool ArrowFormat::importWorksheet(Worksheet *worksheet, const QString &fileName,
+                                  const FileManager::ProgressCallback &progress)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "Cannot open file for reading:" << fileName;
+        return false;
+    }
+    const qint64 size = file.size();
+    if (size < 8 + 4 + MagicSize) {
+        qDebug() << "Not an Arrow file:" << fileName;
+        return false;
+    }
+    const char *data = reinterpret_cast<const char *>(file.map(0, size));
+    if (!data) {
+        qDebug() << "Cannot map file:" << fileName;
+        return false;
+    }
+    if (std::memcmp(data, Magic, MagicSize) != 0 || std::memcmp(data + size - MagicSize, Magic, MagicSize) != 0) {
+        qDebug() << "Not an Arrow file:" << fileName;
+        return false;
+    }
+
+    const qint64 footerLength = qFromLittleEndian<qint32>(data + size - MagicSize - 4);
+    const qint64 footerStart = size - MagicSize - 4 - footerLength;
+    if (footerLength <= 0 || footerStart < 8) {
+        qDebug() << "Invalid Arrow footer:" << fileName;
+        return false;
+    }
+
+    bool valid = true;
+    const FlatTable footer = FlatTable::root(data + footerStart, footerLength, &valid);
+    const FlatTable schema = footer.table(1);
+    if (schema.isNull() || schema.scalar<qint16>(0) != 0) {
+        qDebug() << "Unsupported Arrow schema (missing or big-endian):" << fileName;
+        return false;
+    }
+
+    qsizetype fieldCount = 0;
+    const qsizetype fieldVector = schema.vector(1, 4, &fieldCount);
+    QList<FlatTable> fields;
+    QList<qsizetype> nodeIndex; // 各顶层字段的第一个节点与缓冲区
+    QList<qsizetype> bufferIndex;
+    qsizetype nodes = 0;
+    qsizetype buffers = 0;
+    for (qsizetype i = 0; i < fieldCount; ++i) {
+        fields.append(schema.tableAt(fieldVector, i));
+        nodeIndex.append(nodes);
+        bufferIndex.append(buffers);
+        if (!countField(fields.last(), &nodes, &buffers)) {
+            qDebug() << "Unsupported Arrow column type:" << fileName;
+            return false;
+        }
+    }
+
+    qsizetype blockCount = 0;
+    const qsizetype blockVector = footer.vector(3, 24, &blockCount);
+    if (!valid) {
+        qDebug() << "Invalid Arrow footer:" << fileName;
+        return false;
+    }
+
+    qint64 rowBase = 0;
+    for (qsizetype i = 0; i < blockCount; ++i) {
+        const char *block = footer.data() + blockVector + 24 * i;
+        const qint64 offset = qFromLittleEndian<qint64>(block);
+        const qint64 metadataLength = qFromLittleEndian<qint32>(block + 8);
+        const qint64 bodyLength = qFromLittleEndian<qint64>(block + 16);
+        if (offset < 8 || metadataLength < 8 || bodyLength < 0
+                || metadataLength > footerStart - offset || bodyLength > footerStart - offset - metadataLength) {
+            qDebug() << "Invalid Arrow record batch block:" << fileName;
+            return false;
+        }
+
+        // 旧格式的消息没有续行标记，直接以长度开头
+        const bool continuation = qFromLittleEndian<quint32>(data + offset) == 0xFFFFFFFFu;
+        const qint64 prefix = continuation ? 8 : 4;
+        const FlatTable message = FlatTable::root(data + offset + prefix, metadataLength - prefix, &valid);
+        const FlatTable batch = message.table(2);
+        if (message.scalar<quint8>(1) != HeaderRecordBatch || batch.isNull() || !valid) {
+            qDebug() << "Invalid Arrow record batch:" << fileName;
+            return false;
+        }
+        if (!batch.table(3).isNull()) {
+            qDebug() << "Compressed Arrow record batches are not supported:" << fileName;
+            return false;
+        }
+
+        const RecordBatchBody body(batch, data + offset + metadataLength, bodyLength);
+        for (int col = 0; col < fields.size(); ++col) {
+            if (!readColumn(fields[col], body, nodeIndex[col], bufferIndex[col], worksheet, rowBase, col)) {
+                qDebug() << "Invalid Arrow column data:" << fileName << "column" << col;
+                return false;
+            }
+        }
+        rowBase += batch.scalar<qint64>(0);
+
+        if (progress && !progress(i + 1, blockCount)) {
+            return false;
+        }
+    }
+    return valid;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <QString>
+
+#include "Worksheet.h"
+#include "FileManager.h"
+
+// Apache Arrow IPC文件格式（.arrow）的导出与导入，不依赖Arrow库：元数据（flatbuffer）在本文件中直接读写
+//
+//   文件   "ARROW1" | 模式消息 | 记录批次消息... | 结束标记 | 文件尾（模式与各批次位置） | 文件尾长度 | "ARROW1"
+//   消息   0xFFFFFFFF | 元数据长度 | Message元数据（8字节对齐） | 消息体（各缓冲区，8字节对齐）
+//
+// 导出：工作表的每一列（A、B、C...，到实际使用范围为止）为一个字段，按列中的值确定类型——
+//       布尔 -> Bool，整数 -> Int64，含小数 -> Float64，日期 -> Date32，日期时间 -> Timestamp(ms, UTC)，
+//       全空 -> Null，其余（文本或类型混合）-> Utf8；空单元格为null（有效位图中的0）。
+//       有公式的单元格导出当前值。每个记录批次约TargetCells个单元格，内存占用与工作表大小无关
+// 导入：支持各种宽度的整数、半/单/双精度浮点、布尔、Utf8/LargeUtf8、日期与时间戳列，第i个字段写入第i列；
+//       嵌套、字典编码、二进制等其他类型的列被跳过，压缩的记录批次不支持
+class ArrowFormat
+{
+public:
+    static constexpr int BatchRows = 65536; // 每个记录批次的最大行数
+    static constexpr int TargetCells = 1 << 20; // 列很多时减少每批行数，使每批约含这么多单元格
+
+    // 进度以记录批次为单位；失败或中止时原文件不变
+    static bool exportWorksheet(const Worksheet *worksheet, const QString &fileName,
+                                const FileManager::ProgressCallback &progress = FileManager::ProgressCallback());
+    // 导入到worksheet的对应位置（第一条记录为第0行），进度以记录批次为单位
+    static bool importWorksheet(Worksheet *worksheet, const QString &fileName,
+                                const FileManager::ProgressCallback &progress = FileManager::ProgressCallback());
+};
@@ -0,0 +1,195 @@
+#include "AutoFilter.h"
+#include "Cell.h"
+
+#include <QHash>
+#include <QtAlgorithms>
+#include <cmath>
+
+namespace {
+
+// 逐个求值pass(i)，每64行合成一个字：循环内没有分支，编译器可以向量化
+template <typename Pass>
+std::vector<quint64> scan(int count, Pass pass)
+{
+    std::vector<quint64> bits((count + 63) / 64, 0);
+    for (int word = 0; word < int(bits.size()); ++word) {
+        const int begin = word * 64;
+        const int end = qMin(begin + 64, count);
+        quint64 value = 0;
+        for (int i = begin; i < end; ++i) {
+            value |= quint64(pass(i)) << (i - begin);
+        }
+        bits[word] = value;
+    }
+    return bits;
+}
+
+double numberOf(const Cell *cell)
+{
+    if (!cell) {
+        return std::nan("");
+    }
+    const QVariant value = cell->value();
+    switch (value.typeId()) {
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::LongLong:
+    case QMetaType::ULongLong:
+    case QMetaType::Double:
+    case QMetaType::Float:
+        return value.toDouble();
+    case QMetaType::QString: {
+        bool ok = false;
+        const double number = value.toString().toDouble(&ok); // CSV导入的数字以文本保存
+        return ok ? number : std::nan("");
+    }
+    default:
+        return std::nan("");
+    }
+}
+
+} // namespace
+
+AutoFilter::AutoFilter(const Worksheet *worksheet, int headerRow, int lastRow)
+    : m_worksheet(worksheet)
+    , m_headerRow(headerRow)
+    , m_lastRow(qMax(lastRow, headerRow))
+{}
+
+AutoFilter::Criterion AutoFilter::criterion(int column) const
+{
+    return m_columns.value(column).criterion;
+}
+
+void AutoFilter::setCriterion(int column, const Criterion &criterion)
+{
+    if (criterion.type == Criterion::None) {
+        m_columns.remove(column);
+        return;
+    }
+    ColumnFilter &filter = m_columns[column];
+    filter.criterion = criterion;
+    evaluate(column, filter);
+}
+
+QStringList AutoFilter::distinctValues(int column)
+{
+    QStringList values = columnData(column).dictionary;
+    values.sort(Qt::CaseInsensitive);
+    if (values.size() > MaxListedValues) {
+        values.resize(MaxListedValues);
+    }
+    return values;
+}
+
+void AutoFilter::invalidateColumn(int column)
+{
+    m_data.remove(column);
+    auto it = m_columns.find(column);
+    if (it != m_columns.end()) {
+        it->stale = true;
+    }
+}
+
+void AutoFilter::invalidate()
+{
+    // 创建后追加的行（如继续导入、在末尾输入）也参与筛选
+    const QMap<int, Worksheet::Row> &rows = m_worksheet->rows();
+    m_lastRow = rows.isEmpty() ? m_headerRow : qMax(rows.lastKey(), m_headerRow);
+    m_data.clear();
+    for (ColumnFilter &filter : m_columns) {
+        filter.stale = true;
+    }
+}
+
+std::vector<int> AutoFilter::visibleRows()
+{
+    const int count = rowCount();
+    std::vector<quint64> combined((count + 63) / 64, ~quint64(0));
+    for (auto it = m_columns.begin(); it != m_columns.end(); ++it) {
+        if (it->stale) {
+            evaluate(it.key(), it.value());
+        }
+        const std::vector<quint64> &bits = it->bits;
+        for (size_t word = 0; word < combined.size(); ++word) {
+            combined[word] &= bits[word];
+        }
+    }
+
+    std::vector<int> rows;
+    for (size_t word = 0; word < combined.size(); ++word) {
+        quint64 value = combined[word];
+        while (value) {
+            const int bit = qCountTrailingZeroBits(value);
+            const int index = int(word) * 64 + bit;
+            if (index < count) {
+                rows.push_back(m_headerRow + 1 + index);
+            }
+            value &= value - 1;
+        }
+    }
+    return rows;
+}
+
+// 一次遍历范围内的行：数值数组与文本编号，空白单元格（含不存在的行）的文本为空字符串
+const AutoFilter::ColumnData &AutoFilter::columnData(int column)
+{
+    auto it = m_data.constFind(column);
+    if (it != m_data.constEnd()) {
+        return *it.value();
+    }
+
+    auto data = std::make_shared<ColumnData>();
+    const int count = rowCount();
+    data->numbers.assign(count, std::nan(""));
+    data->dictionary.append(QString());
+    data->ids.assign(count, 0);
+
+    QHash<QString, int> ids;
+    ids.insert(QString(), 0);
+    const QMap<int, Worksheet::Row> &rows = m_worksheet->rows();
+    for (auto rowIt = rows.lowerBound(m_headerRow + 1); rowIt != rows.constEnd() && rowIt.key() <= m_lastRow; ++rowIt) {
+        const Cell *cell = rowIt->value(column).get();
+        if (!cell) {
+            continue;
+        }
+        const int index = rowIt.key() - m_headerRow - 1;
+        data->numbers[index] = numberOf(cell);
+
+        const QString text = cell->displayText();
+        auto idIt = ids.constFind(text);
+        if (idIt == ids.constEnd()) {
+            idIt = ids.insert(text, int(data->dictionary.size()));
+            data->dictionary.append(text);
+        }
+        data->ids[index] = idIt.value();
+    }
+    return *m_data.insert(column, data).value();
+}
+
+void AutoFilter::evaluate(int column, ColumnFilter &filter)
+{
+    const ColumnData &data = columnData(column);
+    const Criterion &criterion = filter.criterion;
+    const int count = rowCount();
+
+    if (criterion.type == Criterion::NumberRange) {
+        const double *numbers = data.numbers.data();
+        const double minimum = criterion.minimum;
+        const double maximum = criterion.maximum;
+        filter.bits = scan(count, [=](int i) { return numbers[i] >= minimum && numbers[i] <= maximum; }); // NaN不满足
+    }
+    else {
+        // 先对每个不同的文本求值，扫描时按编号查表
+        std::vector<quint8> allowed(data.dictionary.size());
+        for (int id = 0; id < data.dictionary.size(); ++id) {
+            const QString &text = data.dictionary.at(id);
+            allowed[id] = criterion.type == Criterion::Values ? criterion.values.contains(text)
+                                                               : text.contains(criterion.text, Qt::CaseInsensitive);
+        }
+        const int *ids = data.ids.data();
+        const quint8 *table = allowed.data();
+        filter.bits = scan(count, [=](int i) { return table[ids[i]] != 0; });
+    }
+    filter.stale = false;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QMap>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "Worksheet.h"
+
+// 自动筛选：标题行之下到lastRow的数据行按各列的条件筛选，结果为各列位图的AND。
+// 设置条件的列先读取一次快照（每行一个数值与一个文本编号），条件在快照上按位扫描：
+// 数值范围直接比较数值数组，值列表与文本包含先在去重后的文本上求值，再按编号查表。
+// 修改一列的条件只重新计算该列的位图；单元格改变时该列的快照与位图在下次计算时重建
+class AutoFilter
+{
+public:
+    static constexpr int MaxListedValues = 10000; // 值列表中列出的不同值个数上限
+
+    struct Criterion {
+        enum Type {
+            None,
+            Values, // 显示文本在values中（空字符串表示空白单元格）
+            NumberRange, // 数值在[minimum, maximum]内，非数字的行不显示
+            TextContains // 显示文本包含text（不区分大小写）
+        };
+        Type type = None;
+        QSet<QString> values;
+        double minimum = -std::numeric_limits<double>::infinity();
+        double maximum = std::numeric_limits<double>::infinity();
+        QString text;
+    };
+
+    AutoFilter(const Worksheet *worksheet, int headerRow, int lastRow);
+
+    int headerRow() const { return m_headerRow; }
+    int lastRow() const { return m_lastRow; }
+    bool isActive() const { return !m_columns.isEmpty(); } // 有任一列设置了条件
+
+    Criterion criterion(int column) const;
+    void setCriterion(int column, const Criterion &criterion); // 类型为None时清除该列的条件
+    QStringList distinctValues(int column); // 该列数据行的不同显示文本（排序后，最多MaxListedValues个）
+
+    void invalidateColumn(int column); // 该列单元格改变
+    void invalidate(); // 行被移动（排序）或追加等，所有列过期，数据行延伸到工作表当前的最后一行
+
+    // 通过筛选的数据行（升序的行号），过期的列在此重建
+    std::vector<int> visibleRows();
+
+private:
+    // 列快照：按数据行顺序存放
+    struct ColumnData {
+        std::vector<double> numbers; // 非数字为NaN
+        std::vector<int> ids; // 显示文本在dictionary中的编号
+        QStringList dictionary;
+    };
+    struct ColumnFilter {
+        Criterion criterion;
+        std::vector<quint64> bits; // 第i位对应第headerRow + 1 + i行
+        bool stale = true;
+    };
+
+    int rowCount() const { return m_lastRow - m_headerRow; }
+    const ColumnData &columnData(int column); // 需要时读取快照
+    void evaluate(int column, ColumnFilter &filter);
+
+    const Worksheet *m_worksheet;
+    int m_headerRow;
+    int m_lastRow;
+    QMap<int, ColumnFilter> m_columns; // 设置了条件的列
+    QMap<int, std::shared_ptr<ColumnData>> m_data; // 列快照，过期时移除
+};
@@ -19,6 +19,7 @@ public:
     void setFormula(const QString &formula);
 
     QString displayText() const; // 显示文本接口
+    bool isEmpty() const { return m_value.isNull() && m_formula.isEmpty(); } // 既无值也无公式
 
     // 行列坐标接口
     int row() const { return m_row; }
@@ -33,6 +34,11 @@ signals:
     void formulaChanged();
 
 private:
+    friend class Worksheet; // 单元格被工作表放置或移动（如排序）时由工作表更新坐标
+    void setPosition(int row, int col) { m_row = row; m_col = col; }
+    // 粘贴时直接设置已求值的内容（值与公式共享源数据），不重新求值也不发送信号
+    void setContents(const QVariant &value, const QString &formula) { m_value = value; m_formula = formula; }
+
     QVariant m_value;
     QString m_formula; // 原始公式
     int m_row;
@@ -0,0 +1,79 @@
+#include "CellBlock.h"
+#include "CsvTokenizer.h"
+#include "CsvWriter.h"
+
+CellBlock::CellBlock(int rowCount, int columnCount, std::vector<Entry> entries)
+    : m_data(std::make_shared<const Data>(Data{rowCount, columnCount, std::move(entries)}))
+{}
+
+const std::vector<CellBlock::Entry> &CellBlock::entries() const
+{
+    static const std::vector<Entry> empty;
+    return m_data ? m_data->entries : empty;
+}
+
+QByteArray CellBlock::toTsv() const
+{
+    QByteArray out;
+    int row = 0;
+    int col = 0;
+    for (const Entry &entry : entries()) {
+        for (; row < entry.row; ++row, col = 0) {
+            out += '\n';
+        }
+        for (; col < entry.column; ++col) {
+            out += '\t';
+        }
+        CsvWriter::appendValue(out, entry.formula.isEmpty() ? entry.value : QVariant(entry.formula), '\t');
+    }
+    for (; row < rowCount(); ++row) {
+        out += '\n';
+    }
+    return out;
+}
+
+QByteArray CellBlock::toHtml() const
+{
+    QByteArray out = "<html><head><meta charset=\"utf-8\"></head><body><table>\n";
+    auto it = entries().cbegin();
+    const auto end = entries().cend();
+    for (int row = 0; row < rowCount(); ++row) {
+        out += "<tr>";
+        int col = 0;
+        for (; it != end && it->row == row; ++it, ++col) {
+            for (; col < it->column; ++col) {
+                out += "<td></td>";
+            }
+            out += "<td>";
+            out += (it->formula.isEmpty() ? it->value.toString() : it->formula).toHtmlEscaped().toUtf8();
+            out += "</td>";
+        }
+        for (; col < columnCount(); ++col) {
+            out += "<td></td>";
+        }
+        out += "</tr>\n";
+    }
+    out += "</table></body></html>\n";
+    return out;
+}
+
+CellBlock CellBlock::fromTsv(const QByteArray &text)
+{
+    std::vector<Entry> entries;
+    int columns = 0;
+    CsvTokenizer tokenizer(CsvTokenizer::tsvDialect());
+    tokenizer.tokenize(text.constData(), text.size(), true, [&](int row, int col, const char *begin, qsizetype length) {
+        columns = qMax(columns, col + 1);
+        if (length == 0) {
+            return;
+        }
+        const QString field = CsvTokenizer::decodeField(begin, length);
+        if (field.startsWith('=')) {
+            entries.push_back(Entry{row, col, QVariant(), field});
+        }
+        else {
+            entries.push_back(Entry{row, col, field, QString()});
+        }
+    });
+    return CellBlock(tokenizer.rowsParsed(), columns, std::move(entries));
+}
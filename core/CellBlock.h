@@ -0,0 +1,44 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QVariant>
+#include <memory>
+#include <vector>
+
+// 矩形区域中单元格内容的快照（复制、剪切的数据），由Worksheet::copyCells生成、pasteCells写入。
+// 复制CellBlock对象只增加引用计数；值与公式是Qt的隐式共享类型，快照与源单元格、
+// 粘贴生成的单元格共享文本等数据，某一方修改时才单独复制，应用内复制粘贴不会使内容占用的内存加倍。
+// 与其他程序交换时按需转换为制表符分隔文本或HTML表格
+class CellBlock
+{
+public:
+    struct Entry { // 坐标相对区域左上角，按行、列有序
+        int row;
+        int column;
+        QVariant value;
+        QString formula;
+    };
+
+    CellBlock() = default;
+    CellBlock(int rowCount, int columnCount, std::vector<Entry> entries);
+
+    bool isNull() const { return !m_data; }
+    int rowCount() const { return m_data ? m_data->rows : 0; }
+    int columnCount() const { return m_data ? m_data->columns : 0; }
+    const std::vector<Entry> &entries() const;
+
+    // 其他程序使用的格式：有公式的单元格输出公式，行末只输出到该行最后一个单元格
+    QByteArray toTsv() const;
+    QByteArray toHtml() const;
+    // 解析其他程序复制的制表符分隔文本，字段作为文本值，以“=”开头的作为公式
+    static CellBlock fromTsv(const QByteArray &text);
+
+private:
+    struct Data {
+        int rows;
+        int columns;
+        std::vector<Entry> entries;
+    };
+    std::shared_ptr<const Data> m_data;
+};
@@ -0,0 +1,360 @@
+#include "ColumnCodec.h"
+
+#include <QHash>
+#include <QList>
+#include <QtEndian>
+#include <QtAlgorithms> // qCountLeadingZeroBits
+
+namespace {
+
+// 读取一个元素：4字节及以下按无符号数，8字节按有符号数
+qint64 readElement(const char *data, int width)
+{
+    switch (width) {
+    case 1: return quint8(*data);
+    case 2: return qFromLittleEndian<quint16>(data);
+    case 4: return qFromLittleEndian<quint32>(data);
+    default: return qFromLittleEndian<qint64>(data);
+    }
+}
+
+void appendElement(QByteArray &out, qint64 value, int width)
+{
+    char bytes[8];
+    qToLittleEndian<qint64>(value, bytes);
+    out.append(bytes, width); // 小端序下低位字节在前，截取即可
+}
+
+void appendVarint(QByteArray &out, quint64 value)
+{
+    while (value >= 0x80) {
+        out += char(quint8(value) | 0x80);
+        value >>= 7;
+    }
+    out += char(value);
+}
+
+bool readVarint(const char *&pos, const char *end, quint64 *value)
+{
+    quint64 result = 0;
+    for (int shift = 0; shift < 64 && pos < end; shift += 7) {
+        const quint8 byte = quint8(*pos++);
+        result |= quint64(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+quint64 zigzag(qint64 value) { return (quint64(value) << 1) ^ quint64(value >> 63); }
+qint64 unzigzag(quint64 value) { return qint64(value >> 1) ^ -qint64(value & 1); }
+
+int bitsNeeded(quint64 value) { return value ? 64 - qCountLeadingZeroBits(value) : 0; }
+
+// 按位紧凑写入，低位在前
+class BitWriter
+{
+public:
+    explicit BitWriter(QByteArray &out) : m_out(out), m_current(0), m_used(0) {}
+
+    void write(quint64 value, int width)
+    {
+        while (width > 0) {
+            const int take = qMin(8 - m_used, width);
+            m_current |= quint8((value & ((1u << take) - 1)) << m_used);
+            value >>= take;
+            width -= take;
+            m_used += take;
+            if (m_used == 8) {
+                m_out += char(m_current);
+                m_current = 0;
+                m_used = 0;
+            }
+        }
+    }
+
+    void finish()
+    {
+        if (m_used > 0) {
+            m_out += char(m_current);
+        }
+    }
+
+private:
+    QByteArray &m_out;
+    quint8 m_current;
+    int m_used;
+};
+
+class BitReader
+{
+public:
+    BitReader(const char *data, const char *end) : m_pos(data), m_end(end), m_used(0) {}
+
+    bool read(int width, quint64 *value)
+    {
+        quint64 result = 0;
+        int shift = 0;
+        while (shift < width) {
+            if (m_pos >= m_end) {
+                return false;
+            }
+            const int take = qMin(8 - m_used, width - shift);
+            const quint64 bits = (quint8(*m_pos) >> m_used) & ((1u << take) - 1);
+            result |= bits << shift;
+            shift += take;
+            m_used += take;
+            if (m_used == 8) {
+                ++m_pos;
+                m_used = 0;
+            }
+        }
+        *value = result;
+        return true;
+    }
+
+private:
+    const char *m_pos;
+    const char *m_end;
+    int m_used;
+};
+
+// 游程：(游程长度, 值)序列
+QByteArray encodeRunLength(const QByteArray &raw, int width, qsizetype count)
+{
+    QByteArray out;
+    qsizetype i = 0;
+    while (i < count) {
+        const qint64 value = readElement(raw.constData() + i * width, width);
+        qsizetype run = 1;
+        while (i + run < count && readElement(raw.constData() + (i + run) * width, width) == value) {
+            ++run;
+        }
+        appendVarint(out, quint64(run));
+        appendElement(out, value, width);
+        i += run;
+        if (out.size() >= raw.size()) { // 没有收益，提前放弃
+            return QByteArray();
+        }
+    }
+    return out;
+}
+
+// 增量：首值与相邻差值均以zigzag变长整数保存
+QByteArray encodeDelta(const QByteArray &raw, int width, qsizetype count)
+{
+    QByteArray out;
+    qint64 previous = 0;
+    for (qsizetype i = 0; i < count; ++i) {
+        const qint64 value = readElement(raw.constData() + i * width, width);
+        appendVarint(out, zigzag(qint64(quint64(value) - quint64(previous))));
+        previous = value;
+        if (out.size() >= raw.size()) {
+            return QByteArray();
+        }
+    }
+    return out;
+}
+
+// 帧参考：最小值 | 位宽 | 按位压缩的(值 - 最小值)
+QByteArray encodeFrameOfReference(const QByteArray &raw, int width, qsizetype count)
+{
+    qint64 minValue = readElement(raw.constData(), width);
+    qint64 maxValue = minValue;
+    for (qsizetype i = 1; i < count; ++i) {
+        const qint64 value = readElement(raw.constData() + i * width, width);
+        minValue = qMin(minValue, value);
+        maxValue = qMax(maxValue, value);
+    }
+
+    const int bits = bitsNeeded(quint64(maxValue) - quint64(minValue));
+    if (bits >= width * 8) {
+        return QByteArray();
+    }
+
+    QByteArray out;
+    appendElement(out, minValue, 8);
+    out += char(bits);
+    BitWriter writer(out);
+    for (qsizetype i = 0; i < count; ++i) {
+        writer.write(quint64(readElement(raw.constData() + i * width, width)) - quint64(minValue), bits);
+    }
+    writer.finish();
+    return out;
+}
+
+// 字典：字典大小 | 字典值 | 位宽 | 按位压缩的字典下标
+QByteArray encodeDictionary(const QByteArray &raw, int width, qsizetype count)
+{
+    QHash<qint64, quint32> codes;
+    QList<qint64> values;
+    QList<quint32> indices;
+    indices.reserve(count);
+
+    for (qsizetype i = 0; i < count; ++i) {
+        const qint64 value = readElement(raw.constData() + i * width, width);
+        auto it = codes.constFind(value);
+        if (it == codes.constEnd()) {
+            if (values.size() > count / 2) { // 基数过高，字典没有收益
+                return QByteArray();
+            }
+            it = codes.insert(value, quint32(values.size()));
+            values.append(value);
+        }
+        indices.append(it.value());
+    }
+
+    QByteArray out;
+    appendVarint(out, quint64(values.size()));
+    for (qint64 value : values) {
+        appendElement(out, value, width);
+    }
+    const int bits = bitsNeeded(quint64(values.size() - 1));
+    out += char(bits);
+    BitWriter writer(out);
+    for (quint32 index : indices) {
+        writer.write(index, bits);
+    }
+    writer.finish();
+    return out;
+}
+
+} // namespace
+
+QByteArray ColumnCodec::encode(const QByteArray &raw, int width, Encoding *encoding)
+{
+    *encoding = Plain;
+    const qsizetype count = width > 0 ? raw.size() / width : 0;
+    if (count < 2) {
+        return raw;
+    }
+
+    QByteArray best = raw;
+    auto consider = [&](QByteArray candidate, Encoding candidateEncoding) {
+        if (!candidate.isEmpty() && candidate.size() < best.size()) {
+            best = candidate;
+            *encoding = candidateEncoding;
+        }
+    };
+
+    consider(encodeRunLength(raw, width, count), RunLength);
+    if (width > 1) {
+        consider(encodeDelta(raw, width, count), Delta);
+        consider(encodeFrameOfReference(raw, width, count), FrameOfReference);
+    }
+    consider(encodeDictionary(raw, width, count), Dictionary);
+
+    // 轻量编码压缩率不足原大小的3/4时，尝试zlib
+    if (best.size() * 4 > raw.size() * 3) {
+        consider(qCompress(raw), Zlib);
+    }
+
+    return best;
+}
+
+bool ColumnCodec::decode(quint8 encoding, const char *data, qsizetype size,
+                         int width, qsizetype count, QByteArray *raw)
+{
+    // 宽度为0（如全空的列）时写出的只能是空的未编码流；其余情况视为损坏，避免按宽度计算时除以0
+    if (width <= 0) {
+        raw->clear();
+        return width == 0 && encoding == Plain && size == 0;
+    }
+
+    const char *pos = data;
+    const char *end = data + size;
+    const qsizetype expectedSize = count * width;
+
+    if (encoding == Plain) {
+        if (size != expectedSize) {
+            return false;
+        }
+        *raw = QByteArray::fromRawData(data, size);
+        return true;
+    }
+
+    if (encoding == Zlib) {
+        *raw = qUncompress(reinterpret_cast<const uchar *>(data), size);
+        return raw->size() == expectedSize;
+    }
+
+    raw->clear();
+    raw->reserve(expectedSize);
+
+    switch (encoding) {
+    case RunLength:
+        while (raw->size() < expectedSize) {
+            quint64 run;
+            if (!readVarint(pos, end, &run) || end - pos < width
+                || run > quint64(expectedSize - raw->size()) / quint64(width)) {
+                return false;
+            }
+            const qint64 value = readElement(pos, width);
+            pos += width;
+            for (quint64 i = 0; i < run; ++i) {
+                appendElement(*raw, value, width);
+            }
+        }
+        break;
+    case Delta: {
+        quint64 value = 0;
+        for (qsizetype i = 0; i < count; ++i) {
+            quint64 delta;
+            if (!readVarint(pos, end, &delta)) {
+                return false;
+            }
+            value += quint64(unzigzag(delta));
+            appendElement(*raw, qint64(value), width);
+        }
+        break;
+    }
+    case FrameOfReference: {
+        if (end - pos < 9) {
+            return false;
+        }
+        const quint64 minValue = quint64(readElement(pos, 8));
+        const int bits = quint8(pos[8]);
+        BitReader reader(pos + 9, end);
+        for (qsizetype i = 0; i < count; ++i) {
+            quint64 offset;
+            if (bits > 64 || !reader.read(bits, &offset)) {
+                return false;
+            }
+            appendElement(*raw, qint64(minValue + offset), width);
+        }
+        break;
+    }
+    case Dictionary: {
+        quint64 dictionarySize;
+        if (!readVarint(pos, end, &dictionarySize)
+            || dictionarySize > quint64(end - pos) / quint64(width)) {
+            return false;
+        }
+        QList<qint64> values;
+        values.reserve(qsizetype(dictionarySize));
+        for (quint64 i = 0; i < dictionarySize; ++i) {
+            values.append(readElement(pos, width));
+            pos += width;
+        }
+        if (pos >= end) {
+            return false;
+        }
+        const int bits = quint8(*pos++);
+        BitReader reader(pos, end);
+        for (qsizetype i = 0; i < count; ++i) {
+            quint64 index;
+            if (bits > 32 || !reader.read(bits, &index) || index >= dictionarySize) {
+                return false;
+            }
+            appendElement(*raw, values.at(qsizetype(index)), width);
+        }
+        break;
+    }
+    default:
+        return false;
+    }
+
+    return raw->size() == expectedSize;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <QByteArray>
+
+// 列数据流的轻量编码：数据流为宽度相同（1/4/8字节，小端序）的定长元素序列，
+// 保存时逐个尝试各编码并选用最小的结果
+class ColumnCodec
+{
+public:
+    enum Encoding : quint8 {
+        Plain = 0,            // 原样保存
+        RunLength = 1,        // 游程：重复值
+        Delta = 2,            // 增量：有序整数、行号、日期
+        FrameOfReference = 3, // 帧参考：值域较窄的整数，按最小值偏移位压缩
+        Dictionary = 4,       // 字典：低基数的值（如重复的字符串）
+        Zlib = 5              // qCompress兜底
+    };
+
+    // 编码raw（元素宽度为width），encoding返回选用的编码方式
+    static QByteArray encode(const QByteArray &raw, int width, Encoding *encoding);
+
+    // 解码为count个宽度为width的元素；Plain编码直接引用data，不拷贝
+    static bool decode(quint8 encoding, const char *data, qsizetype size,
+                       int width, qsizetype count, QByteArray *raw);
+};
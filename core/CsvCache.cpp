@@ -0,0 +1,85 @@
+#include "CsvCache.h"
+#include "SspFormat.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDataStream>
+
+namespace {
+
+const quint32 KeyVersion = 3; // 校验键格式或CSV解析规则变化时递增，使旧缓存失效
+const qint64 ReadSize = 1024 * 1024; // 计算哈希时每次读取的字节数
+
+} // namespace
+
+QString CsvCache::cacheFileName(const QString &csvFileName)
+{
+    return csvFileName + ".sspcache";
+}
+
+QByteArray CsvCache::fileInfoKey(const QString &csvFileName, const CsvTokenizer::Dialect &dialect)
+{
+    const QFileInfo info(csvFileName);
+    if (!info.isFile()) {
+        return QByteArray();
+    }
+
+    QByteArray key;
+    QDataStream out(&key, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << KeyVersion << info.absoluteFilePath() << info.size()
+        << info.lastModified().toMSecsSinceEpoch()
+        << qint8(dialect.delimiter) << qint8(dialect.quote);
+    return key;
+}
+
+// 内容哈希放在最后，定长，占位键与最终的键长度相同
+QByteArray CsvCache::sourceKey(const QByteArray &fileInfoKey, const QByteArray &contentHash)
+{
+    if (fileInfoKey.isEmpty()) {
+        return QByteArray();
+    }
+    const int hashLength = QCryptographicHash::hashLength(HashAlgorithm);
+    return fileInfoKey + (contentHash.size() == hashLength ? contentHash : QByteArray(hashLength, '\0'));
+}
+
+// 保留修改时间的原地改写（cp -p、rsync -t、解压等）大小与时间都不变，只有内容能识别
+QByteArray CsvCache::contentHash(const QString &csvFileName, const FileManager::ProgressCallback &progress)
+{
+    QFile file(csvFileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    const qint64 size = file.size();
+
+    QCryptographicHash hash(HashAlgorithm);
+    QByteArray buffer(ReadSize, Qt::Uninitialized);
+    qint64 total = 0;
+    while (total < size) {
+        const qint64 n = file.read(buffer.data(), ReadSize);
+        if (n <= 0) {
+            return QByteArray(); // 读取失败或文件在读取期间被截短
+        }
+        hash.addData(QByteArrayView(buffer.constData(), n));
+        total += n;
+        if (progress && !progress(total, size)) {
+            return QByteArray();
+        }
+    }
+    return hash.result();
+}
+
+bool CsvCache::matchesFileInfo(const QString &csvFileName, const QByteArray &fileInfoKey)
+{
+    if (fileInfoKey.isEmpty()) {
+        return false;
+    }
+    const QByteArray key = SspFormat::readUserData(cacheFileName(csvFileName));
+    return key.size() == sourceKey(fileInfoKey, QByteArray()).size() && key.startsWith(fileInfoKey);
+}
+
+bool CsvCache::isValid(const QString &csvFileName, const QByteArray &key)
+{
+    return !key.isEmpty() && SspFormat::readUserData(cacheFileName(csvFileName)) == key;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <QString>
+#include <QByteArray>
+#include <QCryptographicHash>
+
+#include "CsvTokenizer.h"
+#include "FileManager.h"
+
+// CSV解析结果的旁路缓存（<CSV文件名>.sspcache，格式同.ssp，每批读入的行为一个工作表）。
+// 缓存的文件头附加数据记录来源文件的校验键：文件信息（路径、大小、修改时间与方言）加整个文件的内容哈希。
+// 再次导入时先比较文件信息（不读取CSV），一致时再计算内容哈希核对；
+// 没有可用的缓存时，内容哈希在分词读取文件的同时计算，完成时写入新缓存，文件只读取一遍
+class CsvCache
+{
+public:
+    static constexpr QCryptographicHash::Algorithm HashAlgorithm = QCryptographicHash::Sha1;
+
+    static QString cacheFileName(const QString &csvFileName);
+
+    // 来源文件的文件信息部分，文件不存在时返回空
+    static QByteArray fileInfoKey(const QString &csvFileName, const CsvTokenizer::Dialect &dialect);
+    // 完整的校验键；contentHash为空时得到与之等长的占位键（写缓存时先占位，完成时替换）
+    static QByteArray sourceKey(const QByteArray &fileInfoKey, const QByteArray &contentHash);
+
+    // 顺序读取整个文件计算内容哈希，进度以字节为单位；失败或中止时返回空
+    static QByteArray contentHash(const QString &csvFileName,
+                                  const FileManager::ProgressCallback &progress = FileManager::ProgressCallback());
+
+    // 缓存存在且文件信息与fileInfoKey一致（尚未核对内容）
+    static bool matchesFileInfo(const QString &csvFileName, const QByteArray &fileInfoKey);
+    // 缓存存在且记录的校验键与key一致
+    static bool isValid(const QString &csvFileName, const QByteArray &key);
+};
@@ -0,0 +1,86 @@
+#include "CsvTokenizer.h"
+
+#include <QByteArray>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define CSV_TOKENIZER_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CSV_TOKENIZER_SSE2
+#endif
+
+CsvTokenizer::CsvTokenizer(const Dialect &dialect)
+    : m_dialect(dialect)
+    , m_row(0)
+{}
+
+CsvTokenizer::BlockMasks CsvTokenizer::classifyBlock(const char *block, const Dialect &dialect)
+{
+    BlockMasks masks{0, 0, 0};
+
+#if defined(CSV_TOKENIZER_AVX2)
+    // 每次比较32字节，两次覆盖整个块
+    const __m256i quote = _mm256_set1_epi8(dialect.quote);
+    const __m256i delimiter = _mm256_set1_epi8(dialect.delimiter);
+    const __m256i newline = _mm256_set1_epi8('\n');
+    for (int i = 0; i < 2; ++i) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + 32 * i));
+        const int shift = 32 * i;
+        masks.quote |= quint64(quint32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, quote)))) << shift;
+        masks.delimiter |= quint64(quint32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, delimiter)))) << shift;
+        masks.newline |= quint64(quint32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, newline)))) << shift;
+    }
+#elif defined(CSV_TOKENIZER_SSE2)
+    // 每次比较16字节，四次覆盖整个块
+    const __m128i quote = _mm_set1_epi8(dialect.quote);
+    const __m128i delimiter = _mm_set1_epi8(dialect.delimiter);
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (int i = 0; i < 4; ++i) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + 16 * i));
+        const int shift = 16 * i;
+        masks.quote |= quint64(quint16(_mm_movemask_epi8(_mm_cmpeq_epi8(v, quote)))) << shift;
+        masks.delimiter |= quint64(quint16(_mm_movemask_epi8(_mm_cmpeq_epi8(v, delimiter)))) << shift;
+        masks.newline |= quint64(quint16(_mm_movemask_epi8(_mm_cmpeq_epi8(v, newline)))) << shift;
+    }
+#else
+    // 无SIMD支持时逐字节比较
+    for (int i = 0; i < BlockSize; ++i) {
+        const quint64 bit = quint64(1) << i;
+        if (block[i] == dialect.quote) masks.quote |= bit;
+        else if (block[i] == dialect.delimiter) masks.delimiter |= bit;
+        else if (block[i] == '\n') masks.newline |= bit;
+    }
+#endif
+
+    return masks;
+}
+
+QString CsvTokenizer::decodeField(const char *begin, qsizetype length, char quote)
+{
+    // 快速路径：不含引号的字段直接按UTF-8解码
+    if (!std::memchr(begin, quote, size_t(length))) {
+        return QString::fromUtf8(begin, length);
+    }
+
+    // 与原逐字符解析规则一致：引号切换引号状态，引号内连续两个引号表示一个字面引号
+    QByteArray unescaped;
+    unescaped.reserve(length);
+    bool inQuotes = false;
+    for (qsizetype i = 0; i < length; ++i) {
+        const char c = begin[i];
+        if (c == quote) {
+            if (inQuotes && i + 1 < length && begin[i + 1] == quote) {
+                unescaped += quote;
+                ++i;
+            }
+            else {
+                inQuotes = !inQuotes;
+            }
+        }
+        else {
+            unescaped += c;
+        }
+    }
+    return QString::fromUtf8(unescaped);
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <QString>
+#include <QVarLengthArray>
+#include <QtAlgorithms> // qCountTrailingZeroBits
+#include <cstring>
+
+// 向量化CSV分词器：每次对64字节分类得到引号、分隔符、换行位掩码，
+// 通过前缀异或计算引号内区域，直接在UTF-8原始字节上定位字段边界
+class CsvTokenizer
+{
+public:
+    // 方言：分隔符与引号字符可配置（CSV/TSV）
+    struct Dialect {
+        char delimiter = ',';
+        char quote = '"';
+    };
+
+    static Dialect csvDialect() { return Dialect{',', '"'}; }
+    static Dialect tsvDialect() { return Dialect{'\t', '"'}; }
+
+    // 一个64字节块的分类结果，第i位对应块内第i个字节
+    struct BlockMasks {
+        quint64 quote;
+        quint64 delimiter;
+        quint64 newline;
+    };
+
+    static constexpr int BlockSize = 64;
+
+    explicit CsvTokenizer(const Dialect &dialect = csvDialect());
+
+    Dialect dialect() const { return m_dialect; }
+    int rowsParsed() const { return m_row; } // 已完整输出的行数
+    void reset() { m_row = 0; }
+
+    // 扫描data，逐字段回调 handler(row, col, begin, length)，字段为未解码的原始字节
+    // atEnd为false时只输出完整的行，返回已消费的字节数（末尾不完整的行由调用方拼接到下一块再处理）
+    template <typename Handler>
+    qsizetype tokenize(const char *data, qsizetype size, bool atEnd, Handler &&handler);
+
+    // 字段解码：去掉引号并还原转义的双引号，此时才转换为QString
+    static QString decodeField(const char *begin, qsizetype length, char quote = '"');
+
+    // 块分类（SSE2/AVX2，不支持时退化为逐字节比较），block需可读64字节
+    static BlockMasks classifyBlock(const char *block, const Dialect &dialect);
+
+    // 前缀异或：结果第i位为bits第0..i位的异或，即该字节是否处于引号内
+    static quint64 prefixXor(quint64 bits)
+    {
+        bits ^= bits << 1;
+        bits ^= bits << 2;
+        bits ^= bits << 4;
+        bits ^= bits << 8;
+        bits ^= bits << 16;
+        bits ^= bits << 32;
+        return bits;
+    }
+
+private:
+    struct FieldRef { // 当前行中尚未输出的字段
+        qsizetype begin;
+        qsizetype length;
+    };
+
+    Dialect m_dialect;
+    int m_row; // 下一行的行号
+};
+
+template <typename Handler>
+qsizetype CsvTokenizer::tokenize(const char *data, qsizetype size, bool atEnd, Handler &&handler)
+{
+    QVarLengthArray<FieldRef, 64> pendingFields; // 缓存当前行的字段，行结束时统一输出
+    qsizetype fieldStart = 0;
+    qsizetype consumed = 0; // 最后一个完整行之后的位置
+    quint64 quoteCarry = 0; // 上一块结束时是否仍在引号内（全1或全0）
+
+    // atLineEnd：字段由换行或输入结束终止，此时去掉CRLF中的'\r'；由分隔符终止的字段保留'\r'
+    auto closeField = [&](qsizetype end, bool atLineEnd) {
+        qsizetype length = end - fieldStart;
+        if (atLineEnd && length > 0 && data[end - 1] == '\r') { // 兼容CRLF换行
+            --length;
+        }
+        pendingFields.append(FieldRef{fieldStart, length});
+    };
+
+    auto flushRow = [&]() {
+        for (int col = 0; col < pendingFields.size(); ++col) {
+            handler(m_row, col, data + pendingFields[col].begin, pendingFields[col].length);
+        }
+        pendingFields.clear();
+        ++m_row;
+    };
+
+    for (qsizetype base = 0; base < size; base += BlockSize) {
+        BlockMasks masks;
+        if (size - base >= BlockSize) {
+            masks = classifyBlock(data + base, m_dialect);
+        }
+        else { // 尾部不足64字节，补零后分类
+            char tail[BlockSize];
+            std::memset(tail, 0, sizeof(tail));
+            std::memcpy(tail, data + base, size_t(size - base));
+            masks = classifyBlock(tail, m_dialect);
+            const quint64 valid = (quint64(1) << (size - base)) - 1;
+            masks.quote &= valid;
+            masks.delimiter &= valid;
+            masks.newline &= valid;
+        }
+
+        const quint64 inQuotes = prefixXor(masks.quote) ^ quoteCarry;
+        quoteCarry = quint64(qint64(inQuotes) >> 63); // 最高位扩展为跨块状态
+
+        quint64 structural = (masks.delimiter | masks.newline) & ~inQuotes;
+        while (structural) {
+            const int bit = qCountTrailingZeroBits(structural);
+            const qsizetype pos = base + bit;
+            const bool newline = masks.newline & (quint64(1) << bit);
+            closeField(pos, newline);
+            if (newline) {
+                flushRow();
+                consumed = pos + 1;
+            }
+            fieldStart = pos + 1;
+            structural &= structural - 1; // 清除最低位
+        }
+    }
+
+    if (!atEnd) {
+        return consumed;
+    }
+
+    // 最后一行没有换行符结尾
+    if (fieldStart < size || !pendingFields.isEmpty()) {
+        closeField(size, true);
+        flushRow();
+    }
+    return size;
+}
@@ -0,0 +1,150 @@
+#include "CsvWriter.h"
+#include "Cell.h"
+
+#include <charconv> // std::to_chars：最短往返浮点格式化
+
+CsvWriter::CsvWriter(QIODevice *device, char delimiter, qsizetype bufferSize)
+    : m_device(device)
+    , m_bufferSize(bufferSize)
+    , m_bytesWritten(0)
+    , m_delimiter(delimiter)
+    , m_error(false)
+{
+    m_buffer.reserve(bufferSize);
+}
+
+CsvWriter::~CsvWriter()
+{
+    flush();
+}
+
+void CsvWriter::writeRow(const Worksheet::Row &row, int columnCount)
+{
+    if (m_error) {
+        return; // 写入失败后不再积累数据
+    }
+    appendRow(m_buffer, row, columnCount, m_delimiter);
+    flushIfFull();
+}
+
+void CsvWriter::writeEmptyRow(int columnCount)
+{
+    if (m_error) {
+        return;
+    }
+    appendEmptyRow(m_buffer, columnCount, m_delimiter);
+    flushIfFull();
+}
+
+void CsvWriter::writeRaw(const QByteArray &data)
+{
+    if (m_error) {
+        return;
+    }
+    if (m_buffer.size() + data.size() > m_bufferSize && !flush()) {
+        return;
+    }
+    if (data.size() >= m_bufferSize) { // 大块数据直接写入，避免额外拷贝
+        if (m_device->write(data) != data.size()) {
+            m_error = true;
+        }
+        m_bytesWritten += data.size();
+        return;
+    }
+    m_buffer.append(data);
+}
+
+bool CsvWriter::flush()
+{
+    if (!m_buffer.isEmpty() && !m_error) {
+        if (m_device->write(m_buffer) != m_buffer.size()) {
+            m_error = true;
+        }
+        m_bytesWritten += m_buffer.size();
+    }
+    m_buffer.resize(0); // 保留已分配的容量；出错时丢弃的数据不再写出
+    return !m_error;
+}
+
+void CsvWriter::flushIfFull()
+{
+    if (m_buffer.size() >= m_bufferSize) {
+        flush();
+    }
+}
+
+void CsvWriter::appendRow(QByteArray &out, const Worksheet::Row &row, int columnCount, char delimiter)
+{
+    // 只遍历已分配的单元格，列间空缺补分隔符
+    int col = 0;
+    for (auto it = row.constBegin(); it != row.constEnd() && it.key() < columnCount; ++it) {
+        for (; col < it.key(); ++col) {
+            if (col > 0) out += delimiter;
+        }
+        if (col > 0) out += delimiter;
+        if (it.value()) {
+            appendValue(out, it.value()->value(), delimiter);
+        }
+        ++col;
+    }
+    for (; col < columnCount; ++col) {
+        if (col > 0) out += delimiter;
+    }
+    out += '\n';
+}
+
+void CsvWriter::appendEmptyRow(QByteArray &out, int columnCount, char delimiter)
+{
+    for (int col = 1; col < columnCount; ++col) {
+        out += delimiter;
+    }
+    out += '\n';
+}
+
+void CsvWriter::appendValue(QByteArray &out, const QVariant &value, char delimiter)
+{
+    switch (value.typeId()) {
+    case QMetaType::UnknownType: // 空值
+        return;
+    case QMetaType::Double:
+    case QMetaType::Float:
+        appendNumber(out, value.toDouble());
+        return;
+    case QMetaType::Int:
+    case QMetaType::LongLong:
+        out += QByteArray::number(value.toLongLong());
+        return;
+    case QMetaType::UInt:
+    case QMetaType::ULongLong:
+        out += QByteArray::number(value.toULongLong());
+        return;
+    default:
+        break;
+    }
+
+    QByteArray text = value.toString().toUtf8();
+    // CSV格式：如果单元格内容包含分隔符、引号或换行，需要用双引号整个包围
+    bool needsQuotes = false;
+    for (char c : text) {
+        if (c == delimiter || c == '"' || c == '\n' || c == '\r') {
+            needsQuotes = true;
+            break;
+        }
+    }
+
+    if (needsQuotes) {
+        out += '"';
+        out += text.replace('"', "\"\""); // 双引号转义为两个双引号
+        out += '"';
+    }
+    else {
+        out += text;
+    }
+}
+
+void CsvWriter::appendNumber(QByteArray &out, double value)
+{
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr - buffer);
+}
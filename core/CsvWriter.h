@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QVariant>
+
+#include "Worksheet.h"
+
+// 带大缓冲区的CSV写出器：直接生成UTF-8字节，缓冲区满时整体写入设备，内存占用恒定
+class CsvWriter
+{
+public:
+    explicit CsvWriter(QIODevice *device, char delimiter = ',', qsizetype bufferSize = 1024 * 1024);
+    ~CsvWriter(); // 析构时写出剩余数据
+
+    // 写入失败后（hasError）忽略之后的写入，缓冲区不再增长
+    // 写入一行：row中列号小于columnCount的单元格，缺失的单元格输出为空字段
+    void writeRow(const Worksheet::Row &row, int columnCount);
+    void writeEmptyRow(int columnCount); // 中间的空行
+    void writeRaw(const QByteArray &data); // 写入已格式化的数据
+
+    bool flush(); // 写出缓冲区，失败返回false
+    void discard() { m_buffer.clear(); } // 丢弃尚未写出的数据（中止写入时使用）
+    bool hasError() const { return m_error; }
+    qint64 bytesWritten() const { return m_bytesWritten; }
+
+    // 格式化接口，不涉及设备，可在任意线程中使用
+    static void appendRow(QByteArray &out, const Worksheet::Row &row, int columnCount, char delimiter = ',');
+    static void appendEmptyRow(QByteArray &out, int columnCount, char delimiter = ',');
+    static void appendValue(QByteArray &out, const QVariant &value, char delimiter = ',');
+    static void appendNumber(QByteArray &out, double value); // 最短往返浮点格式
+
+private:
+    void flushIfFull();
+
+    QIODevice *m_device;
+    QByteArray m_buffer;
+    qsizetype m_bufferSize;
+    qint64 m_bytesWritten;
+    char m_delimiter;
+    bool m_error;
+};
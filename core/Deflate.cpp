@@ -0,0 +1,649 @@
+#include "Deflate.h"
+
+#include <QIODevice>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+const int MinMatch = 3;
+const int MaxMatch = 258;
+const int MaxCodeLength = 15;
+const int EndOfBlock = 256;
+
+// 长度码257..285与距离码0..29的基值和附加位数
+const quint16 LengthBase[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+const quint8 LengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+const quint16 DistanceBase[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                  257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+                                  8193, 12289, 16385, 24577};
+const quint8 DistanceExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                  7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+// 码长表的码长的排列顺序
+const quint8 CodeLengthOrder[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+// 固定哈夫曼编码的字面量/长度码长
+void fixedLiteralLengths(quint8 *lengths)
+{
+    for (int i = 0; i < 288; ++i) {
+        lengths[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+    }
+}
+
+quint32 reverseBits(quint32 code, int length)
+{
+    quint32 reversed = 0;
+    for (int i = 0; i < length; ++i) {
+        reversed = (reversed << 1) | (code & 1);
+        code >>= 1;
+    }
+    return reversed;
+}
+
+// 规范哈夫曼解码表：码长不超过FastBits的码直接查表，更长的码按码长逐位查找
+struct HuffmanTable {
+    static constexpr int FastBits = 10;
+
+    std::array<quint16, 1 << FastBits> fast{}; // 符号 << 4 | 码长，0表示需要逐位查找
+    std::array<quint16, MaxCodeLength + 1> counts{}; // 每种码长的码数
+    std::vector<quint16> symbols; // 按码的顺序排列的符号
+
+    bool build(const quint8 *lengths, int count)
+    {
+        counts.fill(0);
+        fast.fill(0);
+        for (int i = 0; i < count; ++i) {
+            ++counts[lengths[i]];
+        }
+        counts[0] = 0;
+
+        // 码数不能超过该码长可容纳的数量（允许不完整的码，如只有一个距离码）
+        int left = 1;
+        for (int length = 1; length <= MaxCodeLength; ++length) {
+            left = (left << 1) - counts[length];
+            if (left < 0) {
+                return false;
+            }
+        }
+
+        std::array<int, MaxCodeLength + 2> offsets{};
+        std::array<quint32, MaxCodeLength + 2> nextCode{};
+        quint32 code = 0;
+        for (int length = 1; length <= MaxCodeLength; ++length) {
+            offsets[length + 1] = offsets[length] + counts[length];
+            code = (code + counts[length - 1]) << 1;
+            nextCode[length] = code;
+        }
+
+        symbols.assign(size_t(offsets[MaxCodeLength + 1]), 0);
+        for (int symbol = 0; symbol < count; ++symbol) {
+            const int length = lengths[symbol];
+            if (length == 0) {
+                continue;
+            }
+            symbols[size_t(offsets[length]++)] = quint16(symbol);
+            if (length <= FastBits) { // 数据流中码从高位开始逐位出现，查表时需要反转
+                const quint32 reversed = reverseBits(nextCode[length], length);
+                for (quint32 j = reversed; j < fast.size(); j += quint32(1) << length) {
+                    fast[j] = quint16(symbol << 4 | length);
+                }
+            }
+            ++nextCode[length];
+        }
+        return true;
+    }
+};
+
+} // namespace
+
+quint32 Deflate::crc32(const char *data, qsizetype size, quint32 crc)
+{
+    static const auto table = []() {
+        std::array<quint32, 256> entries{};
+        for (quint32 i = 0; i < 256; ++i) {
+            quint32 c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            entries[i] = c;
+        }
+        return entries;
+    }();
+
+    crc ^= 0xFFFFFFFFu;
+    for (qsizetype i = 0; i < size; ++i) {
+        crc = table[(crc ^ quint8(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+// ---------------------------------------------------------------- 解压
+
+struct Deflate::Inflater::Private {
+    enum State {
+        BlockHeader,
+        StoredBlock,
+        HuffmanBlock,
+        Finished,
+        Failed
+    };
+
+    const uchar *begin;
+    const uchar *in;
+    const uchar *end;
+    quint64 bitBuffer = 0;
+    int bitCount = 0;
+    int paddingBits = 0; // 读到末尾后补入的0位数，被消耗即说明数据不完整
+
+    State state = BlockHeader;
+    bool finalBlock = false;
+    quint32 storedRemaining = 0;
+    HuffmanTable literals;
+    HuffmanTable distances;
+
+    std::vector<char> window; // 回溯窗口 + 本次输出
+    qsizetype historySize = 0;
+    qsizetype outputSize = 0;
+
+    Private(const char *data, qsizetype size)
+        : begin(reinterpret_cast<const uchar *>(data))
+        , in(begin)
+        , end(begin + size)
+        , window(size_t(WindowSize + ChunkSize + MaxMatch))
+    {}
+
+    void refill()
+    {
+        while (bitCount <= 56) {
+            if (in < end) {
+                bitBuffer |= quint64(*in++) << bitCount;
+            }
+            else {
+                paddingBits += 8;
+            }
+            bitCount += 8;
+        }
+    }
+
+    quint32 bits(int count)
+    {
+        if (count == 0) {
+            return 0;
+        }
+        if (bitCount < count) {
+            refill();
+        }
+        const quint32 value = quint32(bitBuffer & ((quint64(1) << count) - 1));
+        consume(count);
+        return value;
+    }
+
+    void consume(int count)
+    {
+        bitBuffer >>= count;
+        bitCount -= count;
+        if (bitCount < paddingBits) {
+            state = Failed;
+        }
+    }
+
+    int decode(const HuffmanTable &table)
+    {
+        if (bitCount < MaxCodeLength) {
+            refill();
+        }
+        const quint16 entry = table.fast[bitBuffer & ((1u << HuffmanTable::FastBits) - 1)];
+        if (entry) {
+            consume(entry & 15);
+            return entry >> 4;
+        }
+
+        // 长码：按码长逐位比较规范码的范围
+        quint64 buffer = bitBuffer;
+        int code = 0;
+        int first = 0;
+        int index = 0;
+        for (int length = 1; length <= MaxCodeLength; ++length) {
+            code |= int(buffer & 1);
+            buffer >>= 1;
+            const int count = table.counts[length];
+            if (code - count < first) {
+                consume(length);
+                return table.symbols[size_t(index + code - first)];
+            }
+            index += count;
+            first = (first + count) << 1;
+            code <<= 1;
+        }
+        state = Failed;
+        return -1;
+    }
+
+    void readBlockHeader()
+    {
+        finalBlock = bits(1);
+        const quint32 type = bits(2);
+        if (type == 0) {
+            // 非压缩块：对齐到字节，把位缓冲中的整字节退回输入
+            consume(bitCount % 8);
+            in -= (bitCount - paddingBits) / 8;
+            bitBuffer = 0;
+            bitCount = 0;
+            paddingBits = 0;
+            if (end - in < 4) {
+                state = Failed;
+                return;
+            }
+            const quint16 length = quint16(in[0] | in[1] << 8);
+            const quint16 complement = quint16(in[2] | in[3] << 8);
+            in += 4;
+            if (quint16(~complement) != length) {
+                state = Failed;
+                return;
+            }
+            storedRemaining = length;
+            state = StoredBlock;
+        }
+        else if (type == 1) {
+            quint8 lengths[288 + 30];
+            fixedLiteralLengths(lengths);
+            std::memset(lengths + 288, 5, 30);
+            literals.build(lengths, 288);
+            distances.build(lengths + 288, 30);
+            state = HuffmanBlock;
+        }
+        else if (type == 2) {
+            state = readDynamicTables() ? HuffmanBlock : Failed;
+        }
+        else {
+            state = Failed;
+        }
+    }
+
+    bool readDynamicTables()
+    {
+        const int literalCount = int(bits(5)) + 257;
+        const int distanceCount = int(bits(5)) + 1;
+        const int codeLengthCount = int(bits(4)) + 4;
+        if (literalCount > 286 || distanceCount > 30) {
+            return false;
+        }
+
+        quint8 codeLengthLengths[19] = {};
+        for (int i = 0; i < codeLengthCount; ++i) {
+            codeLengthLengths[CodeLengthOrder[i]] = quint8(bits(3));
+        }
+        HuffmanTable codeLengths;
+        if (!codeLengths.build(codeLengthLengths, 19)) {
+            return false;
+        }
+
+        quint8 lengths[286 + 30] = {};
+        const int total = literalCount + distanceCount;
+        for (int i = 0; i < total && state != Failed;) {
+            const int symbol = decode(codeLengths);
+            if (symbol < 16) {
+                lengths[i++] = quint8(symbol);
+                continue;
+            }
+            int repeat = 0;
+            quint8 value = 0;
+            if (symbol == 16) { // 重复前一个码长3..6次
+                if (i == 0) {
+                    return false;
+                }
+                value = lengths[i - 1];
+                repeat = 3 + int(bits(2));
+            }
+            else if (symbol == 17) { // 3..10个0
+                repeat = 3 + int(bits(3));
+            }
+            else if (symbol == 18) { // 11..138个0
+                repeat = 11 + int(bits(7));
+            }
+            else {
+                return false;
+            }
+            if (i + repeat > total) {
+                return false;
+            }
+            std::memset(lengths + i, value, size_t(repeat));
+            i += repeat;
+        }
+
+        return state != Failed && lengths[EndOfBlock] != 0
+            && literals.build(lengths, literalCount)
+            && distances.build(lengths + literalCount, distanceCount);
+    }
+
+    void copyStored(qsizetype limit)
+    {
+        const qsizetype count = std::min({qsizetype(storedRemaining), qsizetype(end - in), limit - outputSize});
+        if (count <= 0 && storedRemaining > 0 && in == end) {
+            state = Failed;
+            return;
+        }
+        std::memcpy(window.data() + historySize + outputSize, in, size_t(count));
+        in += count;
+        outputSize += count;
+        storedRemaining -= quint32(count);
+        if (storedRemaining == 0) {
+            state = finalBlock ? Finished : BlockHeader;
+        }
+    }
+
+    void decodeSymbols(qsizetype limit)
+    {
+        char *out = window.data() + historySize;
+        while (outputSize < limit && state == HuffmanBlock) {
+            const int symbol = decode(literals);
+            if (symbol < 0) {
+                return;
+            }
+            if (symbol < EndOfBlock) {
+                out[outputSize++] = char(symbol);
+                continue;
+            }
+            if (symbol == EndOfBlock) {
+                state = finalBlock ? Finished : BlockHeader;
+                return;
+            }
+
+            const int lengthCode = symbol - 257;
+            if (lengthCode >= 29) {
+                state = Failed;
+                return;
+            }
+            const int length = LengthBase[lengthCode] + int(bits(LengthExtra[lengthCode]));
+            const int distanceCode = decode(distances);
+            if (distanceCode < 0 || distanceCode >= 30) {
+                state = Failed;
+                return;
+            }
+            const int distance = DistanceBase[distanceCode] + int(bits(DistanceExtra[distanceCode]));
+            if (distance > historySize + outputSize) {
+                state = Failed;
+                return;
+            }
+            // 源与目标可能重叠（距离小于长度时重复最近的内容），逐字节复制
+            const char *from = out + outputSize - distance;
+            char *to = out + outputSize;
+            for (int i = 0; i < length; ++i) {
+                to[i] = from[i];
+            }
+            outputSize += length;
+        }
+    }
+};
+
+Deflate::Inflater::Inflater(const char *data, qsizetype size)
+    : d(std::make_unique<Private>(data, size))
+{}
+
+Deflate::Inflater::~Inflater() = default;
+
+QByteArray Deflate::Inflater::read()
+{
+    d->outputSize = 0;
+    while (d->outputSize < ChunkSize) {
+        if (d->state == Private::BlockHeader) {
+            d->readBlockHeader();
+        }
+        else if (d->state == Private::StoredBlock) {
+            d->copyStored(ChunkSize);
+        }
+        else if (d->state == Private::HuffmanBlock) {
+            d->decodeSymbols(ChunkSize);
+        }
+        else {
+            break;
+        }
+    }
+    if (d->state == Private::Failed) {
+        return QByteArray();
+    }
+
+    QByteArray chunk(d->window.data() + d->historySize, d->outputSize);
+
+    // 只保留最后WindowSize字节作为后续块的回溯窗口
+    const qsizetype total = d->historySize + d->outputSize;
+    const qsizetype keep = qMin<qsizetype>(total, WindowSize);
+    std::memmove(d->window.data(), d->window.data() + total - keep, size_t(keep));
+    d->historySize = keep;
+    d->outputSize = 0;
+    return chunk;
+}
+
+bool Deflate::Inflater::atEnd() const
+{
+    return d->state == Private::Finished;
+}
+
+bool Deflate::Inflater::hasError() const
+{
+    return d->state == Private::Failed;
+}
+
+qsizetype Deflate::Inflater::consumed() const
+{
+    return (d->in - d->begin) - (d->bitCount - d->paddingBits) / 8;
+}
+
+// ---------------------------------------------------------------- 压缩
+
+struct Deflate::Deflater::Private {
+    static constexpr int HashBits = 15;
+    static constexpr int MaxChain = 32; // 每个位置最多比较的候选数
+    static constexpr qsizetype OutputBufferSize = 64 * 1024;
+
+    // 固定哈夫曼编码（已按输出顺序反转）与长度、距离到码的映射
+    struct Codes {
+        std::array<quint16, 288> literalCode;
+        std::array<quint8, 288> literalLength;
+        std::array<quint8, MaxMatch + 1> lengthCode;
+        std::array<quint8, WindowSize + 1> distanceCode;
+
+        Codes()
+        {
+            quint8 lengths[288];
+            fixedLiteralLengths(lengths);
+            // 固定编码的规范码：码长7、8、9依次为0x00、0x30、0x190起（长度8的280..287从0xC0起）
+            for (int i = 0; i < 288; ++i) {
+                const quint32 code = i < 144 ? 0x30 + i : i < 256 ? 0x190 + (i - 144)
+                                   : i < 280 ? quint32(i - 256) : 0xC0 + (i - 280);
+                literalCode[size_t(i)] = quint16(reverseBits(code, lengths[i]));
+                literalLength[size_t(i)] = lengths[i];
+            }
+            for (int code = 0; code < 29; ++code) {
+                for (int length = LengthBase[code]; length < LengthBase[code] + (1 << LengthExtra[code]) && length <= MaxMatch; ++length) {
+                    lengthCode[size_t(length)] = quint8(code);
+                }
+            }
+            lengthCode[MaxMatch] = 28; // 258有单独的码
+            for (int code = 0; code < 30; ++code) {
+                for (int distance = DistanceBase[code]; distance < DistanceBase[code] + (1 << DistanceExtra[code]); ++distance) {
+                    distanceCode[size_t(distance)] = quint8(code);
+                }
+            }
+        }
+    };
+
+    QIODevice *device;
+    QByteArray output;
+    quint64 bitBuffer = 0;
+    int bitCount = 0;
+    qint64 written = 0;
+    bool ok = true;
+
+    QByteArray input; // 回溯窗口 + 尚未压缩的数据
+    qint64 base = 0; // input[0]在整个数据流中的位置
+    qsizetype pos = 0; // 下一个待压缩的位置
+    std::vector<qint64> head; // 哈希值 -> 最近出现的位置
+    std::vector<qint64> previous; // 位置 -> 同一哈希值的上一个位置
+
+    explicit Private(QIODevice *device)
+        : device(device)
+        , head(size_t(1) << HashBits, -1)
+        , previous(size_t(WindowSize), -1)
+    {
+        output.reserve(OutputBufferSize + 16);
+        putBits(1, 1); // 唯一的块，也是最后一个块
+        putBits(1, 2); // 固定哈夫曼编码
+    }
+
+    static const Codes &codes()
+    {
+        static const Codes instance;
+        return instance;
+    }
+
+    void putBits(quint32 value, int count)
+    {
+        bitBuffer |= quint64(value) << bitCount;
+        bitCount += count;
+        while (bitCount >= 8) {
+            output.append(char(bitBuffer & 0xFF));
+            bitBuffer >>= 8;
+            bitCount -= 8;
+        }
+        if (output.size() >= OutputBufferSize) {
+            flushOutput();
+        }
+    }
+
+    void flushOutput()
+    {
+        if (output.isEmpty()) {
+            return;
+        }
+        ok = ok && device->write(output) == output.size();
+        written += output.size();
+        output.clear();
+    }
+
+    void putLiteral(int symbol)
+    {
+        const Codes &c = codes();
+        putBits(c.literalCode[size_t(symbol)], c.literalLength[size_t(symbol)]);
+    }
+
+    void putMatch(int length, int distance)
+    {
+        const Codes &c = codes();
+        const int lengthCode = c.lengthCode[size_t(length)];
+        putLiteral(257 + lengthCode);
+        putBits(quint32(length - LengthBase[lengthCode]), LengthExtra[lengthCode]);
+        const int distanceCode = c.distanceCode[size_t(distance)];
+        putBits(reverseBits(quint32(distanceCode), 5), 5);
+        putBits(quint32(distance - DistanceBase[distanceCode]), DistanceExtra[distanceCode]);
+    }
+
+    size_t hashAt(qsizetype at) const
+    {
+        const uchar *p = reinterpret_cast<const uchar *>(input.constData()) + at;
+        return ((quint32(p[0]) << 10) ^ (quint32(p[1]) << 5) ^ p[2]) & ((1u << HashBits) - 1);
+    }
+
+    void insert(qsizetype at)
+    {
+        const size_t hash = hashAt(at);
+        const qint64 position = base + at;
+        previous[size_t(position % WindowSize)] = head[hash];
+        head[hash] = position;
+    }
+
+    // 压缩到距离数据末尾不足MaxMatch处为止（flush时压缩全部），匹配长度须在当前数据内
+    void compress(bool flush)
+    {
+        const qsizetype size = input.size();
+        const qsizetype limit = flush ? size : size - MaxMatch;
+        const char *data = input.constData();
+
+        while (pos < limit) {
+            int bestLength = 0;
+            int bestDistance = 0;
+            if (size - pos >= MinMatch) {
+                const qint64 position = base + pos;
+                const qsizetype maxLength = qMin<qsizetype>(MaxMatch, size - pos);
+                qint64 candidate = head[hashAt(pos)];
+                for (int chain = 0; chain < MaxChain && candidate >= 0 && position - candidate <= WindowSize; ++chain) {
+                    const char *a = data + (candidate - base);
+                    const char *b = data + pos;
+                    if (a[bestLength] == b[bestLength]) { // 先比较能否超过当前最长匹配
+                        int length = 0;
+                        while (length < maxLength && a[length] == b[length]) {
+                            ++length;
+                        }
+                        if (length > bestLength) {
+                            bestLength = length;
+                            bestDistance = int(position - candidate);
+                            if (length == maxLength) {
+                                break;
+                            }
+                        }
+                    }
+                    candidate = previous[size_t(candidate % WindowSize)];
+                }
+                insert(pos);
+            }
+
+            if (bestLength >= MinMatch) {
+                putMatch(bestLength, bestDistance);
+                for (qsizetype i = pos + 1; i < pos + bestLength && i + MinMatch <= size; ++i) {
+                    insert(i);
+                }
+                pos += bestLength;
+            }
+            else {
+                putLiteral(quint8(data[pos]));
+                ++pos;
+            }
+        }
+    }
+
+    // 丢弃回溯窗口之前的数据
+    void trimInput()
+    {
+        const qsizetype drop = pos - WindowSize;
+        if (drop >= 4 * WindowSize) {
+            input.remove(0, drop);
+            base += drop;
+            pos -= drop;
+        }
+    }
+};
+
+Deflate::Deflater::Deflater(QIODevice *device)
+    : d(std::make_unique<Private>(device))
+{}
+
+Deflate::Deflater::~Deflater() = default;
+
+bool Deflate::Deflater::write(const char *data, qsizetype size)
+{
+    d->input.append(data, size);
+    d->compress(false);
+    d->trimInput();
+    return d->ok;
+}
+
+bool Deflate::Deflater::finish()
+{
+    d->compress(true);
+    d->putLiteral(EndOfBlock);
+    if (d->bitCount > 0) {
+        d->putBits(0, 8 - d->bitCount); // 补齐最后一个字节
+    }
+    d->flushOutput();
+    return d->ok;
+}
+
+qint64 Deflate::Deflater::compressedSize() const
+{
+    return d->written;
+}
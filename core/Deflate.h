@@ -0,0 +1,55 @@
+#pragma once
+
+#include <QByteArray>
+#include <memory>
+
+class QIODevice;
+
+// 原始deflate数据流（RFC 1951）的流式解压与压缩，用于读写ZIP容器（.xlsx）。
+// 解压支持全部三种块类型；压缩只输出一个固定哈夫曼编码块（哈希链查找重复串），
+// 可以边写边压缩，内存占用与数据总量无关
+class Deflate
+{
+public:
+    static constexpr int WindowSize = 32768; // 回溯窗口
+
+    // CRC-32（ZIP/IEEE多项式）；分段计算时把上一段的结果作为crc传入
+    static quint32 crc32(const char *data, qsizetype size, quint32 crc = 0);
+
+    // 解压：压缩数据须在解压期间保持有效（通常是映射的文件），每次取出一段解压结果
+    class Inflater
+    {
+    public:
+        static constexpr qsizetype ChunkSize = 256 * 1024; // 每次取出的大致字节数
+
+        Inflater(const char *data, qsizetype size);
+        ~Inflater();
+
+        QByteArray read(); // 下一段解压数据，结束或出错时返回空
+        bool atEnd() const; // 已读到最后一个块的结尾
+        bool hasError() const;
+        qsizetype consumed() const; // 已消耗的压缩数据字节数（用于报告进度）
+
+    private:
+        struct Private;
+        std::unique_ptr<Private> d;
+    };
+
+    // 压缩：写入的数据压缩后追加到device，finish写出结束码并刷新缓冲
+    class Deflater
+    {
+    public:
+        explicit Deflater(QIODevice *device);
+        ~Deflater();
+
+        bool write(const char *data, qsizetype size);
+        bool write(const QByteArray &data) { return write(data.constData(), data.size()); }
+        bool finish();
+
+        qint64 compressedSize() const; // 已写入device的字节数
+
+    private:
+        struct Private;
+        std::unique_ptr<Private> d;
+    };
+};
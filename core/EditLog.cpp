@@ -0,0 +1,670 @@
+#include "EditLog.h"
+#include "Cell.h"
+#include "Worksheet.h"
+#include "FileManager.h"
+#include "Deflate.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QThread>
+#include <QTimer>
+#include <QtEndian>
+#include <QDebug>
+
+#ifdef Q_OS_WIN
+#include <qt_windows.h>
+#include <io.h> // _commit
+#else
+#include <cstdio> // rename
+#include <unistd.h> // fsync
+#endif
+
+namespace {
+
+const quint32 LogMagic = 0x4C505353; // "SSPL"
+const quint16 LogVersion = 1;
+const qint64 HeaderSize = 4 + 2 + 2 + 8 + 8;
+const qint64 RecordHeaderSize = 4 + 1 + 4;
+const qint64 MinCompactionSize = 4 * 1024 * 1024; // 日志超过该大小且超过工作簿的1/4时合并
+
+enum RecordType : quint8 {
+    BatchRecord = 1,
+    CommitRecord = 2
+};
+
+enum Operation : quint8 {
+    SetCell = 1,
+    AddSheet = 2,
+    RemoveSheet = 3,
+    RenameSheet = 4,
+    SortRange = 5, // 记录排序条件，重放时重新排序，不逐个记录移动的单元格
+    SetSize = 6 // 表格尺寸（setSize及插入、删除行列）；分配单元格引起的扩展由SetCell体现
+};
+
+template <typename T>
+void appendLE(QByteArray &out, T value)
+{
+    value = qToLittleEndian(value);
+    out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+// 工作簿文件的标识：日志只对生成它时的文件有效
+struct FileStamp {
+    qint64 size = -1;
+    qint64 modified = -1;
+
+    bool operator==(const FileStamp &other) const { return size == other.size && modified == other.modified; }
+};
+
+FileStamp stampOf(const QString &fileName)
+{
+    QFileInfo info(fileName);
+    if (!info.exists()) {
+        return FileStamp();
+    }
+    return FileStamp{info.size(), info.lastModified().toMSecsSinceEpoch()};
+}
+
+QByteArray logHeader(const FileStamp &stamp)
+{
+    QByteArray header;
+    appendLE<quint32>(header, LogMagic);
+    appendLE<quint16>(header, LogVersion);
+    appendLE<quint16>(header, 0);
+    appendLE<qint64>(header, stamp.size);
+    appendLE<qint64>(header, stamp.modified);
+    return header;
+}
+
+QString compactFileName(const QString &fileName)
+{
+    return fileName + ".compact." + QFileInfo(fileName).suffix(); // 保留扩展名以选择保存格式
+}
+
+bool syncFile(QFile &file)
+{
+    if (!file.flush()) {
+        return false;
+    }
+#ifdef Q_OS_WIN
+    return _commit(file.handle()) == 0;
+#else
+    return ::fsync(file.handle()) == 0;
+#endif
+}
+
+// 原子地用from替换to
+bool replaceFile(const QString &from, const QString &to)
+{
+#ifdef Q_OS_WIN
+    return MoveFileExW(reinterpret_cast<LPCWSTR>(from.utf16()), reinterpret_cast<LPCWSTR>(to.utf16()),
+                       MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+    return std::rename(QFile::encodeName(from).constData(), QFile::encodeName(to).constData()) == 0;
+#endif
+}
+
+// 日志内容：已提交与未提交的批次
+struct LogContents {
+    FileStamp stamp;
+    QList<QByteArray> committed;
+    QList<QByteArray> uncommitted;
+    qint64 committedEnd = HeaderSize; // 最后一个提交标记之后的位置
+    qint64 validEnd = HeaderSize;     // 最后一个完整记录之后的位置
+};
+
+// 读取日志的前limit字节（-1为整个文件），遇到不完整或校验失败的记录即停止
+bool readLog(const QString &logName, LogContents *contents, qint64 limit = -1)
+{
+    QFile file(logName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QByteArray data = file.read(limit < 0 ? file.size() : limit);
+    if (data.size() < HeaderSize
+        || qFromLittleEndian<quint32>(data.constData()) != LogMagic
+        || qFromLittleEndian<quint16>(data.constData() + 4) != LogVersion) {
+        return false;
+    }
+    contents->stamp.size = qFromLittleEndian<qint64>(data.constData() + 8);
+    contents->stamp.modified = qFromLittleEndian<qint64>(data.constData() + 16);
+
+    QList<QByteArray> pending;
+    qint64 pos = HeaderSize;
+    while (data.size() - pos >= RecordHeaderSize) {
+        const quint32 size = qFromLittleEndian<quint32>(data.constData() + pos);
+        const quint8 type = quint8(data[pos + 4]);
+        const quint32 crc = qFromLittleEndian<quint32>(data.constData() + pos + 5);
+        const char *payload = data.constData() + pos + RecordHeaderSize;
+        if (data.size() - pos - RecordHeaderSize < qint64(size) || Deflate::crc32(payload, size) != crc) {
+            break; // 写入中途崩溃留下的残缺记录
+        }
+        pos += RecordHeaderSize + size;
+
+        if (type == BatchRecord) {
+            pending.append(QByteArray(payload, size));
+        }
+        else if (type == CommitRecord) {
+            contents->committed += pending;
+            pending.clear();
+            contents->committedEnd = pos;
+        }
+        contents->validEnd = pos;
+    }
+    contents->uncommitted = pending;
+    return true;
+}
+
+// 把一个批次应用到工作簿
+bool applyBatch(Workbook *workbook, const QByteArray &payload)
+{
+    QDataStream in(payload);
+    in.setVersion(QDataStream::Qt_6_0);
+
+    quint32 count = 0;
+    in >> count;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        quint8 operation = 0;
+        in >> operation;
+        switch (operation) {
+        case SetCell: {
+            qint32 sheet, row, col;
+            QString formula;
+            QVariant value;
+            bool readOnly;
+            in >> sheet >> row >> col >> formula >> value >> readOnly;
+            auto worksheet = workbook->worksheet(sheet);
+            if (in.status() != QDataStream::Ok || !worksheet || !worksheet->ensureLoaded()) {
+                return false;
+            }
+            auto cell = worksheet->cell(row, col);
+            if (!formula.isEmpty()) {
+                cell->setFormula(formula);
+            }
+            else {
+                cell->setValue(value);
+            }
+            cell->setReadOnly(readOnly);
+            break;
+        }
+        case AddSheet: {
+            QString name;
+            in >> name;
+            workbook->addWorksheet(name);
+            break;
+        }
+        case RemoveSheet: {
+            qint32 sheet;
+            in >> sheet;
+            workbook->removeWorksheet(sheet);
+            break;
+        }
+        case RenameSheet: {
+            qint32 sheet;
+            QString name;
+            in >> sheet >> name;
+            if (auto worksheet = workbook->worksheet(sheet)) {
+                worksheet->setName(name);
+            }
+            break;
+        }
+        case SortRange: {
+            qint32 sheet, firstRow, lastRow, firstColumn, lastColumn, keyCount;
+            in >> sheet >> firstRow >> lastRow >> firstColumn >> lastColumn >> keyCount;
+            Worksheet::SortSpec spec{firstRow, lastRow, firstColumn, lastColumn, {}};
+            for (qint32 k = 0; k < keyCount && in.status() == QDataStream::Ok; ++k) {
+                qint32 column;
+                bool ascending;
+                in >> column >> ascending;
+                spec.keys.append(Worksheet::SortKey{column, ascending});
+            }
+            auto worksheet = workbook->worksheet(sheet);
+            if (in.status() != QDataStream::Ok || !worksheet || !worksheet->ensureLoaded()) {
+                return false;
+            }
+            worksheet->sort(spec);
+            break;
+        }
+        case SetSize: {
+            qint32 sheet, rows, cols;
+            in >> sheet >> rows >> cols;
+            auto worksheet = workbook->worksheet(sheet);
+            if (in.status() != QDataStream::Ok || !worksheet || !worksheet->ensureLoaded()) {
+                return false;
+            }
+            worksheet->setSize(rows, cols);
+            break;
+        }
+        default:
+            return false;
+        }
+    }
+    return in.status() == QDataStream::Ok;
+}
+
+// 后台合并：由工作簿文件与日志的已提交部分重建完整的工作簿，写入target
+bool compactInto(const QString &fileName, const QString &logName, qint64 logSize, const QString &target)
+{
+    LogContents contents;
+    if (!readLog(logName, &contents, logSize) || !(contents.stamp == stampOf(fileName))) {
+        return false;
+    }
+
+    Workbook workbook; // 属于合并线程，与界面中的工作簿互不影响
+    if (!FileManager::loadWorkbook(&workbook, fileName)) {
+        return false;
+    }
+    for (const QByteArray &batch : contents.committed) {
+        if (!applyBatch(&workbook, batch)) {
+            return false;
+        }
+    }
+
+    if (!FileManager::saveWorkbook(&workbook, target)) {
+        QFile::remove(target);
+        return false;
+    }
+    QFile file(target);
+    return file.open(QIODevice::ReadWrite) && syncFile(file);
+}
+
+} // namespace
+
+EditLog::EditLog(QObject *parent)
+    : QObject(parent)
+    , m_workbook(nullptr)
+    , m_batchOperations(0)
+    , m_batchScheduled(false)
+    , m_committedSize(HeaderSize)
+    , m_baseSize(0)
+    , m_replaying(false)
+    , m_compactor(nullptr)
+    , m_compactedSize(0)
+    , m_compactOk(false)
+{
+}
+
+EditLog::~EditLog()
+{
+    close();
+}
+
+bool EditLog::supports(const QString &fileName)
+{
+    const QString suffix = QFileInfo(fileName).suffix().toLower();
+    return suffix == "ssp" || suffix == "json";
+}
+
+QString EditLog::logFileName(const QString &fileName)
+{
+    return fileName + ".log";
+}
+
+bool EditLog::open(Workbook *workbook, const QString &fileName, int *uncommitted)
+{
+    close();
+    if (uncommitted) *uncommitted = 0;
+
+    const QString logName = logFileName(fileName);
+    const QString newLogName = logName + ".new";
+    const FileStamp base = stampOf(fileName);
+
+    // 合并时在替换工作簿文件之后、替换日志之前崩溃：新日志已与工作簿文件匹配
+    if (QFile::exists(newLogName)) {
+        LogContents newLog;
+        if (readLog(newLogName, &newLog) && newLog.stamp == base) {
+            replaceFile(newLogName, logName);
+        }
+        else {
+            QFile::remove(newLogName);
+        }
+    }
+    QFile::remove(compactFileName(fileName)); // 未完成的合并
+
+    LogContents contents;
+    const bool hasLog = QFile::exists(logName) && readLog(logName, &contents) && contents.stamp == base;
+    if (!hasLog && QFile::exists(logName)) {
+        qDebug() << "Discarding stale edit log:" << logName; // 工作簿文件已在别处被修改
+        QFile::remove(logName);
+    }
+
+    // 重放已提交的批次
+    for (const QByteArray &batch : contents.committed) {
+        if (!applyBatch(workbook, batch)) {
+            qDebug() << "Corrupted edit log:" << logName;
+            return false;
+        }
+    }
+
+    m_workbook = workbook;
+    m_fileName = fileName;
+    m_baseSize = base.size;
+    if (!openLogFile(logName, !hasLog)) {
+        m_workbook = nullptr;
+        return false;
+    }
+    if (hasLog) {
+        m_log.resize(contents.validEnd); // 截断残缺的记录
+        m_committedSize = contents.committedEnd;
+        m_uncommitted = contents.uncommitted;
+    }
+    m_log.seek(m_log.size());
+
+    // 开始记录修改
+    connect(m_workbook, &Workbook::worksheetAdded, this, [this](int index) {
+        auto worksheet = m_workbook->worksheet(index);
+        watchWorksheet(worksheet.get());
+        if (!m_replaying) {
+            QDataStream out(&m_batch, QIODevice::WriteOnly | QIODevice::Append);
+            out.setVersion(QDataStream::Qt_6_0);
+            out << quint8(AddSheet) << worksheet->name();
+            ++m_batchOperations;
+            scheduleBatch();
+        }
+    });
+    connect(m_workbook, &Workbook::worksheetRemoved, this, [this](int index) {
+        if (!m_replaying) {
+            QDataStream out(&m_batch, QIODevice::WriteOnly | QIODevice::Append);
+            out.setVersion(QDataStream::Qt_6_0);
+            out << quint8(RemoveSheet) << qint32(index);
+            ++m_batchOperations;
+            scheduleBatch();
+        }
+    });
+    for (int i = 0; i < m_workbook->worksheetCount(); ++i) {
+        watchWorksheet(m_workbook->worksheet(i).get());
+    }
+
+    if (uncommitted) *uncommitted = m_uncommitted.size();
+    return true;
+}
+
+bool EditLog::reset(Workbook *workbook, const QString &fileName)
+{
+    close();
+    QFile::remove(logFileName(fileName));
+    QFile::remove(logFileName(fileName) + ".new");
+    return open(workbook, fileName);
+}
+
+void EditLog::close()
+{
+    if (m_compactor) { // 放弃进行中的合并
+        m_compactor->disconnect(this);
+        m_compactor->wait();
+        delete m_compactor;
+        m_compactor = nullptr;
+        QFile::remove(m_compactFileName);
+    }
+
+    if (!m_workbook) {
+        return;
+    }
+    m_workbook->disconnect(this);
+    for (int i = 0; i < m_workbook->worksheetCount(); ++i) {
+        m_workbook->worksheet(i)->disconnect(this);
+    }
+    m_workbook = nullptr;
+
+    m_log.close();
+    m_dirtyCells.clear();
+    m_batch.clear();
+    m_batchOperations = 0;
+    m_uncommitted.clear();
+    m_committedSize = HeaderSize;
+}
+
+void EditLog::watchWorksheet(Worksheet *worksheet)
+{
+    connect(worksheet, &Worksheet::cellChanged, this, [this, worksheet](int row, int col) {
+        if (!m_replaying) {
+            m_dirtyCells[worksheet].insert((qint64(row) << 32) | quint32(col));
+            scheduleBatch();
+        }
+    });
+    connect(worksheet, &Worksheet::nameChanged, this, [this, worksheet](const QString &name) {
+        const int index = m_workbook->indexOf(worksheet);
+        if (!m_replaying && index >= 0) {
+            QDataStream out(&m_batch, QIODevice::WriteOnly | QIODevice::Append);
+            out.setVersion(QDataStream::Qt_6_0);
+            out << quint8(RenameSheet) << qint32(index) << name;
+            ++m_batchOperations;
+            scheduleBatch();
+        }
+    });
+    connect(worksheet, &Worksheet::aboutToSort, this, [this, worksheet](const Worksheet::SortSpec &spec) {
+        const int index = m_workbook->indexOf(worksheet);
+        if (!m_replaying && index >= 0) {
+            flushDirtyCells(); // 排序前的修改须在排序之前重放，此时单元格尚未移动
+            QDataStream out(&m_batch, QIODevice::WriteOnly | QIODevice::Append);
+            out.setVersion(QDataStream::Qt_6_0);
+            out << quint8(SortRange) << qint32(index) << qint32(spec.firstRow) << qint32(spec.lastRow)
+                << qint32(spec.firstColumn) << qint32(spec.lastColumn) << qint32(spec.keys.size());
+            for (const Worksheet::SortKey &key : spec.keys) {
+                out << qint32(key.column) << key.ascending;
+            }
+            ++m_batchOperations;
+            scheduleBatch();
+        }
+    });
+    connect(worksheet, &Worksheet::sizeChanged, this, [this, worksheet](int rows, int cols) {
+        const int index = m_workbook->indexOf(worksheet);
+        if (!m_replaying && index >= 0) {
+            flushDirtyCells(); // 保持与单元格修改的先后顺序：缩小尺寸不能小于已分配单元格的范围
+            QDataStream out(&m_batch, QIODevice::WriteOnly | QIODevice::Append);
+            out.setVersion(QDataStream::Qt_6_0);
+            out << quint8(SetSize) << qint32(index) << qint32(rows) << qint32(cols);
+            ++m_batchOperations;
+            scheduleBatch();
+        }
+    });
+    connect(worksheet, &QObject::destroyed, this, [this, worksheet]() {
+        m_dirtyCells.remove(worksheet); // 工作表已删除
+    });
+}
+
+// 同一轮事件循环中的修改合并为一个批次（如粘贴、导入）
+void EditLog::scheduleBatch()
+{
+    if (!m_batchScheduled) {
+        m_batchScheduled = true;
+        QTimer::singleShot(0, this, [this]() {
+            m_batchScheduled = false;
+            if (isOpen()) {
+                writeBatch();
+            }
+        });
+    }
+    emit changed();
+}
+
+// 单元格在写入批次时才读取内容，多次修改只记录最新值；
+// 工作表序号取写入时的值，因此排在此前记录的增删工作表操作之后
+void EditLog::flushDirtyCells()
+{
+    QDataStream out(&m_batch, QIODevice::WriteOnly | QIODevice::Append);
+    out.setVersion(QDataStream::Qt_6_0);
+
+    for (auto it = m_dirtyCells.constBegin(); it != m_dirtyCells.constEnd(); ++it) {
+        const int index = m_workbook->indexOf(it.key());
+        if (index < 0) {
+            continue;
+        }
+        for (qint64 key : it.value()) {
+            const int row = int(key >> 32);
+            const int col = int(quint32(key));
+            auto cell = it.key()->cellAt(row, col);
+            out << quint8(SetCell) << qint32(index) << qint32(row) << qint32(col);
+            if (cell) {
+                out << cell->formula() << cell->value() << cell->isReadOnly();
+            }
+            else {
+                out << QString() << QVariant() << false;
+            }
+            ++m_batchOperations;
+        }
+    }
+    m_dirtyCells.clear();
+}
+
+bool EditLog::writeBatch()
+{
+    flushDirtyCells();
+    if (m_batchOperations == 0) {
+        return true;
+    }
+
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << m_batchOperations;
+    payload.append(m_batch);
+
+    m_batch.clear();
+    m_batchOperations = 0;
+    return appendRecord(BatchRecord, payload);
+}
+
+bool EditLog::appendRecord(quint8 type, const QByteArray &payload)
+{
+    QByteArray record;
+    appendLE<quint32>(record, quint32(payload.size()));
+    appendLE<quint8>(record, type);
+    appendLE<quint32>(record, Deflate::crc32(payload.constData(), payload.size()));
+    record.append(payload);
+    return m_log.write(record) == record.size();
+}
+
+bool EditLog::openLogFile(const QString &logName, bool create)
+{
+    m_log.setFileName(logName);
+    if (!create) {
+        return m_log.open(QIODevice::ReadWrite);
+    }
+
+    if (!m_log.open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+        return false;
+    }
+    const QByteArray header = logHeader(stampOf(m_fileName));
+    m_committedSize = HeaderSize;
+    return m_log.write(header) == header.size() && syncFile(m_log);
+}
+
+void EditLog::recoverUncommitted()
+{
+    if (!isOpen()) return;
+
+    // 这些批次已在日志中，重放时不再记录
+    m_replaying = true;
+    for (const QByteArray &batch : m_uncommitted) {
+        applyBatch(m_workbook, batch);
+    }
+    m_replaying = false;
+
+    if (!m_uncommitted.isEmpty()) {
+        m_uncommitted.clear();
+        emit changed();
+    }
+}
+
+void EditLog::discardUncommitted()
+{
+    if (!isOpen()) return;
+
+    m_dirtyCells.clear();
+    m_batch.clear();
+    m_batchOperations = 0;
+    m_uncommitted.clear();
+
+    m_log.flush();
+    m_log.resize(m_committedSize);
+    m_log.seek(m_committedSize);
+}
+
+bool EditLog::commit()
+{
+    if (!isOpen() || !writeBatch() || !appendRecord(CommitRecord, QByteArray()) || !syncFile(m_log)) {
+        return false;
+    }
+    m_committedSize = m_log.pos();
+    return true;
+}
+
+
+bool EditLog::needsCompaction() const
+{
+    return isOpen() && !m_compactor
+           && m_committedSize - HeaderSize > qMax(MinCompactionSize, m_baseSize / 4);
+}
+
+void EditLog::compact()
+{
+    if (!isOpen() || m_compactor) return;
+
+    m_compactedSize = m_committedSize;
+    m_compactFileName = compactFileName(m_fileName);
+    m_compactOk = false;
+
+    const QString fileName = m_fileName;
+    const QString logName = m_log.fileName();
+    const QString target = m_compactFileName;
+    const qint64 logSize = m_compactedSize;
+    m_compactor = QThread::create([this, fileName, logName, logSize, target]() {
+        m_compactOk = compactInto(fileName, logName, logSize, target);
+    });
+    connect(m_compactor, &QThread::finished, this, [this]() {
+        if (m_compactor) { // close()中已放弃的合并不再处理
+            finishCompaction(m_compactOk);
+        }
+    });
+    m_compactor->start(QThread::LowPriority);
+}
+
+// 在界面线程中完成合并：新日志 = 新文件头 + 合并开始后追加的记录。
+// 先写好新日志，再依次替换工作簿文件和日志，任一步骤中途崩溃都可由open恢复。
+// 尚未载入的工作表仍引用旧文件的映射（POSIX下替换不影响已打开的文件；无法替换时放弃本次合并）
+void EditLog::finishCompaction(bool ok)
+{
+    m_compactor->deleteLater();
+    m_compactor = nullptr;
+
+    if (ok && isOpen()) {
+        ok = false;
+        const QString logName = m_log.fileName();
+        const QString newLogName = logName + ".new";
+        const FileStamp stamp = stampOf(m_compactFileName);
+
+        m_log.flush();
+        m_log.seek(m_compactedSize);
+        const QByteArray tail = m_log.readAll();
+        m_log.seek(m_log.size());
+
+        QFile newLog(newLogName);
+        const QByteArray header = logHeader(stamp);
+        const bool written = newLog.open(QIODevice::WriteOnly | QIODevice::Truncate)
+                             && newLog.write(header) == header.size()
+                             && newLog.write(tail) == tail.size()
+                             && syncFile(newLog);
+        newLog.close();
+
+        if (written && replaceFile(m_compactFileName, m_fileName)) {
+            m_log.close();
+            if (!replaceFile(newLogName, logName)) {
+                m_log.setFileName(newLogName); // 下次打开时由open放回原位
+            }
+            if (m_log.open(QIODevice::ReadWrite)) {
+                m_log.seek(m_log.size());
+                m_committedSize = HeaderSize + (m_committedSize - m_compactedSize);
+                m_baseSize = stamp.size;
+                ok = true;
+            }
+        }
+        else {
+            QFile::remove(newLogName);
+        }
+    }
+
+    QFile::remove(m_compactFileName);
+    emit compactionFinished(ok);
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <QObject>
+#include <QFile>
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QByteArray>
+
+#include "Workbook.h"
+
+class QThread;
+
+// 预写式编辑日志（<工作簿文件>.log）：修改发生时按批追加记录，保存只需追加提交标记并fsync；
+// 日志增长到一定大小后在后台线程合并进工作簿文件。打开文件时重放已提交的批次，
+// 崩溃前未提交的批次由用户决定是否恢复
+//
+//   文件头 magic "SSPL" | 版本 | 保留 | 对应的工作簿文件大小 | 修改时间（用于识别过期日志）
+//   记录   载荷长度 | 类型（批次/提交） | CRC32 | 载荷；末尾不完整或校验失败的记录被截断
+class EditLog : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit EditLog(QObject *parent = nullptr);
+    ~EditLog();
+
+    static bool supports(const QString &fileName); // 只支持可完整保存的格式（.ssp/.json）
+    static QString logFileName(const QString &fileName);
+
+    // 打开工作簿后调用：重放已提交的批次并开始记录修改；uncommitted返回未提交的批次数
+    bool open(Workbook *workbook, const QString &fileName, int *uncommitted = nullptr);
+    // 完整保存工作簿后调用：丢弃旧日志，以新文件为基准重新开始
+    bool reset(Workbook *workbook, const QString &fileName);
+    void close(); // 停止记录，日志保持不变
+    bool isOpen() const { return m_workbook != nullptr; }
+
+    void recoverUncommitted(); // 应用崩溃前未提交的批次
+    void discardUncommitted(); // 丢弃未提交的批次（放弃修改）
+
+    bool commit(); // 保存：写出当前批次与提交标记并fsync
+
+    bool needsCompaction() const; // 已提交的日志超过阈值
+    void compact(); // 后台合并，完成后发出compactionFinished
+
+signals:
+    void changed(); // 记录了新的修改
+    void compactionFinished(bool ok);
+
+private:
+    void watchWorksheet(Worksheet *worksheet);
+    void scheduleBatch();
+    void flushDirtyCells(); // 把待记录的单元格写入当前批次
+    bool writeBatch(); // 当前批次追加到日志（不fsync）
+    bool appendRecord(quint8 type, const QByteArray &payload);
+    bool openLogFile(const QString &logName, bool create);
+    void finishCompaction(bool ok);
+
+    Workbook *m_workbook;
+    QString m_fileName;
+    QFile m_log;
+
+    QHash<Worksheet *, QSet<qint64>> m_dirtyCells; // 待记录的单元格（行 << 32 | 列），写入时取最新内容
+    QByteArray m_batch; // 当前批次已序列化的操作
+    quint32 m_batchOperations;
+    bool m_batchScheduled;
+
+    qint64 m_committedSize; // 最后一个提交标记之后的位置
+    qint64 m_baseSize; // 工作簿文件大小，用于判断是否需要合并
+    QList<QByteArray> m_uncommitted; // 打开时发现的未提交批次
+    bool m_replaying; // 重放日志期间不记录修改
+
+    // 后台合并
+    QThread *m_compactor;
+    qint64 m_compactedSize; // 参与合并的日志长度
+    QString m_compactFileName;
+    bool m_compactOk;
+};
@@ -1,282 +1,900 @@
 #include "FileManager.h"
 #include "Cell.h"
 #include "Worksheet.h"
+#include "CsvTokenizer.h"
+#include "CsvWriter.h"
+#include "SspFormat.h"
+#include "XlsxFormat.h"
+#include "ArrowFormat.h"
+#include "JsonStream.h"
+#include "OrderedTasks.h"
+#include "MappedCsv.h"
+#include "CsvCache.h"
 
 #include <QFile> // 文件读写
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QPromise>
+#include <QBuffer>
+#include <QThread>
 #include <QTextStream> // 格式化文件读写
 #include <QDebug>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QCryptographicHash>
+#include <deque>
+#include <memory>
+
+// CSV并行导出任务：把[begin, end)范围内的行格式化到独立缓冲区
+class CsvExportChunk : public QRunnable
+{
+public:
+    static constexpr int TargetCells = 64 * 1024; // 每个任务大约处理的单元格数
+
+    CsvExportChunk(QMap<int, Worksheet::Row>::const_iterator begin, int firstRow, int columnCount)
+        : m_begin(begin)
+        , m_end(begin)
+        , m_firstRow(firstRow)
+        , m_endRow(firstRow)
+        , m_columnCount(columnCount)
+    {
+        setAutoDelete(false); // 由导出函数管理生命周期
+    }
+
+    // 设置结束位置：end为范围后的迭代器，endRow为范围后的行号（最后一个有数据的行之后可以是空行）
+    void setRange(QMap<int, Worksheet::Row>::const_iterator end, int endRow)
+    {
+        m_end = end;
+        m_endRow = endRow;
+    }
+
+    void run() override
+    {
+        int row = m_firstRow;
+        for (auto it = m_begin; it != m_end; ++it) {
+            for (; row < it.key(); ++row) {
+                CsvWriter::appendEmptyRow(m_data, m_columnCount); // 中间没有数据的行
+            }
+            CsvWriter::appendRow(m_data, it.value(), m_columnCount);
+            ++row;
+        }
+        for (; row < m_endRow; ++row) {
+            CsvWriter::appendEmptyRow(m_data, m_columnCount); // 只含空行的任务
+        }
+        m_done.release();
+    }
+
+    void wait() { m_done.acquire(); } // 等待格式化完成
+    const QByteArray &data() const { return m_data; }
+    int endRow() const { return m_endRow; }
+
+private:
+    QMap<int, Worksheet::Row>::const_iterator m_begin;
+    QMap<int, Worksheet::Row>::const_iterator m_end;
+    int m_firstRow;
+    int m_endRow;
+    int m_columnCount;
+    QByteArray m_data;
+    QSemaphore m_done;
+};
+
+namespace {
+
+// 打开的JSON工作簿：尚未载入的工作表共享该对象，全部载入后释放文件映射
+struct JsonSource {
+    QFile file;
+    QByteArray fallback; // 无法映射时的文件内容
+    const char *data = nullptr;
+    qsizetype size = 0;
+};
+
+// 在线程池中执行task(promise, progress)，由task通过promise交付结果：进度换算为0..ProgressSteps，
+// future被取消后progress返回false，由task在检查点中止
+template <typename Result, typename Task>
+QFuture<Result> startTask(Task task)
+{
+    auto promise = std::make_shared<QPromise<Result>>();
+    QFuture<Result> future = promise->future();
+
+    QThreadPool::globalInstance()->start([promise, task]() {
+        promise->start();
+        promise->setProgressRange(0, FileManager::ProgressSteps);
+        FileManager::ProgressCallback progress = [&promise](qint64 processed, qint64 total) {
+            if (total > 0) {
+                promise->setProgressValue(int(qBound<qint64>(0, processed, total) * FileManager::ProgressSteps / total));
+            }
+            return !promise->isCanceled();
+        };
+        task(*promise, progress);
+        promise->finish();
+    });
+    return future;
+}
+
+// 只有一个结果的任务：result = task(progress)
+template <typename Result, typename Task>
+QFuture<Result> runAsync(Task task)
+{
+    return startTask<Result>([task](QPromise<Result> &promise, const FileManager::ProgressCallback &progress) {
+        promise.addResult(task(progress));
+    });
+}
+
+// 从CSV旁路缓存交付（缓存中的每个工作表即一批），进度以批为单位。先载入全部批次再交付：
+// 缓存损坏时返回false且没有交付任何批次，由调用方改为重新解析；取消时也不交付
+bool publishCachedCsv(const QString &cacheFileName, QThread *thread,
+                      QPromise<std::shared_ptr<Worksheet>> &promise, const FileManager::ProgressCallback &progress)
+{
+    Workbook cached;
+    if (!SspFormat::load(&cached, cacheFileName)) {
+        return false;
+    }
+
+    const int count = cached.worksheetCount();
+    for (int i = 0; i < count; ++i) {
+        if (!cached.worksheet(i)->ensureLoaded()) {
+            return false;
+        }
+        if (progress && !progress(i + 1, count)) {
+            return true; // 取消
+        }
+    }
+
+    for (int i = 0; i < count; ++i) {
+        auto sheet = cached.worksheet(i);
+        if (!sheet->rows().isEmpty()) {
+            auto batch = std::make_shared<Worksheet>();
+            batch->takeCells(sheet.get());
+            batch->moveToThread(thread);
+            promise.addResult(batch);
+        }
+    }
+    return true;
+}
+
+// 分块读取CSV文件并分词，每块末尾不完整的行保留到下一块；进度以字节为单位。
+// hash非空时同时计算读入内容的哈希（CSV缓存的校验键），不必为此再读取一遍文件
+template <typename StoreField>
+bool tokenizeCsvFile(const QString &fileName, const CsvTokenizer::Dialect &dialect,
+                     StoreField &&storeField, const FileManager::ProgressCallback &progress,
+                     QCryptographicHash *hash = nullptr)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) { // 以二进制方式读取原始UTF-8字节，换行由分词器处理
+        return false;
+    }
+
+    CsvTokenizer tokenizer(dialect);
+    const qint64 chunkSize = 4 * 1024 * 1024;
+    QByteArray buffer;
+    bool firstChunk = true;
+
+    while (true) {
+        const QByteArray chunk = file.read(chunkSize);
+        if (hash) {
+            hash->addData(chunk);
+        }
+        buffer.append(chunk);
+        const bool atEnd = file.atEnd();
+
+        if (firstChunk && buffer.startsWith("\xEF\xBB\xBF")) { // 跳过UTF-8 BOM
+            buffer.remove(0, 3);
+        }
+        firstChunk = false;
+
+        qsizetype consumed = tokenizer.tokenize(buffer.constData(), buffer.size(), atEnd, storeField);
+        buffer.remove(0, consumed);
+
+        if (progress && !progress(file.pos(), file.size())) { // 中止时已读入的行保留
+            return false;
+        }
+        if (atEnd) {
+            break;
+        }
+    }
+
+    return true;
+}
+
+const int JsonFragmentCells = 64 * 1024; // 保存JSON时每个片段大约包含的单元格数
+
+// 工作表中的一段行：保存JSON时在线程池中序列化为逗号分隔的单元格元素
+struct JsonFragment {
+    const Worksheet *worksheet;
+    int sheetIndex;
+    QMap<int, Worksheet::Row>::const_iterator begin;
+    QMap<int, Worksheet::Row>::const_iterator end;
+    bool first; // 工作表的第一个片段：之前写出工作表的基本信息
+    bool last; // 最后一个片段：之后结束单元格数组与工作表对象
+};
+
+// 工作表对象的开头（基本信息与单元格数组的开始）与结尾
+void beginWorksheetJson(JsonStreamWriter &writer, const Worksheet *worksheet)
+{
+    writer.writeStartObject();
+    writer.writeName("name");
+    writer.writeString(worksheet->name());
+    writer.writeName("rowCount");
+    writer.writeInteger(worksheet->rowCount());
+    writer.writeName("columnCount");
+    writer.writeInteger(worksheet->columnCount());
+
+    // 只保存非空单元格，按行列顺序
+    writer.writeName("cells");
+    writer.writeStartArray();
+}
+
+void endWorksheetJson(JsonStreamWriter &writer)
+{
+    writer.writeEndArray();
+    writer.writeEndObject();
+}
+
+} // namespace
 
 // 保存
-bool FileManager::saveWorkbook(const Workbook *workbook, const QString &fileName)
+bool FileManager::saveWorkbook(const Workbook *workbook, const QString &fileName,
+                               const ProgressCallback &progress)
 {
     if (!workbook) return false;
 
-    // JSON根对象（解析和处理 JSON 的入口）
-    QJsonObject rootObject;
-    rootObject["version"] = "1.0";
-    rootObject["application"] = "Spreadsheet";
-
-    // 工作表转换为JSON并构建数组
-    QJsonArray worksheetsArray;
+    // 进度：先载入的工作表与写出的工作表合计
+    int pending = 0;
     for (int i = 0; i < workbook->worksheetCount(); ++i) {
         auto worksheet = workbook->worksheet(i);
-        if (worksheet) {
-            worksheetsArray.append(worksheetToJson(worksheet.get())); // 使用get获取原始指针
+        if (worksheet && !worksheet->isLoaded()) {
+            ++pending;
         }
     }
+    const qint64 total = pending + workbook->worksheetCount();
+    ProgressCallback loadProgress, writeProgress;
+    if (progress) {
+        loadProgress = [&](qint64 processed, qint64) { return progress(processed, total); };
+        writeProgress = [&](qint64 processed, qint64) { return progress(pending + processed, total); };
+    }
 
-    rootObject["worksheets"] = worksheetsArray;
-    rootObject["currentWorksheet"] = 0; // 默认设为第一个工作表
+    // 尚未载入的工作表先从原文件载入（可能正是要覆盖的文件）
+    if (!loadPendingWorksheets(workbook, loadProgress)) {
+        return false;
+    }
 
-    QJsonDocument doc(rootObject); // 封装为可序列化文档
+    // .ssp使用原生二进制格式，.xlsx保存为Excel工作簿，其余仍保存为JSON
+    const QString suffix = QFileInfo(fileName).suffix();
+    if (suffix.compare("ssp", Qt::CaseInsensitive) == 0) {
+        return SspFormat::save(workbook, fileName, writeProgress);
+    }
+    if (suffix.compare("xlsx", Qt::CaseInsensitive) == 0) {
+        return XlsxFormat::save(workbook, fileName, writeProgress);
+    }
 
-    // 写入文件
-    QFile file(fileName); // 创建文件对象
+    QSaveFile file(fileName); // 写入临时文件，提交时替换原文件；失败或中止时原文件不变
     if (!file.open(QIODevice::WriteOnly)) {
         qDebug() << "Failed to open file for writing:" << fileName;
         return false;
     }
 
-    file.write(doc.toJson()); // JSON序列化，写入文件对象
+    // 逐个单元格直接写出JSON，不构建完整文档
+    JsonStreamWriter writer(&file);
+    writer.writeStartObject();
+    writer.writeName("version");
+    writer.writeString("1.0");
+    writer.writeName("application");
+    writer.writeString("Spreadsheet");
+    writer.writeName("currentWorksheet"); // 打开时首先载入的工作表
+    writer.writeInteger(qMax(0, workbook->currentIndex()));
+
+    // 各工作表按行切分为片段（每段约JsonFragmentCells个单元格），在线程池中序列化后按顺序写入；
+    // 同时在途的片段数不超过线程数，内存占用与文件大小无关（只有一个大工作表时也是如此）
+    std::vector<JsonFragment> fragments;
+    for (int index = 0; index < workbook->worksheetCount(); ++index) {
+        const Worksheet *worksheet = workbook->worksheet(index).get();
+        if (!worksheet) {
+            continue;
+        }
+        const auto &rows = worksheet->rows();
+        auto begin = rows.cbegin();
+        qsizetype cells = 0;
+        bool first = true;
+        for (auto it = rows.cbegin(); it != rows.cend();) {
+            cells += it->size();
+            ++it;
+            if (cells >= JsonFragmentCells || it == rows.cend()) {
+                fragments.push_back(JsonFragment{worksheet, index, begin, it, first, it == rows.cend()});
+                begin = it;
+                cells = 0;
+                first = false;
+            }
+        }
+        if (first) { // 没有单元格的工作表
+            fragments.push_back(JsonFragment{worksheet, index, rows.cend(), rows.cend(), true, true});
+        }
+    }
+
+    writer.writeName("worksheets");
+    writer.writeStartArray();
+    const bool written = runOrdered<QByteArray>(int(fragments.size()), [&fragments](int index) {
+        const JsonFragment &fragment = fragments[index];
+        QByteArray data;
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        {
+            JsonStreamWriter fragmentWriter(&buffer);
+            fragmentWriter.writeStartArray();
+            for (auto rowIt = fragment.begin; rowIt != fragment.end; ++rowIt) {
+                for (auto it = rowIt->cbegin(); it != rowIt->cend(); ++it) {
+                    const Cell *cell = it->get();
+                    if (cell && !cell->isEmpty()) {
+                        writeCellJson(fragmentWriter, cell, rowIt.key(), it.key());
+                    }
+                }
+            }
+            fragmentWriter.writeEndArray();
+        }
+        data.chop(1); // 去掉数组的括号，只保留元素
+        data.remove(0, 1);
+        return data;
+    }, [&writer, &writeProgress, &fragments](int index, QByteArray &data) {
+        const JsonFragment &fragment = fragments[index];
+        if (fragment.first) {
+            beginWorksheetJson(writer, fragment.worksheet);
+        }
+        writer.writeRawElements(data);
+        if (fragment.last) {
+            endWorksheetJson(writer);
+        }
+        if (writeProgress && !writeProgress(fragment.sheetIndex + (fragment.last ? 1 : 0), 0)) {
+            return false;
+        }
+        return !writer.hasError();
+    });
+    writer.writeEndArray();
+    writer.writeEndObject();
+
+    if (!written || !writer.flush() || !file.commit()) {
+        qDebug() << "Failed to write file:" << fileName;
+        return false;
+    }
     return true;
 }
 
 // 打开文件
-bool FileManager::loadWorkbook(Workbook *workbook, const QString &fileName)
+bool FileManager::loadWorkbook(Workbook *workbook, const QString &fileName,
+                               const ProgressCallback &progress)
 {
     if (!workbook) return false;
 
-    QFile file(fileName);
-    if (!file.open(QIODevice::ReadOnly)) {
+    // 根据文件头识别二进制格式与.xlsx（ZIP容器）
+    if (SspFormat::isSspFile(fileName)) {
+        return SspFormat::load(workbook, fileName);
+    }
+    if (XlsxFormat::isXlsxFile(fileName)) {
+        return XlsxFormat::load(workbook, fileName);
+    }
+
+    auto source = std::make_shared<JsonSource>();
+    source->file.setFileName(fileName);
+    if (!source->file.open(QIODevice::ReadOnly)) {
         qDebug() << "Failed to open file for reading:" << fileName;
         return false;
     }
 
-    // JSON解析
-    QByteArray data = file.readAll();
-    QJsonDocument doc = QJsonDocument::fromJson(data); // 解析为JSON文档
+    // 优先内存映射整个文件，失败时退回一次性读取
+    source->size = source->file.size();
+    source->data = reinterpret_cast<const char *>(source->file.map(0, source->size));
+    if (!source->data) {
+        source->fallback = source->file.readAll();
+        source->data = source->fallback.constData();
+        source->size = source->fallback.size();
+    }
 
-    if (doc.isNull() || !doc.isObject()) { // 检查有效和是否为对象
+    // 扫描根对象，只定位各工作表的字节范围，单元格数组整体跳过
+    struct SheetRange {
+        QString name;
+        qsizetype offset;
+        qsizetype length;
+    };
+    QList<SheetRange> sheets;
+    QString version;
+    int currentSheet = 0;
+
+    JsonStreamReader reader(source->data, source->size);
+    if (reader.readNext() != JsonStreamReader::StartObject) { // 检查有效和是否为对象
         qDebug() << "Invalid JSON format";
         return false;
     }
+    while (reader.readNext() != JsonStreamReader::EndObject && !reader.hasError()) {
+        const QByteArrayView key = reader.name();
+        if (key == "version") {
+            version = reader.text();
+        }
+        else if (key == "currentWorksheet") {
+            currentSheet = int(reader.toInteger());
+        }
+        else if (key == "worksheets" && reader.tokenType() == JsonStreamReader::StartArray) {
+            while (reader.readNext() != JsonStreamReader::EndArray && !reader.hasError()) {
+                if (reader.tokenType() != JsonStreamReader::StartObject) { // 跳过非对象元素
+                    reader.skipCurrent();
+                    continue;
+                }
+                SheetRange sheet{QString(), reader.tokenOffset(), 0};
+                while (reader.readNext() != JsonStreamReader::EndObject && !reader.hasError()) {
+                    if (reader.name() == "name") {
+                        sheet.name = reader.text();
+                    }
+                    reader.skipCurrent();
+                }
+                sheet.length = reader.offset() - sheet.offset;
+                sheets.append(sheet);
+
+                if (progress && !progress(reader.offset(), source->size)) {
+                    return false;
+                }
+            }
+        }
+        else {
+            reader.skipCurrent();
+        }
+    }
 
-    QJsonObject rootObject = doc.object(); // 获取根对象
+    if (reader.hasError() || reader.readNext() != JsonStreamReader::EndDocument) {
+        qDebug() << "Invalid JSON format";
+        return false;
+    }
 
     // 检查版本兼容性
-    QString version = rootObject["version"].toString();
     if (version != "1.0") {
         qDebug() << "Unsupported file version:" << version;
         return false;
     }
 
     // 清空现有工作表
-    while (workbook->worksheetCount() > 0) {
-        workbook->removeWorksheet(0);
-    }
-
-    // 加载工作表
-    QJsonArray worksheetsArray = rootObject["worksheets"].toArray(); // 获取工作表数组
-    for (const QJsonValue &value : worksheetsArray) {
-        if (value.isObject()) {
-            // 工作表创建
-            QJsonObject worksheetObj = value.toObject();
-            QString name = worksheetObj["name"].toString();
-
-            workbook->addWorksheet(name);
-            auto worksheet = workbook->worksheet(workbook->worksheetCount() - 1);
-            if (worksheet) {
-                jsonToWorksheet(worksheetObj, worksheet.get()); // 数据转换，逆序列化
-            }
-        }
+    workbook->clear();
+
+    // 建立工作表目录，单元格在工作表首次使用时才流式读取
+    for (const SheetRange &sheet : sheets) {
+        workbook->addWorksheet(sheet.name);
+        auto worksheet = workbook->worksheet(workbook->worksheetCount() - 1);
+        worksheet->setLoader([source, sheet](Worksheet *target) {
+            JsonStreamReader sheetReader(source->data + sheet.offset, sheet.length);
+            return readWorksheetJson(sheetReader, target);
+        });
     }
 
     // 没有工作表，则创建一个默认工作表
     if (workbook->worksheetCount() == 0) {
         workbook->addWorksheet("Sheet1");
     }
+    workbook->setCurrentWorksheet(currentSheet);
+
+    // 立即载入当前工作表，其余工作表延迟到切换时载入
+    auto current = workbook->currentWorksheet();
+    if (current && !current->ensureLoaded()) {
+        qDebug() << "Invalid JSON format";
+        return false;
+    }
 
     return true;
 }
 
+// 并行载入所有尚未载入的工作表
+bool FileManager::loadPendingWorksheets(const Workbook *workbook, const ProgressCallback &progress)
+{
+    QList<std::shared_ptr<Worksheet>> pending;
+    QList<Worksheet::Loader> loaders; // 保留在当前线程，数据源（文件映射）在此线程释放
+    for (int i = 0; i < workbook->worksheetCount(); ++i) {
+        auto worksheet = workbook->worksheet(i);
+        if (worksheet && !worksheet->isLoaded()) {
+            pending.append(worksheet);
+            loaders.append(worksheet->takeLoader());
+        }
+    }
+
+    // 工作表所属的线程：异步保存时调用线程是工作线程，接管单元格须回到所属线程执行
+    QThread *thread = workbook->thread();
+    QList<bool> adopted(pending.size(), false);
+    bool ok = true;
+    runOrdered<std::shared_ptr<Worksheet>>(pending.size(), [&](int index) {
+        // 在工作线程中载入到无父对象的临时工作表，单元格随之属于该线程
+        auto sheet = std::make_shared<Worksheet>(pending.at(index)->name());
+        if (!loaders.at(index)(sheet.get())) {
+            return std::shared_ptr<Worksheet>();
+        }
+        sheet->moveToThread(thread); // 连同单元格交给工作簿所属线程，之后才能重新设置父对象
+        return sheet;
+    }, [&](int index, std::shared_ptr<Worksheet> &sheet) {
+        if (!sheet) {
+            qDebug() << "Failed to load worksheet:" << pending.at(index)->name();
+            ok = false;
+            return true;
+        }
+
+        Worksheet *target = pending.at(index).get();
+        if (QThread::currentThread() == thread) {
+            target->takeCells(sheet.get());
+        }
+        else {
+            QMetaObject::invokeMethod(target, [target, &sheet]() { target->takeCells(sheet.get()); },
+                                      Qt::BlockingQueuedConnection);
+        }
+        adopted[index] = true;
+
+        if (progress && !progress(index + 1, pending.size())) {
+            ok = false;
+            return false;
+        }
+        return true;
+    });
+
+    // 载入失败或中止的工作表恢复loader，之后仍可再次载入
+    for (int i = 0; i < pending.size(); ++i) {
+        if (!adopted.at(i)) {
+            pending.at(i)->setLoader(std::move(loaders[i]));
+        }
+    }
+
+    return ok;
+}
+
 // 导出为CSV
-bool FileManager::exportToCsv(const Worksheet *worksheet, const QString &fileName)
+bool FileManager::exportToCsv(const Worksheet *worksheet, const QString &fileName,
+                              const ProgressCallback &progress)
 {
     if (!worksheet) return false;
 
     QFile file(fileName);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) { //以只写文本模式（自动处理换行符）打开
+    if (!file.open(QIODevice::WriteOnly)) { // 由CsvWriter直接写出UTF-8字节
         return false;
     }
 
-    QTextStream stream(&file); // 创建文本流，绑定到file上
-
-    // 确定实际行列范围
-    int maxRow = 0, maxCol = 0;
-    for (int row = 0; row < worksheet->rowCount(); ++row) {
-        for (int col = 0; col < worksheet->columnCount(); ++col) {
-            auto cell = const_cast<Worksheet*>(worksheet)->cell(row, col); // 临时移除const，避免编译错误（cell方法没有const版本）
-            if (cell && (!cell->value().isNull() || !cell->formula().isEmpty())) {
-                maxRow = qMax(maxRow, row);
-                maxCol = qMax(maxCol, col); // 获取实际使用的最大行列号
+    // 确定实际行列范围（只遍历已分配的单元格，不再创建新单元格）
+    int maxRow = -1, maxCol = -1;
+    worksheet->usedRange(&maxRow, &maxCol);
+
+    CsvWriter writer(&file);
+    const auto &rows = worksheet->rows();
+
+    // 按行范围切分为任务，由线程池并行格式化；在途任务数有上限，保证内存占用恒定
+    QThreadPool *pool = QThreadPool::globalInstance();
+    const int maxInFlight = qMax(2, pool->maxThreadCount() * 2);
+    const int rowsPerChunk = qMax(1, CsvExportChunk::TargetCells / (maxCol + 1));
+
+    std::deque<std::unique_ptr<CsvExportChunk>> inFlight; // 按行序排列的在途任务
+    auto rowIt = rows.constBegin();
+    int nextRow = 0; // 下一个任务的起始行号
+    bool canceled = false; // 用户中止或写入失败
+
+    while (true) {
+        // 队列未满时继续提交任务
+        while (!canceled && int(inFlight.size()) < maxInFlight
+               && rowIt != rows.constEnd() && rowIt.key() <= maxRow) {
+            // 每个任务最多rowsPerChunk行（含中间的空行），稀疏的工作表中长段空行也分到多个任务
+            auto chunk = std::make_unique<CsvExportChunk>(rowIt, nextRow, maxCol + 1);
+            const qint64 spanEnd = qint64(nextRow) + rowsPerChunk;
+            const int firstRow = nextRow;
+            while (rowIt != rows.constEnd() && rowIt.key() <= maxRow && rowIt.key() < spanEnd) {
+                nextRow = rowIt.key() + 1;
+                ++rowIt;
             }
+            if (nextRow == firstRow) {
+                nextRow = int(spanEnd); // 范围内只有空行，下一个有数据的行在spanEnd之后
+            }
+            chunk->setRange(rowIt, nextRow);
+            pool->start(chunk.get());
+            inFlight.push_back(std::move(chunk));
         }
-    }
 
-    // 导出数据
-    for (int row = 0; row <= maxRow; ++row) {
-        QStringList rowData; // 保存当前行每一格的数据
-        for (int col = 0; col <= maxCol; ++col) {
-            auto cell = const_cast<Worksheet*>(worksheet)->cell(row, col);
-            QString cellValue;
-            if (cell) {
-                cellValue = cell->value().toString(); // 将单元格值转换为字符串
-                // CSV格式：如果单元格内容包含逗号或引号，需要用双引号整个包围
-                if (cellValue.contains(',') || cellValue.contains('"') || cellValue.contains('\n')) {
-                    cellValue.replace('"', "\"\""); // 双引号转义为两个双引号
-                    cellValue = '"' + cellValue + '"';
-                }
+        if (inFlight.empty()) {
+            break;
+        }
+
+        // 按顺序取出队首任务写入文件；任务尚未开始时由当前线程直接执行
+        std::unique_ptr<CsvExportChunk> chunk = std::move(inFlight.front());
+        inFlight.pop_front();
+        const bool taken = pool->tryTake(chunk.get());
+
+        if (canceled) { // 已取消：丢弃未开始的任务，等待已开始的任务结束
+            if (!taken) {
+                chunk->wait();
             }
-            rowData << cellValue; // 加入行数据
+            continue;
+        }
+
+        if (taken) {
+            chunk->run();
+        }
+        chunk->wait();
+        writer.writeRaw(chunk->data());
+        if (writer.hasError()) { // 磁盘已满等：不再格式化剩余的行
+            canceled = true;
+            continue;
         }
-        stream << rowData.join(',') << '\n'; // 每个单元格数据以逗号作为字段分隔符连接成一行写入流中
+
+        // 回调返回false时中止导出
+        if (progress && !progress(chunk->endRow(), maxRow + 1)) {
+            canceled = true;
+        }
+    }
+
+    if (canceled) {
+        writer.discard();
+        file.remove(); // 删除不完整的文件
+        return false;
     }
 
+    if (!writer.flush()) {
+        file.remove();
+        return false;
+    }
+    if (progress) {
+        progress(maxRow + 1, maxRow + 1);
+    }
     return true;
 }
 
 // CSV导入
-bool FileManager::importFromCsv(Worksheet *worksheet, const QString &fileName)
+bool FileManager::importFromCsv(Worksheet *worksheet, const QString &fileName,
+                                const CsvTokenizer::Dialect &dialect, const ProgressCallback &progress)
 {
     if (!worksheet) return false;
 
-    QFile file(fileName);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        return false;
-    }
-
-    QTextStream stream(&file); // 创建文本流
-    int row = 0;
+    return tokenizeCsvFile(fileName, dialect, [worksheet, &dialect](int row, int col, const char *begin, qsizetype length) {
+        // 字段写入工作表时才解码为QString
+        worksheet->cell(row, col)->setValue(CsvTokenizer::decodeField(begin, length, dialect.quote));
+    }, progress);
+}
 
-    while (!stream.atEnd()) { // 逐行读取
-        QString line = stream.readLine(); // 保存当前行内容
-        QStringList fields; // 保存一行解析出的字段
+// 渐进式导入：在工作线程中按行号切分批次，每批填满后移交调用线程并立即交付
+QFuture<std::shared_ptr<Worksheet>> FileManager::importFromCsvProgressive(const QString &fileName,
+                                                                          const CsvTokenizer::Dialect &dialect,
+                                                                          bool useCache)
+{
+    using Batch = std::shared_ptr<Worksheet>;
+    QThread *thread = QThread::currentThread();
+    return startTask<Batch>([thread, fileName, dialect, useCache](QPromise<Batch> &promise, const ProgressCallback &progress) {
+        // 文件信息与缓存一致时再核对内容哈希（读取整个文件，报告进度，可取消），内容也一致才从缓存载入
+        const QByteArray fileInfoKey = useCache ? CsvCache::fileInfoKey(fileName, dialect) : QByteArray();
+        if (CsvCache::matchesFileInfo(fileName, fileInfoKey)) {
+            const QByteArray contentHash = CsvCache::contentHash(fileName, progress);
+            if (promise.isCanceled()) {
+                return;
+            }
+            if (CsvCache::isValid(fileName, CsvCache::sourceKey(fileInfoKey, contentHash))) {
+                if (publishCachedCsv(CsvCache::cacheFileName(fileName), thread, promise, progress)) {
+                    return;
+                }
+                qDebug() << "Ignoring corrupted CSV cache:" << CsvCache::cacheFileName(fileName);
+            }
+        }
 
-        // CSV解析（处理引号和逗号）
-        bool inQuotes = false; // 标记当前是否在引号内
-        QString currentField;
+        // 解析的同时把每批写入新的缓存并计算内容哈希，完成时写入校验键；无法写入（如目录只读）时不使用缓存
+        std::unique_ptr<SspFormat::Writer> cache;
+        QCryptographicHash contentHash(CsvCache::HashAlgorithm);
+        if (!fileInfoKey.isEmpty()) {
+            cache = std::make_unique<SspFormat::Writer>(CsvCache::cacheFileName(fileName));
+            if (!cache->open(0, CsvCache::sourceKey(fileInfoKey, QByteArray()))) { // 占位，完成时替换
+                cache.reset();
+            }
+        }
 
-        for (int i = 0; i < line.length(); ++i) { // 遍历当前行每个字符
-            QChar c = line[i];
+        Batch batch = std::make_shared<Worksheet>();
+        int batchEnd = FirstBatchRows; // 当前批次之后的第一行
 
-            if (c == '"') { // 遇到引号
-                if (inQuotes && i + 1 < line.length() && line[i + 1] == '"') { // 如果在引号内，且下一个字符仍为引号，说明为转义的双引号
-                    currentField += '"';
-                    ++i; // 跳过下一个引号
-                }
-                else { // 遇到左引号则为true，右引号则为false
-                    inQuotes = !inQuotes;
+        auto publish = [&]() {
+            if (!batch->rows().isEmpty()) {
+                if (cache && !cache->addWorksheet(batch.get())) {
+                    cache.reset();
                 }
+                batch->moveToThread(thread); // 交付后工作线程不再访问
+                promise.addResult(batch);
+                batch = std::make_shared<Worksheet>();
             }
-            else if (c == ',' && !inQuotes) { // 遇到逗号，且不在引号内，说明为字段分隔符
-                fields << currentField; // 当前字段为一个单元格内容，加入
-                currentField.clear();
+        };
+
+        const bool ok = tokenizeCsvFile(fileName, dialect, [&](int row, int col, const char *begin, qsizetype length) {
+            if (row >= batchEnd) {
+                publish();
+                batchEnd = row + BatchRows;
             }
-            else { // 其他字符，直接加入当前字段
-                currentField += c;
+            batch->cell(row, col)->setValue(CsvTokenizer::decodeField(begin, length, dialect.quote));
+        }, progress, cache ? &contentHash : nullptr);
+
+        if (ok) {
+            publish();
+            if (cache) {
+                // 完整读入后才提交缓存，取消或失败时丢弃
+                cache->finish(CsvCache::sourceKey(fileInfoKey, contentHash.result()));
             }
         }
-        fields << currentField; // 单独将最后一个字段加入（结尾没有逗号）
-
-        // 将数据写入工作表
-        for (int col = 0; col < fields.size(); ++col) {
-            auto cell = worksheet->cell(row, col);
-            cell->setValue(fields[col]);
+        else if (!promise.isCanceled()) {
+            promise.addResult(Batch()); // 读取失败
         }
+    });
+}
 
-        ++row;
-    }
+// 异步保存
+QFuture<bool> FileManager::saveWorkbookAsync(const Workbook *workbook, const QString &fileName)
+{
+    return runAsync<bool>([workbook, fileName](const ProgressCallback &progress) {
+        return saveWorkbook(workbook, fileName, progress);
+    });
+}
 
-    return true;
+// 异步导出CSV
+QFuture<bool> FileManager::exportToCsvAsync(const Worksheet *worksheet, const QString &fileName)
+{
+    return runAsync<bool>([worksheet, fileName](const ProgressCallback &progress) {
+        return exportToCsv(worksheet, fileName, progress);
+    });
 }
 
-// 工作表转换为JSON
-QJsonObject FileManager::worksheetToJson(const Worksheet *worksheet)
+// 异步导出Arrow
+QFuture<bool> FileManager::exportToArrowAsync(const Worksheet *worksheet, const QString &fileName)
 {
-    // 保存基本信息
-    QJsonObject worksheetObj;
-    worksheetObj["name"] = worksheet->name();
-    worksheetObj["rowCount"] = worksheet->rowCount();
-    worksheetObj["columnCount"] = worksheet->columnCount();
-
-    QJsonArray cellsArray;
-
-    // 只保存非空单元格
-    for (int row = 0; row < worksheet->rowCount(); ++row) {
-        for (int col = 0; col < worksheet->columnCount(); ++col) {
-            auto cell = const_cast<Worksheet*>(worksheet)->cell(row, col);
-            if (cell && (!cell->value().isNull() || !cell->formula().isEmpty())) {
-                QJsonObject cellObj = cellToJson(cell.get());
-                cellObj["row"] = row;
-                cellObj["column"] = col;
-                cellsArray.append(cellObj);
-            }
-        }
-    }
+    return runAsync<bool>([worksheet, fileName](const ProgressCallback &progress) {
+        return ArrowFormat::exportWorksheet(worksheet, fileName, progress);
+    });
+}
 
-    worksheetObj["cells"] = cellsArray;
-    return worksheetObj;
+// 异步打开：在工作线程中载入到新建的工作簿，完成后连同工作表、单元格移交调用线程
+QFuture<std::shared_ptr<Workbook>> FileManager::loadWorkbookAsync(const QString &fileName)
+{
+    QThread *thread = QThread::currentThread();
+    return runAsync<std::shared_ptr<Workbook>>([thread, fileName](const ProgressCallback &progress) {
+        auto workbook = std::make_shared<Workbook>();
+        if (!loadWorkbook(workbook.get(), fileName, progress)) {
+            return std::shared_ptr<Workbook>();
+        }
+        workbook->moveToThread(thread);
+        return workbook;
+    });
 }
 
-// JSON转换为工作表
-void FileManager::jsonToWorksheet(const QJsonObject &json, Worksheet *worksheet)
+// 异步导入Arrow：在工作线程中读入新的工作表，完成后连同单元格移交调用线程
+QFuture<std::shared_ptr<Worksheet>> FileManager::importFromArrowAsync(const QString &fileName)
 {
-    worksheet->setName(json["name"].toString());
+    QThread *thread = QThread::currentThread();
+    return runAsync<std::shared_ptr<Worksheet>>([thread, fileName](const ProgressCallback &progress) {
+        auto worksheet = std::make_shared<Worksheet>();
+        if (!ArrowFormat::importWorksheet(worksheet.get(), fileName, progress)) {
+            return std::shared_ptr<Worksheet>();
+        }
+        worksheet->moveToThread(thread);
+        return worksheet;
+    });
+}
 
-    // 调整工作表大小
-    int rowCount = json["rowCount"].toInt();
-    int colCount = json["columnCount"].toInt();
+// 只读查看CSV：索引建立完成后对象只在调用线程中使用
+QFuture<std::shared_ptr<MappedCsv>> FileManager::openMappedCsvAsync(const QString &fileName,
+                                                                    const CsvTokenizer::Dialect &dialect)
+{
+    return runAsync<std::shared_ptr<MappedCsv>>([fileName, dialect](const ProgressCallback &progress) {
+        auto csv = std::make_shared<MappedCsv>(dialect);
+        if (!csv->open(fileName, progress)) {
+            return std::shared_ptr<MappedCsv>();
+        }
+        return csv;
+    });
+}
 
-    // resize方法
+// 工作表写出为JSON
+void FileManager::writeWorksheetJson(JsonStreamWriter &writer, const Worksheet *worksheet)
+{
+    beginWorksheetJson(writer, worksheet);
+    const auto &rows = worksheet->rows();
+    for (auto rowIt = rows.cbegin(); rowIt != rows.cend(); ++rowIt) {
+        for (auto it = rowIt->cbegin(); it != rowIt->cend(); ++it) {
+            const Cell *cell = it->get();
+            if (cell && !cell->isEmpty()) {
+                writeCellJson(writer, cell, rowIt.key(), it.key());
+            }
+        }
+    }
+    endWorksheetJson(writer);
+}
 
-    // 加载单元格数据
-    QJsonArray cellsArray = json["cells"].toArray();
-    for (const QJsonValue &value : cellsArray) {
-        if (value.isObject()) {
-            QJsonObject cellObj = value.toObject();
-            int row = cellObj["row"].toInt();
-            int col = cellObj["column"].toInt();
+// 从JSON流式读取工作表
+bool FileManager::readWorksheetJson(JsonStreamReader &reader, Worksheet *worksheet)
+{
+    if (reader.readNext() != JsonStreamReader::StartObject) {
+        return false;
+    }
 
-            auto cell = worksheet->cell(row, col);
-            jsonToCell(cellObj, cell.get());
+    int rowCount = worksheet->rowCount();
+    int colCount = worksheet->columnCount();
+    while (reader.readNext() != JsonStreamReader::EndObject && !reader.hasError()) {
+        const QByteArrayView key = reader.name();
+        if (key == "name") {
+            worksheet->setName(reader.text());
+        }
+        else if (key == "cells" && reader.tokenType() == JsonStreamReader::StartArray) {
+            // 加载单元格数据
+            while (reader.readNext() != JsonStreamReader::EndArray && !reader.hasError()) {
+                if (reader.tokenType() == JsonStreamReader::StartObject) {
+                    readCellJson(reader, worksheet);
+                }
+                else {
+                    reader.skipCurrent();
+                }
+            }
+        }
+        else if (key == "rowCount" && reader.tokenType() == JsonStreamReader::Number) {
+            rowCount = int(qBound<qint64>(1, reader.toInteger(), Worksheet::MaxRows));
+        }
+        else if (key == "columnCount" && reader.tokenType() == JsonStreamReader::Number) {
+            colCount = int(qBound<qint64>(1, reader.toInteger(), Worksheet::MaxColumns));
+        }
+        else {
+            reader.skipCurrent();
         }
     }
+
+    worksheet->setSize(rowCount, colCount); // 不小于读入的单元格范围
+    return !reader.hasError();
 }
 
-// 单元格转为JSON
-QJsonObject FileManager::cellToJson(const Cell *cell)
+// 单元格写出为JSON
+void FileManager::writeCellJson(JsonStreamWriter &writer, const Cell *cell, int row, int col)
 {
-    QJsonObject cellObj;
+    writer.writeStartObject();
+    writer.writeName("row");
+    writer.writeInteger(row);
+    writer.writeName("column");
+    writer.writeInteger(col);
 
     if (!cell->formula().isEmpty()) {
-        cellObj["formula"] = cell->formula();
+        writer.writeName("formula");
+        writer.writeString(cell->formula());
     }
 
-    cellObj["value"] = QJsonValue::fromVariant(cell->value());
-    cellObj["readOnly"] = cell->isReadOnly();
-
-    return cellObj;
+    writer.writeName("value");
+    writer.writeValue(cell->value());
+    writer.writeName("readOnly");
+    writer.writeBool(cell->isReadOnly());
+    writer.writeEndObject();
 }
 
-// JSON转为单元格
-void FileManager::jsonToCell(const QJsonObject &json, Cell *cell)
+// 从JSON读取单元格：reader位于单元格对象的起始处
+void FileManager::readCellJson(JsonStreamReader &reader, Worksheet *worksheet)
 {
-    if (json.contains("formula")) {
-        cell->setFormula(json["formula"].toString());
+    int row = -1;
+    int col = -1;
+    QString formula;
+    bool hasFormula = false;
+    QVariant value;
+    bool readOnly = false;
+
+    while (reader.readNext() != JsonStreamReader::EndObject && !reader.hasError()) {
+        const QByteArrayView key = reader.name();
+        if (key == "row") {
+            row = int(reader.toInteger());
+        }
+        else if (key == "column") {
+            col = int(reader.toInteger());
+        }
+        else if (key == "formula") {
+            formula = reader.text();
+            hasFormula = true;
+        }
+        else if (key == "value") {
+            value = reader.value();
+        }
+        else if (key == "readOnly") {
+            readOnly = reader.toBool();
+        }
+        reader.skipCurrent(); // 跳过嵌套的对象或数组
     }
-    else {
-        cell->setValue(json["value"].toVariant());
+
+    if (reader.hasError() || row < 0 || col < 0) {
+        return;
     }
 
-    cell->setReadOnly(json["readOnly"].toBool());
+    auto cell = worksheet->cell(row, col);
+    if (hasFormula) {
+        cell->setFormula(formula);
+    }
+    else {
+        cell->setValue(value);
+    }
+    cell->setReadOnly(readOnly);
 }
@@ -1,27 +1,69 @@
 #pragma once
 #include <QString>
-#include <QJsonObject>
-#include <QJsonDocument>
-#include <QJsonArray>
+#include <QFuture>
 #include "Workbook.h"
+#include "CsvTokenizer.h"
+
+#include <functional>
+#include <memory>
+
+class JsonStreamReader;
+class JsonStreamWriter;
+class MappedCsv;
 
 class FileManager
 {
 public:
+    // 进度回调：已处理量与总量，返回false时中止操作
+    using ProgressCallback = std::function<bool(qint64 processed, qint64 total)>;
+
     // 文件保存与打开
-    static bool saveWorkbook(const Workbook *workbook, const QString &fileName);
-    static bool loadWorkbook(Workbook *workbook, const QString &fileName);
+    static bool saveWorkbook(const Workbook *workbook, const QString &fileName,
+                             const ProgressCallback &progress = ProgressCallback()); // 进度以工作表为单位，中止时原文件不变
+    static bool loadWorkbook(Workbook *workbook, const QString &fileName,
+                             const ProgressCallback &progress = ProgressCallback()); // 进度以字节为单位（扫描工作表目录）
 
     // CSV格式导入和导出
-    static bool exportToCsv(const Worksheet *worksheet, const QString &fileName);
-    static bool importFromCsv(Worksheet *worksheet, const QString &fileName);
+    static bool exportToCsv(const Worksheet *worksheet, const QString &fileName,
+                            const ProgressCallback &progress = ProgressCallback()); // 流式导出，进度以行为单位
+    static bool importFromCsv(Worksheet *worksheet, const QString &fileName,
+                              const CsvTokenizer::Dialect &dialect = CsvTokenizer::csvDialect(), // 分隔符与引号可配置（CSV/TSV）
+                              const ProgressCallback &progress = ProgressCallback()); // 进度以字节为单位
+
+    // 异步版本：在线程池中执行，返回的QFuture报告进度（0..ProgressSteps），调用cancel()即在下一个检查点中止。
+    // 完成前调用方不得修改传入的工作簿或工作表
+    static constexpr int ProgressSteps = 1000;
+    static QFuture<bool> saveWorkbookAsync(const Workbook *workbook, const QString &fileName);
+    static QFuture<bool> exportToCsvAsync(const Worksheet *worksheet, const QString &fileName);
+    static QFuture<bool> exportToArrowAsync(const Worksheet *worksheet, const QString &fileName); // 见ArrowFormat
+    // 载入到新的工作簿（已移交调用线程），失败或取消时结果为空
+    static QFuture<std::shared_ptr<Workbook>> loadWorkbookAsync(const QString &fileName);
+    // 导入Arrow文件到新的工作表（无父对象，已移交调用线程），失败或取消时结果为空
+    static QFuture<std::shared_ptr<Worksheet>> importFromArrowAsync(const QString &fileName);
+
+    // 渐进式导入：读入的行分批交付，future的第i个结果即第i批（无父对象的工作表，已移交调用线程，
+    // 行号即文件中的行号），由调用方逐批合并。首批只含首屏的FirstBatchRows行以便立即显示；
+    // 读取失败时最后一个结果为空，取消时已交付的批次仍然有效。
+    // useCache为true时使用旁路缓存（见CsvCache）：文件未改变则直接载入缓存，否则解析的同时重建缓存
+    static constexpr int FirstBatchRows = 100;
+    static constexpr int BatchRows = 50000;
+    static QFuture<std::shared_ptr<Worksheet>> importFromCsvProgressive(const QString &fileName,
+                                                                        const CsvTokenizer::Dialect &dialect,
+                                                                        bool useCache = false);
+
+    // 只读查看：映射CSV文件并在后台建立行索引（进度以字节为单位），失败或取消时结果为空
+    static QFuture<std::shared_ptr<MappedCsv>> openMappedCsvAsync(const QString &fileName,
+                                                                  const CsvTokenizer::Dialect &dialect);
 
 private:
-    // JSON转换
-    static QJsonObject worksheetToJson(const Worksheet *worksheet);
-    static void jsonToWorksheet(const QJsonObject &json, Worksheet *worksheet);
+    // 在线程池中载入所有尚未载入的工作表（每个工作表一个任务）；可在工作簿所属线程以外调用
+    static bool loadPendingWorksheets(const Workbook *workbook, const ProgressCallback &progress);
+
+    // JSON流式读写：单元格直接在工作表与文件之间转换，不经过QJsonObject
+    static void writeWorksheetJson(JsonStreamWriter &writer, const Worksheet *worksheet);
+    static bool readWorksheetJson(JsonStreamReader &reader, Worksheet *worksheet);
 
-    static QJsonObject cellToJson(const Cell *cell);
-    static void jsonToCell(const QJsonObject &json, Cell *cell);
+    static void writeCellJson(JsonStreamWriter &writer, const Cell *cell, int row, int col);
+    static void readCellJson(JsonStreamReader &reader, Worksheet *worksheet);
 };
 
@@ -0,0 +1,609 @@
+#include "JsonStream.h"
+
+#include <charconv> // std::from_chars / std::to_chars
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+bool isSpace(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+int hexValue(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool readHex4(const char *p, const char *end, char32_t *value)
+{
+    if (end - p < 4) {
+        return false;
+    }
+    char32_t result = 0;
+    for (int i = 0; i < 4; ++i) {
+        const int digit = hexValue(p[i]);
+        if (digit < 0) {
+            return false;
+        }
+        result = (result << 4) | char32_t(digit);
+    }
+    *value = result;
+    return true;
+}
+
+void appendUtf8(QByteArray &out, char32_t code)
+{
+    if (code < 0x80) {
+        out += char(code);
+    }
+    else if (code < 0x800) {
+        out += char(0xC0 | (code >> 6));
+        out += char(0x80 | (code & 0x3F));
+    }
+    else if (code < 0x10000) {
+        out += char(0xE0 | (code >> 12));
+        out += char(0x80 | ((code >> 6) & 0x3F));
+        out += char(0x80 | (code & 0x3F));
+    }
+    else {
+        out += char(0xF0 | (code >> 18));
+        out += char(0x80 | ((code >> 12) & 0x3F));
+        out += char(0x80 | ((code >> 6) & 0x3F));
+        out += char(0x80 | (code & 0x3F));
+    }
+}
+
+// 需要转义的字节：引号、反斜杠和控制字符
+bool needsEscape(uchar c)
+{
+    return c < 0x20 || c == '"' || c == '\\';
+}
+
+void appendEscaped(QByteArray &out, const char *data, qsizetype size)
+{
+    static const char hex[] = "0123456789abcdef";
+    const char *run = data; // 尚未追加的无需转义的片段
+    const char *end = data + size;
+    for (const char *p = data; p < end; ++p) {
+        const uchar c = uchar(*p);
+        if (!needsEscape(c)) {
+            continue;
+        }
+        out.append(run, p - run);
+        run = p + 1;
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        case '\b': out += "\\b"; break;
+        case '\f': out += "\\f"; break;
+        default:
+            out += "\\u00";
+            out += hex[c >> 4];
+            out += hex[c & 0xF];
+            break;
+        }
+    }
+    out.append(run, end - run);
+}
+
+} // namespace
+
+// ---------------- JsonStreamReader ----------------
+
+JsonStreamReader::JsonStreamReader(const char *data, qsizetype size)
+    : m_data(data)
+    , m_pos(data)
+    , m_end(data + size)
+    , m_token(NoToken)
+    , m_valueBegin(data)
+    , m_valueEnd(data)
+    , m_hasEscapes(false)
+    , m_isInteger(false)
+    , m_needComma(false)
+    , m_finished(false)
+{
+}
+
+void JsonStreamReader::skipSpace()
+{
+    while (m_pos < m_end && isSpace(*m_pos)) {
+        ++m_pos;
+    }
+}
+
+const char *JsonStreamReader::scanString(const char *p, bool *hasEscapes) const
+{
+    *hasEscapes = false;
+    ++p; // 左引号
+    while (true) {
+        const char *quote = static_cast<const char *>(std::memchr(p, '"', m_end - p));
+        if (!quote) {
+            return nullptr;
+        }
+        // 引号前连续反斜杠为奇数个时，该引号被转义
+        const char *q = quote;
+        while (q > p && q[-1] == '\\') {
+            --q;
+        }
+        if (quote != p && std::memchr(p, '\\', quote - p)) {
+            *hasEscapes = true;
+        }
+        if ((quote - q) % 2 == 0) {
+            return quote;
+        }
+        p = quote + 1;
+    }
+}
+
+JsonStreamReader::TokenType JsonStreamReader::readNext()
+{
+    if (m_token == Invalid) {
+        return Invalid; // 出错后不再继续
+    }
+
+    m_name = QByteArrayView();
+    skipSpace();
+
+    if (m_finished) {
+        return m_pos == m_end ? (m_token = EndDocument) : fail();
+    }
+    if (m_pos >= m_end) {
+        return fail();
+    }
+
+    if (!m_stack.isEmpty()) {
+        const bool inObject = m_stack.last() == '{';
+        const char closing = inObject ? '}' : ']';
+        if (*m_pos == closing) {
+            m_valueBegin = m_pos++;
+            m_valueEnd = m_pos;
+            m_stack.removeLast();
+            m_needComma = true;
+            m_finished = m_stack.isEmpty();
+            return m_token = inObject ? EndObject : EndArray;
+        }
+        if (m_needComma) {
+            if (*m_pos != ',') {
+                return fail();
+            }
+            ++m_pos;
+            skipSpace();
+        }
+        if (inObject) {
+            bool escaped;
+            const char *keyEnd = m_pos < m_end && *m_pos == '"' ? scanString(m_pos, &escaped) : nullptr;
+            if (!keyEnd) {
+                return fail();
+            }
+            m_name = QByteArrayView(m_pos + 1, keyEnd - m_pos - 1);
+            m_pos = keyEnd + 1;
+            skipSpace();
+            if (m_pos >= m_end || *m_pos != ':') {
+                return fail();
+            }
+            ++m_pos;
+            skipSpace();
+        }
+        if (m_pos >= m_end) {
+            return fail();
+        }
+    }
+
+    // 值
+    m_valueBegin = m_pos;
+    m_needComma = true;
+    switch (*m_pos) {
+    case '{':
+    case '[':
+        m_stack.append(*m_pos);
+        m_needComma = false;
+        m_valueEnd = ++m_pos;
+        return m_token = (*m_valueBegin == '{') ? StartObject : StartArray;
+    case '"': {
+        const char *quote = scanString(m_pos, &m_hasEscapes);
+        if (!quote) {
+            return fail();
+        }
+        m_valueBegin = m_pos + 1;
+        m_valueEnd = quote;
+        m_pos = quote + 1;
+        m_token = String;
+        break;
+    }
+    case 't':
+    case 'f':
+    case 'n': {
+        const char *literal = *m_pos == 't' ? "true" : (*m_pos == 'f' ? "false" : "null");
+        const qsizetype length = qsizetype(std::strlen(literal));
+        if (m_end - m_pos < length || std::memcmp(m_pos, literal, length) != 0) {
+            return fail();
+        }
+        m_pos += length;
+        m_valueEnd = m_pos;
+        m_token = *literal == 'n' ? Null : Bool;
+        break;
+    }
+    default: {
+        m_isInteger = true;
+        while (m_pos < m_end) {
+            const char c = *m_pos;
+            if (c == '.' || c == 'e' || c == 'E') {
+                m_isInteger = false;
+            }
+            else if (!(c >= '0' && c <= '9') && c != '-' && c != '+') {
+                break;
+            }
+            ++m_pos;
+        }
+        if (m_pos == m_valueBegin) {
+            return fail();
+        }
+        m_valueEnd = m_pos;
+        m_token = Number;
+        break;
+    }
+    }
+
+    m_finished = m_stack.isEmpty();
+    return m_token;
+}
+
+void JsonStreamReader::skipCurrent()
+{
+    if (m_token != StartObject && m_token != StartArray) {
+        return;
+    }
+
+    int depth = 1;
+    while (m_pos < m_end) {
+        const char c = *m_pos;
+        if (c == '"') {
+            bool escaped;
+            const char *quote = scanString(m_pos, &escaped);
+            if (!quote) {
+                break;
+            }
+            m_pos = quote + 1;
+            continue;
+        }
+        ++m_pos;
+        if (c == '{' || c == '[') {
+            ++depth;
+        }
+        else if ((c == '}' || c == ']') && --depth == 0) {
+            m_token = (c == '}') ? EndObject : EndArray;
+            m_valueEnd = m_pos;
+            m_stack.removeLast();
+            m_needComma = true;
+            m_finished = m_stack.isEmpty();
+            return;
+        }
+    }
+    fail();
+}
+
+QString JsonStreamReader::text() const
+{
+    if (m_token != String) {
+        return QString();
+    }
+    if (!m_hasEscapes) {
+        return QString::fromUtf8(m_valueBegin, m_valueEnd - m_valueBegin);
+    }
+
+    QByteArray decoded;
+    decoded.reserve(m_valueEnd - m_valueBegin);
+    const char *run = m_valueBegin;
+    for (const char *p = m_valueBegin; p < m_valueEnd; ++p) {
+        if (*p != '\\') {
+            continue;
+        }
+        decoded.append(run, p - run);
+        if (++p >= m_valueEnd) {
+            break;
+        }
+        switch (*p) {
+        case 'n': decoded += '\n'; break;
+        case 'r': decoded += '\r'; break;
+        case 't': decoded += '\t'; break;
+        case 'b': decoded += '\b'; break;
+        case 'f': decoded += '\f'; break;
+        case 'u': {
+            char32_t code;
+            if (!readHex4(p + 1, m_valueEnd, &code)) {
+                break;
+            }
+            p += 4;
+            // 代理对
+            char32_t low;
+            if (code >= 0xD800 && code < 0xDC00 && m_valueEnd - p > 6 && p[1] == '\\' && p[2] == 'u'
+                && readHex4(p + 3, m_valueEnd, &low) && low >= 0xDC00 && low < 0xE000) {
+                code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                p += 6;
+            }
+            appendUtf8(decoded, code);
+            break;
+        }
+        default: decoded += *p; break; // \" \\ \/
+        }
+        run = p + 1;
+    }
+    decoded.append(run, m_valueEnd - run);
+    return QString::fromUtf8(decoded);
+}
+
+qint64 JsonStreamReader::toInteger() const
+{
+    if (m_token != Number) {
+        return 0;
+    }
+    if (!m_isInteger) {
+        return qint64(toDouble());
+    }
+    qint64 value = 0;
+    const auto result = std::from_chars(m_valueBegin, m_valueEnd, value);
+    if (result.ec != std::errc()) {
+        return qint64(toDouble()); // 超出范围
+    }
+    return value;
+}
+
+double JsonStreamReader::toDouble() const
+{
+    if (m_token != Number) {
+        return 0.0;
+    }
+    double value = 0.0;
+    std::from_chars(m_valueBegin, m_valueEnd, value);
+    return value;
+}
+
+QVariant JsonStreamReader::value() const
+{
+    switch (m_token) {
+    case String:
+        return text();
+    case Number:
+        if (m_isInteger) {
+            qint64 value;
+            const auto result = std::from_chars(m_valueBegin, m_valueEnd, value);
+            if (result.ec == std::errc() && result.ptr == m_valueEnd) {
+                return QVariant(qlonglong(value));
+            }
+        }
+        return toDouble();
+    case Bool:
+        return toBool();
+    default:
+        return QVariant();
+    }
+}
+
+// ---------------- JsonStreamWriter ----------------
+
+JsonStreamWriter::JsonStreamWriter(QIODevice *device, qsizetype bufferSize)
+    : m_device(device)
+    , m_bufferSize(bufferSize)
+    , m_afterName(false)
+    , m_error(false)
+{
+    m_buffer.reserve(bufferSize);
+}
+
+JsonStreamWriter::~JsonStreamWriter()
+{
+    flush();
+}
+
+void JsonStreamWriter::beginValue()
+{
+    if (m_afterName) { // 键之后紧跟值
+        m_afterName = false;
+        return;
+    }
+    if (!m_hasElements.isEmpty()) {
+        if (m_hasElements.last()) {
+            m_buffer += ',';
+        }
+        m_hasElements.last() = true;
+    }
+}
+
+void JsonStreamWriter::writeStartObject()
+{
+    if (m_error) {
+        return; // 写入失败后忽略之后的写入，缓冲区不再增长
+    }
+    beginValue();
+    m_buffer += '{';
+    m_hasElements.append(false);
+}
+
+void JsonStreamWriter::writeEndObject()
+{
+    if (m_error) {
+        return;
+    }
+    m_buffer += '}';
+    m_hasElements.removeLast();
+    flushIfFull();
+}
+
+void JsonStreamWriter::writeStartArray()
+{
+    if (m_error) {
+        return;
+    }
+    beginValue();
+    m_buffer += '[';
+    m_hasElements.append(false);
+}
+
+void JsonStreamWriter::writeEndArray()
+{
+    if (m_error) {
+        return;
+    }
+    m_buffer += ']';
+    m_hasElements.removeLast();
+    flushIfFull();
+}
+
+void JsonStreamWriter::writeName(QByteArrayView name)
+{
+    if (m_error) {
+        return;
+    }
+    beginValue();
+    m_buffer += '"';
+    m_buffer.append(name.data(), name.size());
+    m_buffer += "\":";
+    m_afterName = true;
+}
+
+void JsonStreamWriter::writeString(const QString &text)
+{
+    if (m_error) {
+        return;
+    }
+    beginValue();
+    const QByteArray utf8 = text.toUtf8();
+    m_buffer += '"';
+    appendEscaped(m_buffer, utf8.constData(), utf8.size());
+    m_buffer += '"';
+    flushIfFull();
+}
+
+void JsonStreamWriter::writeInteger(qint64 value)
+{
+    if (m_error) {
+        return;
+    }
+    beginValue();
+    char digits[24];
+    const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    m_buffer.append(digits, result.ptr - digits);
+}
+
+void JsonStreamWriter::writeDouble(double value)
+{
+    if (m_error) {
+        return;
+    }
+    if (!std::isfinite(value)) {
+        writeNull();
+        return;
+    }
+    beginValue();
+    char digits[32];
+    const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    m_buffer.append(digits, result.ptr - digits);
+}
+
+void JsonStreamWriter::writeBool(bool value)
+{
+    if (m_error) {
+        return;
+    }
+    beginValue();
+    m_buffer += value ? "true" : "false";
+}
+
+void JsonStreamWriter::writeNull()
+{
+    if (m_error) {
+        return;
+    }
+    beginValue();
+    m_buffer += "null";
+}
+
+void JsonStreamWriter::writeValue(const QVariant &value)
+{
+    switch (value.typeId()) {
+    case QMetaType::UnknownType:
+    case QMetaType::Nullptr:
+        writeNull();
+        break;
+    case QMetaType::Bool:
+        writeBool(value.toBool());
+        break;
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::LongLong:
+    case QMetaType::Short:
+    case QMetaType::UShort:
+    case QMetaType::Long:
+        writeInteger(value.toLongLong());
+        break;
+    case QMetaType::ULongLong:
+    case QMetaType::ULong:
+    case QMetaType::Double:
+    case QMetaType::Float:
+        writeDouble(value.toDouble());
+        break;
+    case QMetaType::QString:
+        writeString(value.toString());
+        break;
+    default:
+        // 日期等其他类型按QVariant::toString转换，无法转换时为null
+        if (value.canConvert<QString>()) {
+            writeString(value.toString());
+        }
+        else {
+            writeNull();
+        }
+        break;
+    }
+}
+
+void JsonStreamWriter::writeRawValue(const QByteArray &json)
+{
+    if (m_error) {
+        return;
+    }
+    beginValue();
+    if (m_buffer.size() + json.size() > m_bufferSize && !flush()) {
+        return;
+    }
+    if (json.size() >= m_bufferSize) { // 大块数据直接写入，避免额外拷贝
+        if (m_device->write(json) != json.size()) {
+            m_error = true;
+        }
+        return;
+    }
+    m_buffer.append(json);
+}
+
+void JsonStreamWriter::writeRawElements(const QByteArray &elements)
+{
+    if (!elements.isEmpty()) { // 与单个值相同：按需在前面加逗号
+        writeRawValue(elements);
+    }
+}
+
+bool JsonStreamWriter::flush()
+{
+    if (!m_buffer.isEmpty() && !m_error) {
+        if (m_device->write(m_buffer) != m_buffer.size()) {
+            m_error = true;
+        }
+    }
+    m_buffer.resize(0); // 保留已分配的容量；出错时丢弃的数据不再写出
+    return !m_error;
+}
+
+void JsonStreamWriter::flushIfFull()
+{
+    if (m_buffer.size() >= m_bufferSize) {
+        flush();
+    }
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QIODevice>
+#include <QString>
+#include <QVariant>
+#include <QVarLengthArray>
+
+// 流式JSON读取器（拉取式，用法类似QXmlStreamReader）：直接在内存（通常是文件映射）上逐个读取记号，
+// 不构建DOM，内存占用只与嵌套深度有关
+class JsonStreamReader
+{
+public:
+    enum TokenType {
+        NoToken,     // 尚未读取
+        Invalid,     // 语法错误
+        StartObject,
+        EndObject,
+        StartArray,
+        EndArray,
+        String,
+        Number,
+        Bool,
+        Null,
+        EndDocument
+    };
+
+    JsonStreamReader(const char *data, qsizetype size);
+
+    TokenType readNext(); // 读取下一个值或容器边界
+    TokenType tokenType() const { return m_token; }
+    bool hasError() const { return m_token == Invalid; }
+
+    // 当前值在对象中的键（原始字节，未处理转义）；数组元素为空
+    QByteArrayView name() const { return m_name; }
+
+    // 当前标量值
+    QString text() const; // String：解码转义后的文本
+    bool isInteger() const { return m_isInteger; } // Number：没有小数点和指数
+    qint64 toInteger() const;
+    double toDouble() const;
+    bool toBool() const { return m_token == Bool && *m_valueBegin == 't'; }
+    QVariant value() const; // 任意标量：字符串、qlonglong、double、bool，其余为空
+
+    // 跳过当前的对象或数组（按字节扫描，不逐个解析），其余记号无操作
+    void skipCurrent();
+
+    // 当前记号在输入中的起止偏移（容器的结束位置在skipCurrent或读到结束记号之后才确定）
+    qsizetype tokenOffset() const { return m_valueBegin - m_data; }
+    qsizetype offset() const { return m_pos - m_data; }
+
+private:
+    TokenType fail() { return m_token = Invalid; }
+    void skipSpace();
+    const char *scanString(const char *p, bool *hasEscapes) const; // p指向左引号，返回右引号位置
+
+    const char *m_data;
+    const char *m_pos;
+    const char *m_end;
+
+    TokenType m_token;
+    QByteArrayView m_name;
+    const char *m_valueBegin; // 字符串不含引号
+    const char *m_valueEnd;
+    bool m_hasEscapes;
+    bool m_isInteger;
+
+    QVarLengthArray<char, 16> m_stack; // 容器栈：'{'或'['
+    bool m_needComma; // 当前容器已有元素，下一个元素前应有逗号
+    bool m_finished;  // 顶层值已读完
+};
+
+// 增量JSON写出器：缓冲区满时整体写入设备，内存占用恒定；输出为紧凑格式
+class JsonStreamWriter
+{
+public:
+    explicit JsonStreamWriter(QIODevice *device, qsizetype bufferSize = 1024 * 1024);
+    ~JsonStreamWriter(); // 析构时写出剩余数据
+
+    void writeStartObject();
+    void writeEndObject();
+    void writeStartArray();
+    void writeEndArray();
+
+    void writeName(QByteArrayView name); // 对象成员的键，后接一个值（键不做转义）
+
+    void writeString(const QString &text);
+    void writeInteger(qint64 value);
+    void writeDouble(double value); // 非有限值写为null
+    void writeBool(bool value);
+    void writeNull();
+    void writeValue(const QVariant &value); // 与QJsonValue::fromVariant的映射一致
+    void writeRawValue(const QByteArray &json); // 写入已序列化的完整JSON值
+    void writeRawElements(const QByteArray &elements); // 在当前数组中追加已序列化的若干元素（逗号分隔，不含括号）
+
+    bool flush(); // 写出缓冲区，失败返回false；失败后（hasError）之后的写入均被忽略
+    bool hasError() const { return m_error; }
+
+private:
+    void beginValue(); // 按需写出分隔逗号
+    void flushIfFull();
+
+    QIODevice *m_device;
+    QByteArray m_buffer;
+    qsizetype m_bufferSize;
+    QVarLengthArray<bool, 16> m_hasElements; // 每层容器是否已有元素
+    bool m_afterName;
+    bool m_error;
+};
@@ -0,0 +1,173 @@
+#include "MappedCsv.h"
+
+#include <QDebug>
+#include <cstring>
+
+MappedCsv::MappedCsv(const CsvTokenizer::Dialect &dialect)
+    : m_dialect(dialect)
+    , m_data(nullptr)
+    , m_size(0)
+    , m_dataStart(0)
+    , m_rowCount(0)
+    , m_columnCount(0)
+{}
+
+MappedCsv::~MappedCsv()
+{
+    if (m_data) {
+        m_file.unmap(reinterpret_cast<uchar *>(const_cast<char *>(m_data)));
+    }
+}
+
+bool MappedCsv::open(const QString &fileName, const FileManager::ProgressCallback &progress)
+{
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        qDebug() << "Failed to open file for reading:" << fileName;
+        return false;
+    }
+
+    m_size = m_file.size();
+    if (m_size == 0) { // 空文件无需映射
+        return true;
+    }
+    uchar *mapped = m_file.map(0, m_size);
+    if (!mapped) {
+        qDebug() << "Failed to map file:" << fileName;
+        return false;
+    }
+    m_data = reinterpret_cast<const char *>(mapped);
+
+    if (!buildIndex(progress)) {
+        return false;
+    }
+
+    // 重新映射：扫描时读入的页不再计入本进程的常驻内存，之后只按需读入显示的行块
+    m_file.unmap(mapped);
+    m_data = reinterpret_cast<const char *>(m_file.map(0, m_size));
+    return m_data != nullptr;
+}
+
+bool MappedCsv::buildIndex(const FileManager::ProgressCallback &progress)
+{
+    m_dataStart = (m_size >= 3 && std::memcmp(m_data, "\xEF\xBB\xBF", 3) == 0) ? 3 : 0; // 跳过UTF-8 BOM
+    m_blockOffsets = {m_dataStart};
+    m_rowCount = 0;
+    m_columnCount = 0;
+
+    const qint64 progressInterval = 64 * 1024 * 1024; // 每64MB报告一次进度
+    quint64 quoteCarry = 0; // 上一块结束时是否仍在引号内（全1或全0）
+    int rowDelimiters = 0; // 当前行已出现的分隔符数
+    qint64 rowStart = m_dataStart;
+
+    for (qint64 base = m_dataStart; base < m_size; base += CsvTokenizer::BlockSize) {
+        CsvTokenizer::BlockMasks masks;
+        if (m_size - base >= CsvTokenizer::BlockSize) {
+            masks = CsvTokenizer::classifyBlock(m_data + base, m_dialect);
+        }
+        else { // 尾部不足64字节，补零后分类
+            char tail[CsvTokenizer::BlockSize];
+            std::memset(tail, 0, sizeof(tail));
+            std::memcpy(tail, m_data + base, size_t(m_size - base));
+            masks = CsvTokenizer::classifyBlock(tail, m_dialect);
+            const quint64 valid = (quint64(1) << (m_size - base)) - 1;
+            masks.quote &= valid;
+            masks.delimiter &= valid;
+            masks.newline &= valid;
+        }
+
+        const quint64 inQuotes = CsvTokenizer::prefixXor(masks.quote) ^ quoteCarry;
+        quoteCarry = quint64(qint64(inQuotes) >> 63);
+
+        quint64 delimiters = masks.delimiter & ~inQuotes;
+        quint64 newlines = masks.newline & ~inQuotes;
+        while (newlines) { // 每个行尾：累计本行分隔符数，按间隔记录下一行的起始偏移
+            const int bit = qCountTrailingZeroBits(newlines);
+            const quint64 upToNewline = (quint64(2) << bit) - 1; // bit为63时移位结果为0，减1得全1
+            rowDelimiters += qPopulationCount(delimiters & upToNewline);
+            delimiters &= ~upToNewline;
+
+            m_columnCount = qMax(m_columnCount, rowDelimiters + 1);
+            rowDelimiters = 0;
+            rowStart = base + bit + 1;
+            if (++m_rowCount % IndexStride == 0) {
+                m_blockOffsets.append(rowStart);
+            }
+            newlines &= newlines - 1;
+        }
+        rowDelimiters += qPopulationCount(delimiters);
+
+        if (progress && (base - m_dataStart) % progressInterval == 0 && !progress(base, m_size)) {
+            return false;
+        }
+    }
+
+    // 最后一行没有换行符结尾
+    if (rowStart < m_size) {
+        m_columnCount = qMax(m_columnCount, rowDelimiters + 1);
+        ++m_rowCount;
+    }
+    else if (m_rowCount % IndexStride == 0) {
+        m_blockOffsets.removeLast(); // 文件以换行结尾时，最后记录的偏移之后没有行
+    }
+
+    if (progress) {
+        progress(m_size, m_size);
+    }
+    return true;
+}
+
+QString MappedCsv::field(qint64 row, int col) const
+{
+    if (row < 0 || row >= m_rowCount || col < 0) {
+        return QString();
+    }
+
+    const Block &rows = block(row / IndexStride);
+    const int local = int(row % IndexStride);
+    if (local + 1 >= rows.rowStarts.size()) {
+        return QString();
+    }
+
+    const int index = rows.rowStarts.at(local) + col;
+    if (index >= rows.rowStarts.at(local + 1)) {
+        return QString(); // 该行字段数不足
+    }
+    const FieldRef &ref = rows.fields.at(index);
+    return CsvTokenizer::decodeField(m_data + ref.begin, ref.length, m_dialect.quote);
+}
+
+const MappedCsv::Block &MappedCsv::block(qint64 index) const
+{
+    for (int i = 0; i < m_cache.size(); ++i) {
+        if (m_cache.at(i).index == index) {
+            if (i > 0) {
+                m_cache.move(i, 0); // 移到最前
+            }
+            return m_cache.first();
+        }
+    }
+
+    // 解析行块：从索引记录的偏移开始，到下一个行块的起始位置为止
+    Block parsed;
+    parsed.index = index;
+    const qint64 begin = m_blockOffsets.at(index);
+    const qint64 end = index + 1 < m_blockOffsets.size() ? m_blockOffsets.at(index + 1) : m_size;
+
+    CsvTokenizer tokenizer(m_dialect);
+    int currentRow = -1;
+    tokenizer.tokenize(m_data + begin, qsizetype(end - begin), true,
+                       [&](int row, int, const char *fieldBegin, qsizetype length) {
+        for (; currentRow < row; ++currentRow) {
+            parsed.rowStarts.append(parsed.fields.size());
+        }
+        parsed.fields.append(FieldRef{fieldBegin - m_data, length});
+    });
+    parsed.rowStarts.append(parsed.fields.size());
+
+    if (m_cache.size() >= CachedBlocks) {
+        m_cache.removeLast();
+    }
+    m_cache.prepend(std::move(parsed));
+    return m_cache.first();
+}
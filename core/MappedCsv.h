@@ -0,0 +1,57 @@
+#pragma once
+
+#include <QFile>
+#include <QList>
+#include <QString>
+
+#include "CsvTokenizer.h"
+#include "FileManager.h"
+
+// 只读CSV文件映射：打开时扫描一遍整个文件（按64字节块分类，识别引号内的换行），
+// 每IndexStride行记录一次行首偏移，同时统计行数与最大列数。
+// 显示时按行块解析，只保留最近使用的少量行块的字段位置，内存占用与文件大小基本无关。
+// 打开后只能在一个线程中访问
+class MappedCsv
+{
+public:
+    static constexpr int IndexStride = 1024; // 索引间隔行数，也是解析与缓存的单位
+    static constexpr int CachedBlocks = 8; // 缓存的行块数
+
+    explicit MappedCsv(const CsvTokenizer::Dialect &dialect = CsvTokenizer::csvDialect());
+    ~MappedCsv();
+
+    bool open(const QString &fileName, const FileManager::ProgressCallback &progress = FileManager::ProgressCallback()); // 进度以字节为单位
+    QString fileName() const { return m_file.fileName(); }
+
+    qint64 rowCount() const { return m_rowCount; }
+    int columnCount() const { return m_columnCount; }
+
+    QString field(qint64 row, int col) const; // 不存在的行列返回空字符串
+
+private:
+    struct FieldRef { // 字段在文件中的位置（未解码）
+        qint64 begin;
+        qsizetype length;
+    };
+
+    struct Block { // 一个已解析的行块
+        qint64 index = -1;
+        QList<FieldRef> fields;
+        QList<int> rowStarts; // 每行第一个字段在fields中的位置，末尾多一项
+    };
+
+    bool buildIndex(const FileManager::ProgressCallback &progress);
+    const Block &block(qint64 index) const; // 取出行块，不在缓存中时解析
+
+    CsvTokenizer::Dialect m_dialect;
+    QFile m_file;
+    const char *m_data;
+    qint64 m_size;
+    qint64 m_dataStart; // 跳过UTF-8 BOM后的起始位置
+
+    QList<qint64> m_blockOffsets; // 第i个行块（第i * IndexStride行）的起始偏移
+    qint64 m_rowCount;
+    int m_columnCount;
+
+    mutable QList<Block> m_cache; // 最近使用的在前
+};
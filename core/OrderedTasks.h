@@ -0,0 +1,75 @@
+#pragma once
+
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <deque>
+#include <functional>
+#include <memory>
+
+// 线程池中的单个任务，结果由提交线程取回
+template <typename Result>
+class OrderedTask : public QRunnable
+{
+public:
+    explicit OrderedTask(std::function<Result()> function)
+        : m_function(std::move(function))
+    {
+        setAutoDelete(false); // 由提交方管理生命周期
+    }
+
+    void run() override
+    {
+        m_result = m_function();
+        m_done.release();
+    }
+
+    Result &wait()
+    {
+        m_done.acquire();
+        return m_result;
+    }
+
+private:
+    std::function<Result()> m_function;
+    Result m_result;
+    QSemaphore m_done;
+};
+
+// 在线程池中并行执行produce(i)（i = 0..count-1），并在调用线程中按i的顺序调用consume(i, result)。
+// 同时提交的任务数不超过线程数，以限制尚未消费的结果占用的内存；尚未开始的任务直接在调用线程执行。
+// produce必须可在多个线程中同时调用；consume返回false时不再消费，等待已开始的任务结束后返回false
+template <typename Result, typename Produce, typename Consume>
+bool runOrdered(int count, Produce produce, Consume consume)
+{
+    QThreadPool *pool = QThreadPool::globalInstance();
+    const size_t window = size_t(qMax(1, pool->maxThreadCount()));
+
+    std::deque<std::unique_ptr<OrderedTask<Result>>> inFlight;
+    int next = 0;
+    bool ok = true;
+
+    for (int i = 0; i < count && ok; ++i) {
+        while (next < count && inFlight.size() < window) {
+            const int index = next++;
+            auto task = std::make_unique<OrderedTask<Result>>([&produce, index]() { return produce(index); });
+            pool->start(task.get());
+            inFlight.push_back(std::move(task));
+        }
+
+        std::unique_ptr<OrderedTask<Result>> task = std::move(inFlight.front());
+        inFlight.pop_front();
+        if (pool->tryTake(task.get())) {
+            task->run();
+        }
+        ok = consume(i, task->wait());
+    }
+
+    // 中止：撤回尚未开始的任务，等待已开始的任务
+    for (auto &task : inFlight) {
+        if (!pool->tryTake(task.get())) {
+            task->wait();
+        }
+    }
+    return ok;
+}
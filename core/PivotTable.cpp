@@ -0,0 +1,399 @@
+#include "PivotTable.h"
+#include "OrderedTasks.h"
+#include "Cell.h"
+
+#include <QHash>
+#include <QPromise>
+#include <QThread>
+#include <QThreadPool>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+const int MinChunkRows = 1 << 16; // 行数少于此值时不分段
+
+struct Accumulator {
+    double sum = 0;
+    double minimum = std::numeric_limits<double>::infinity();
+    double maximum = -std::numeric_limits<double>::infinity();
+    qint64 numbers = 0; // 参与计算的数值个数
+    qint64 values = 0; // 非空单元格数
+
+    void add(const Cell *cell)
+    {
+        if (!cell || cell->isEmpty()) {
+            return;
+        }
+        ++values;
+
+        const QVariant value = cell->value();
+        bool ok = false;
+        double number = 0;
+        switch (value.typeId()) {
+        case QMetaType::Int:
+        case QMetaType::UInt:
+        case QMetaType::LongLong:
+        case QMetaType::ULongLong:
+        case QMetaType::Double:
+        case QMetaType::Float:
+            number = value.toDouble();
+            ok = true;
+            break;
+        case QMetaType::QString:
+            number = value.toString().toDouble(&ok); // CSV导入的数字以文本保存
+            break;
+        default:
+            break;
+        }
+        if (ok && !std::isnan(number)) {
+            sum += number;
+            minimum = qMin(minimum, number);
+            maximum = qMax(maximum, number);
+            ++numbers;
+        }
+    }
+
+    void merge(const Accumulator &other)
+    {
+        sum += other.sum;
+        minimum = qMin(minimum, other.minimum);
+        maximum = qMax(maximum, other.maximum);
+        numbers += other.numbers;
+        values += other.values;
+    }
+
+    QVariant result(PivotTable::Aggregate aggregate) const
+    {
+        if (aggregate == PivotTable::Count) {
+            return values;
+        }
+        if (numbers == 0) {
+            return QVariant(); // 没有数值时为空
+        }
+        switch (aggregate) {
+        case PivotTable::Sum:
+            return sum;
+        case PivotTable::Average:
+            return sum / double(numbers);
+        case PivotTable::Minimum:
+            return minimum;
+        case PivotTable::Maximum:
+            return maximum;
+        default:
+            return QVariant();
+        }
+    }
+};
+
+// 开放寻址（线性探测）的分组表：键为keyWidth个文本编号，每组valueCount个累加值
+class GroupTable
+{
+public:
+    GroupTable(int keyWidth, int valueCount)
+        : m_keyWidth(keyWidth)
+        , m_valueCount(valueCount)
+        , m_slots(64)
+    {}
+
+    int groupCount() const { return m_groupCount; }
+    const int *key(int group) const { return m_keys.data() + size_t(group) * m_keyWidth; }
+    Accumulator *accumulators(int group) { return m_accumulators.data() + size_t(group) * m_valueCount; }
+    const Accumulator *accumulators(int group) const { return m_accumulators.data() + size_t(group) * m_valueCount; }
+
+    // 返回键所在的分组，不存在时新建
+    int insert(const int *key)
+    {
+        const quint64 hash = hashKey(key);
+        const size_t mask = m_slots.size() - 1;
+        for (size_t i = hash & mask;; i = (i + 1) & mask) {
+            Slot &slot = m_slots[i];
+            if (slot.group < 0) {
+                const int group = m_groupCount++;
+                m_keys.insert(m_keys.end(), key, key + m_keyWidth);
+                m_accumulators.resize(m_accumulators.size() + m_valueCount);
+                slot = Slot{hash, group};
+                if (size_t(m_groupCount) * 2 > m_slots.size()) { // 负载不超过一半
+                    grow();
+                }
+                return group;
+            }
+            if (slot.hash == hash && std::equal(key, key + m_keyWidth, this->key(slot.group))) {
+                return slot.group;
+            }
+        }
+    }
+
+private:
+    struct Slot {
+        quint64 hash = 0;
+        int group = -1;
+    };
+
+    quint64 hashKey(const int *key) const
+    {
+        quint64 hash = 0x9E3779B97F4A7C15ull;
+        for (int i = 0; i < m_keyWidth; ++i) {
+            hash = (hash ^ quint32(key[i])) * 0xFF51AFD7ED558CCDull;
+            hash ^= hash >> 29;
+        }
+        return hash;
+    }
+
+    void grow()
+    {
+        std::vector<Slot> grown(m_slots.size() * 2);
+        const size_t mask = grown.size() - 1;
+        for (const Slot &slot : m_slots) {
+            if (slot.group >= 0) {
+                size_t i = slot.hash & mask;
+                while (grown[i].group >= 0) {
+                    i = (i + 1) & mask;
+                }
+                grown[i] = slot;
+            }
+        }
+        m_slots.swap(grown);
+    }
+
+    int m_keyWidth;
+    int m_valueCount;
+    int m_groupCount = 0;
+    std::vector<Slot> m_slots;
+    std::vector<int> m_keys;
+    std::vector<Accumulator> m_accumulators;
+};
+
+// 一段数据行的汇总结果：分组键为段内字典中的编号
+struct Partial {
+    std::vector<QStringList> dictionaries; // 每个分组列一个
+    std::shared_ptr<GroupTable> table;
+};
+
+Partial aggregateRows(const std::vector<const Worksheet::Row *> &rows, size_t begin, size_t end,
+                      const PivotTable::Spec &spec)
+{
+    const int keyWidth = int(spec.groupColumns.size());
+    Partial partial;
+    partial.dictionaries.resize(keyWidth);
+    partial.table = std::make_shared<GroupTable>(keyWidth, int(spec.values.size()));
+
+    std::vector<QHash<QString, int>> ids(keyWidth);
+    std::vector<int> key(keyWidth);
+    for (size_t i = begin; i < end; ++i) {
+        const Worksheet::Row &row = *rows[i];
+        for (int k = 0; k < keyWidth; ++k) {
+            const Cell *cell = row.value(spec.groupColumns.at(k)).get();
+            const QString text = cell ? cell->displayText() : QString();
+            auto it = ids[k].constFind(text);
+            if (it == ids[k].constEnd()) {
+                it = ids[k].insert(text, int(partial.dictionaries[k].size()));
+                partial.dictionaries[k].append(text);
+            }
+            key[k] = it.value();
+        }
+
+        Accumulator *accumulators = partial.table->accumulators(partial.table->insert(key.data()));
+        for (int v = 0; v < spec.values.size(); ++v) {
+            accumulators[v].add(row.value(spec.values.at(v).column).get());
+        }
+    }
+    return partial;
+}
+
+// 分组值的顺序：数字在前按数值，其余按文本（不区分大小写），空白在最后
+std::vector<int> rankTexts(const QStringList &texts)
+{
+    std::vector<int> order(texts.size());
+    std::vector<double> numbers(texts.size());
+    std::vector<bool> numeric(texts.size());
+    for (int i = 0; i < texts.size(); ++i) {
+        order[i] = i;
+        bool ok = false;
+        numbers[i] = texts.at(i).toDouble(&ok);
+        numeric[i] = ok && !std::isnan(numbers[i]);
+    }
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        if (texts.at(a).isEmpty() != texts.at(b).isEmpty()) {
+            return texts.at(b).isEmpty();
+        }
+        if (numeric[a] != numeric[b]) {
+            return bool(numeric[a]);
+        }
+        if (numeric[a]) {
+            return numbers[a] < numbers[b];
+        }
+        return QString::compare(texts.at(a), texts.at(b), Qt::CaseInsensitive) < 0;
+    });
+
+    std::vector<int> ranks(texts.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        ranks[order[i]] = int(i);
+    }
+    return ranks;
+}
+
+QString headerText(const Worksheet *source, int headerRow, int column)
+{
+    auto cell = source->cellAt(headerRow, column);
+    if (cell && !cell->displayText().isEmpty()) {
+        return cell->displayText();
+    }
+    QString label; // 没有标题时使用列名
+    for (int n = column; n >= 0; n = n / 26 - 1) {
+        label.prepend(QChar('A' + n % 26));
+    }
+    return label;
+}
+
+} // namespace
+
+QString PivotTable::aggregateName(Aggregate aggregate)
+{
+    switch (aggregate) {
+    case Sum: return "求和";
+    case Count: return "计数";
+    case Average: return "平均值";
+    case Minimum: return "最小值";
+    case Maximum: return "最大值";
+    }
+    return QString();
+}
+
+std::shared_ptr<Worksheet> PivotTable::build(const Worksheet *source, const Spec &spec,
+                                             const FileManager::ProgressCallback &progress)
+{
+    // 数据行
+    std::vector<const Worksheet::Row *> rows;
+    const QMap<int, Worksheet::Row> &sourceRows = source->rows();
+    for (auto it = sourceRows.lowerBound(spec.headerRow + 1); it != sourceRows.constEnd(); ++it) {
+        rows.push_back(&it.value());
+    }
+
+    // 分段汇总，按顺序合并到总表
+    const int keyWidth = int(spec.groupColumns.size());
+    const int valueCount = int(spec.values.size());
+    GroupTable total(keyWidth, valueCount);
+    std::vector<QStringList> dictionaries(keyWidth);
+    std::vector<QHash<QString, int>> ids(keyWidth);
+
+    const int threads = qMax(1, QThreadPool::globalInstance()->maxThreadCount());
+    const int chunks = int(qBound<size_t>(1, rows.size() / MinChunkRows, size_t(threads)));
+    const bool completed = runOrdered<Partial>(chunks, [&](int chunk) {
+        return aggregateRows(rows, rows.size() * chunk / chunks, rows.size() * (chunk + 1) / chunks, spec);
+    }, [&](int chunk, Partial &partial) {
+        std::vector<std::vector<int>> remap(keyWidth); // 段内编号 -> 全局编号
+        for (int k = 0; k < keyWidth; ++k) {
+            for (const QString &text : std::as_const(partial.dictionaries[k])) {
+                auto it = ids[k].constFind(text);
+                if (it == ids[k].constEnd()) {
+                    it = ids[k].insert(text, int(dictionaries[k].size()));
+                    dictionaries[k].append(text);
+                }
+                remap[k].push_back(it.value());
+            }
+        }
+
+        std::vector<int> key(keyWidth);
+        const GroupTable &table = *partial.table;
+        for (int group = 0; group < table.groupCount(); ++group) {
+            const int *localKey = table.key(group);
+            for (int k = 0; k < keyWidth; ++k) {
+                key[k] = remap[k][localKey[k]];
+            }
+            Accumulator *target = total.accumulators(total.insert(key.data()));
+            const Accumulator *accumulators = table.accumulators(group);
+            for (int v = 0; v < valueCount; ++v) {
+                target[v].merge(accumulators[v]);
+            }
+        }
+        partial.table.reset();
+        return !progress || progress(chunk + 1, chunks);
+    });
+    if (!completed) {
+        return nullptr;
+    }
+
+    // 各组按分组值的名次排序
+    std::vector<std::vector<int>> ranks(keyWidth);
+    for (int k = 0; k < keyWidth; ++k) {
+        ranks[k] = rankTexts(dictionaries[k]);
+    }
+    std::vector<int> groups(total.groupCount());
+    for (int group = 0; group < total.groupCount(); ++group) {
+        groups[group] = group;
+    }
+    std::sort(groups.begin(), groups.end(), [&](int a, int b) {
+        const int *keyA = total.key(a);
+        const int *keyB = total.key(b);
+        for (int k = 0; k < keyWidth; ++k) {
+            if (keyA[k] != keyB[k]) {
+                return ranks[k][keyA[k]] < ranks[k][keyB[k]];
+            }
+        }
+        return false;
+    });
+
+    // 写出：分组列在前（没有分组列时留一列写“总计”），随后每个汇总项一列
+    auto result = std::make_shared<Worksheet>();
+    const int labelColumns = qMax(keyWidth, 1);
+    for (int k = 0; k < keyWidth; ++k) {
+        result->cell(0, k)->setValue(headerText(source, spec.headerRow, spec.groupColumns.at(k)));
+    }
+    for (int v = 0; v < valueCount; ++v) {
+        const ValueField &field = spec.values.at(v);
+        result->cell(0, labelColumns + v)->setValue(
+            QString("%1项:%2").arg(aggregateName(field.aggregate), headerText(source, spec.headerRow, field.column)));
+    }
+
+    std::vector<Accumulator> grandTotal(valueCount);
+    int row = 1;
+    for (int group : groups) {
+        const int *key = total.key(group);
+        for (int k = 0; k < keyWidth; ++k) {
+            const QString &text = dictionaries[k].at(key[k]);
+            result->cell(row, k)->setValue(text.isEmpty() ? QString("(空白)") : text);
+        }
+        const Accumulator *accumulators = total.accumulators(group);
+        for (int v = 0; v < valueCount; ++v) {
+            grandTotal[v].merge(accumulators[v]);
+            const QVariant value = accumulators[v].result(spec.values.at(v).aggregate);
+            if (value.isValid()) {
+                result->cell(row, labelColumns + v)->setValue(value);
+            }
+        }
+        ++row;
+    }
+
+    result->cell(row, 0)->setValue(QString("总计"));
+    for (int v = 0; v < valueCount; ++v) {
+        const QVariant value = grandTotal[v].result(spec.values.at(v).aggregate);
+        if (value.isValid()) {
+            result->cell(row, labelColumns + v)->setValue(value);
+        }
+    }
+    return result;
+}
+
+QFuture<std::shared_ptr<Worksheet>> PivotTable::buildAsync(const Worksheet *source, const Spec &spec)
+{
+    QThread *thread = QThread::currentThread();
+    auto promise = std::make_shared<QPromise<std::shared_ptr<Worksheet>>>();
+    QFuture<std::shared_ptr<Worksheet>> future = promise->future();
+
+    QThreadPool::globalInstance()->start([promise, source, spec, thread]() {
+        promise->start();
+        promise->setProgressRange(0, FileManager::ProgressSteps);
+        auto result = build(source, spec, [&promise](qint64 processed, qint64 total) {
+            promise->setProgressValue(int(processed * FileManager::ProgressSteps / qMax<qint64>(total, 1)));
+            return !promise->isCanceled();
+        });
+        if (result) {
+            result->moveToThread(thread); // 连同单元格交给调用线程
+        }
+        promise->addResult(result);
+        promise->finish();
+    });
+    return future;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <QFuture>
+#include <QList>
+#include <QString>
+#include <memory>
+
+#include "Worksheet.h"
+#include "FileManager.h"
+
+// 透视汇总：按一列或多列的显示文本分组，对其他列求和、计数、平均值、最小值、最大值，结果写入新的工作表。
+//
+//   数据行分段并行处理，每段一个开放寻址的哈希表（线性探测；槽中只有哈希值与分组序号，
+//   分组键与累加值按序号连续存放），分组键为各分组列的文本在段内字典中的编号；
+//   各段完成后按顺序把段内编号换算为全局编号，合并到总表。
+//   结果的第一行为标题，各组按分组列的值排序（都是数字时按数值），最后一行为总计
+class PivotTable
+{
+public:
+    enum Aggregate {
+        Sum,
+        Count, // 非空单元格数
+        Average,
+        Minimum,
+        Maximum
+    };
+
+    struct ValueField {
+        int column;
+        Aggregate aggregate;
+    };
+
+    struct Spec {
+        int headerRow; // 标题行，其下到最后一个有数据的行为数据行
+        QList<int> groupColumns;
+        QList<ValueField> values;
+    };
+
+    static QString aggregateName(Aggregate aggregate);
+
+    // 汇总source，结果工作表属于调用线程；中止时返回nullptr。只读取数值（含数字文本）参与求和等计算
+    static std::shared_ptr<Worksheet> build(const Worksheet *source, const Spec &spec,
+                                            const FileManager::ProgressCallback &progress = FileManager::ProgressCallback());
+    // 在线程池中汇总，结果移交调用线程；进度为0..FileManager::ProgressSteps，期间不可修改source
+    static QFuture<std::shared_ptr<Worksheet>> buildAsync(const Worksheet *source, const Spec &spec);
+};
@@ -0,0 +1,800 @@
+#include "SspFormat.h"
+#include "Cell.h"
+#include "Worksheet.h"
+#include "ColumnCodec.h"
+#include "OrderedTasks.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QHash>
+#include <QMap>
+#include <QDate>
+#include <QDateTime>
+#include <QStringList>
+#include <QtEndian>
+#include <QDebug>
+#include <cstring>
+#include <memory>
+
+namespace {
+
+const quint32 HeaderMagic = 0x42505353;  // "SSPB"
+const quint32 TrailerMagic = 0x45505353; // "SSPE"
+const quint16 FormatVersion = 3; // 版本3：各工作表的字符串分段编号，索引记录段起始编号
+const quint16 MinFormatVersion = 1; // 版本1：数据流均未编码，字符串表未封装为数据流
+const quint32 NoString = 0xFFFFFFFF; // 无公式
+
+// 值类型：同一数据块内类型一致时整块使用该类型，否则为Mixed并逐个记录类型
+enum ValueKind : quint8 {
+    KindNull = 0,
+    KindBool = 1,
+    KindInt = 2,
+    KindDouble = 3,
+    KindString = 4,
+    KindDate = 5,     // 儒略日
+    KindDateTime = 6, // 毫秒时间戳
+    KindMixed = 0xFF
+};
+
+// 文件头标志
+enum HeaderFlag : quint16 {
+    HasUserData = 0x0001 // 文件头之后有附加数据（长度 | 内容）
+};
+
+enum ChunkFlag : quint8 {
+    HasFormulas = 0x01,
+    HasReadOnly = 0x02
+};
+
+// 每种类型的值在数据流中占用的字节数
+int slotWidth(quint8 kind)
+{
+    switch (kind) {
+    case KindNull: return 0;
+    case KindBool: return 1;
+    case KindString: return 4;
+    default: return 8;
+    }
+}
+
+template <typename T>
+void appendLE(QByteArray &out, T value)
+{
+    value = qToLittleEndian(value);
+    out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+// 按宽度写入一个值槽
+void appendSlot(QByteArray &out, quint64 slot, int width)
+{
+    switch (width) {
+    case 1: appendLE<quint8>(out, quint8(slot)); break;
+    case 4: appendLE<quint32>(out, quint32(slot)); break;
+    case 8: appendLE<quint64>(out, slot); break;
+    default: break;
+    }
+}
+
+quint64 readSlot(const char *data, int width)
+{
+    switch (width) {
+    case 1: return quint8(*data);
+    case 4: return qFromLittleEndian<quint32>(data);
+    case 8: return qFromLittleEndian<quint64>(data);
+    default: return 0;
+    }
+}
+
+// 带边界检查的小端序读取器
+class ByteReader
+{
+public:
+    ByteReader(const char *data, qsizetype size)
+        : m_pos(data)
+        , m_end(data + size)
+        , m_ok(true)
+    {}
+
+    template <typename T>
+    T read()
+    {
+        if (m_end - m_pos < qsizetype(sizeof(T))) {
+            m_ok = false;
+            return T();
+        }
+        T value = qFromLittleEndian<T>(m_pos);
+        m_pos += sizeof(T);
+        return value;
+    }
+
+    const char *take(qsizetype size)
+    {
+        if (size < 0 || m_end - m_pos < size) {
+            m_ok = false;
+            return nullptr;
+        }
+        const char *data = m_pos;
+        m_pos += size;
+        return data;
+    }
+
+    bool ok() const { return m_ok; }
+
+private:
+    const char *m_pos;
+    const char *m_end;
+    bool m_ok;
+};
+
+// 字符串表：保存时去重，按首次出现顺序编号
+class StringTable
+{
+public:
+    quint32 add(const QString &text)
+    {
+        auto it = m_index.constFind(text);
+        if (it != m_index.constEnd()) {
+            return it.value();
+        }
+        quint32 index = quint32(m_strings.size());
+        m_strings.append(text);
+        m_index.insert(text, index);
+        return index;
+    }
+
+    const QStringList &strings() const { return m_strings; }
+
+    static QByteArray serialize(const QStringList &strings)
+    {
+        QByteArray out;
+        appendLE<quint32>(out, quint32(strings.size()));
+        for (const QString &text : strings) {
+            QByteArray utf8 = text.toUtf8();
+            appendLE<quint32>(out, quint32(utf8.size()));
+            out.append(utf8);
+        }
+        return out;
+    }
+
+    static bool parse(ByteReader &reader, QStringList *strings)
+    {
+        quint32 count = reader.read<quint32>();
+        for (quint32 i = 0; i < count && reader.ok(); ++i) {
+            quint32 length = reader.read<quint32>();
+            const char *data = reader.take(length);
+            if (data) {
+                strings->append(QString::fromUtf8(data, length));
+            }
+        }
+        return reader.ok();
+    }
+
+private:
+    QHash<QString, quint32> m_index;
+    QStringList m_strings;
+};
+
+// 值与类型、值槽之间的转换
+quint8 encodeValue(const QVariant &value, StringTable &strings, quint64 *slot)
+{
+    switch (value.typeId()) {
+    case QMetaType::UnknownType:
+        *slot = 0;
+        return KindNull;
+    case QMetaType::Bool:
+        *slot = value.toBool() ? 1 : 0;
+        return KindBool;
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::LongLong:
+    case QMetaType::ULongLong:
+    case QMetaType::Short:
+    case QMetaType::UShort:
+        *slot = quint64(value.toLongLong());
+        return KindInt;
+    case QMetaType::Double:
+    case QMetaType::Float: {
+        double number = value.toDouble();
+        std::memcpy(slot, &number, sizeof(number));
+        return KindDouble;
+    }
+    case QMetaType::QDate:
+        *slot = quint64(value.toDate().toJulianDay());
+        return KindDate;
+    case QMetaType::QDateTime:
+        *slot = quint64(value.toDateTime().toMSecsSinceEpoch());
+        return KindDateTime;
+    default:
+        *slot = strings.add(value.toString());
+        return KindString;
+    }
+}
+
+// stringBase为所属工作表的字符串段起始编号
+QVariant decodeValue(quint8 kind, quint64 slot, const QStringList &strings, quint32 stringBase)
+{
+    switch (kind) {
+    case KindBool:
+        return QVariant(slot != 0);
+    case KindInt:
+        return QVariant(qint64(slot));
+    case KindDouble: {
+        double number;
+        std::memcpy(&number, &slot, sizeof(number));
+        return QVariant(number);
+    }
+    case KindString:
+        slot += stringBase;
+        return slot < quint64(strings.size()) ? QVariant(strings.at(qsizetype(slot))) : QVariant();
+    case KindDate:
+        return QVariant(QDate::fromJulianDay(qint64(slot)));
+    case KindDateTime:
+        return QVariant(QDateTime::fromMSecsSinceEpoch(qint64(slot)));
+    default:
+        return QVariant();
+    }
+}
+
+// 一个数据块内某一列的单元格
+struct ColumnBuilder {
+    QList<qint32> rows;
+    QList<quint8> kinds;
+    QList<quint64> values;
+    QList<quint32> formulas;
+    QList<quint8> readOnly;
+    bool hasFormulas = false;
+    bool hasReadOnly = false;
+};
+
+// 数据流：编码方式 | 编码后长度 | 数据，每个数据流单独选择编码（见ColumnCodec）
+void appendStream(QByteArray &out, const QByteArray &raw, int width)
+{
+    ColumnCodec::Encoding encoding;
+    QByteArray encoded = ColumnCodec::encode(raw, width, &encoding);
+    appendLE<quint8>(out, encoding);
+    appendLE<quint32>(out, quint32(encoded.size()));
+    out.append(encoded);
+}
+
+// 读取数据流，解码为count个宽度为width的元素；未编码时直接引用映射的文件内容，不拷贝
+bool readStream(ByteReader &reader, int width, qsizetype count, QByteArray *raw)
+{
+    quint8 encoding = reader.read<quint8>();
+    quint32 size = reader.read<quint32>();
+    const char *data = reader.take(size);
+    return data && ColumnCodec::decode(encoding, data, size, width, count, raw);
+}
+
+// 数据块：长度 | 类型 | 标志 | 保留 | 列号 | 起始行 | 单元格数 | 行号流 | [类型流] | 值流 | [公式流] | [只读流]
+QByteArray serializeChunk(int column, int firstRow, const ColumnBuilder &builder)
+{
+    const int count = builder.rows.size();
+
+    // 整块类型一致时省略类型流
+    quint8 kind = builder.kinds.first();
+    for (quint8 k : builder.kinds) {
+        if (k != kind) {
+            kind = KindMixed;
+            break;
+        }
+    }
+
+    quint8 flags = 0;
+    if (builder.hasFormulas) flags |= HasFormulas;
+    if (builder.hasReadOnly) flags |= HasReadOnly;
+
+    QByteArray body;
+    appendLE<quint8>(body, kind);
+    appendLE<quint8>(body, flags);
+    appendLE<quint16>(body, 0);
+    appendLE<qint32>(body, column);
+    appendLE<qint32>(body, firstRow);
+    appendLE<quint32>(body, quint32(count));
+
+    QByteArray raw;
+    raw.reserve(count * 8);
+    for (qint32 row : builder.rows) {
+        appendLE<qint32>(raw, row);
+    }
+    appendStream(body, raw, 4);
+
+    if (kind == KindMixed) {
+        raw.resize(0);
+        for (quint8 k : builder.kinds) {
+            appendLE<quint8>(raw, k);
+        }
+        appendStream(body, raw, 1);
+    }
+
+    const int width = kind == KindMixed ? 8 : slotWidth(kind);
+    raw.resize(0);
+    for (int i = 0; i < count; ++i) {
+        appendSlot(raw, builder.values[i], width);
+    }
+    appendStream(body, raw, width);
+
+    if (builder.hasFormulas) {
+        raw.resize(0);
+        for (quint32 formula : builder.formulas) {
+            appendLE<quint32>(raw, formula);
+        }
+        appendStream(body, raw, 4);
+    }
+
+    if (builder.hasReadOnly) {
+        raw = QByteArray(reinterpret_cast<const char *>(builder.readOnly.constData()), count);
+        appendStream(body, raw, 1);
+    }
+
+    QByteArray chunk;
+    appendLE<quint32>(chunk, quint32(body.size()));
+    chunk.append(body);
+    return chunk;
+}
+
+// 解码数据块并写入工作表
+bool loadChunk(const char *data, qsizetype size, const QStringList &strings, quint32 stringBase,
+               Worksheet *worksheet)
+{
+    ByteReader reader(data, size);
+    quint32 bodySize = reader.read<quint32>();
+    const char *body = reader.take(bodySize);
+    if (!body) {
+        return false;
+    }
+
+    ByteReader chunk(body, bodySize);
+    quint8 kind = chunk.read<quint8>();
+    quint8 flags = chunk.read<quint8>();
+    chunk.read<quint16>();
+    qint32 column = chunk.read<qint32>();
+    chunk.read<qint32>(); // 起始行，随机访问时使用
+    quint32 count = chunk.read<quint32>();
+    if (!chunk.ok() || column < 0 || column >= Worksheet::MaxColumns) {
+        return false;
+    }
+
+    const int width = kind == KindMixed ? 8 : slotWidth(kind);
+    QByteArray rows, kinds, valueStream, formulas, readOnly;
+    if (!readStream(chunk, 4, count, &rows)) return false;
+    if (kind == KindMixed && !readStream(chunk, 1, count, &kinds)) return false;
+    if (!readStream(chunk, width, count, &valueStream)) return false;
+    if ((flags & HasFormulas) && !readStream(chunk, 4, count, &formulas)) return false;
+    if ((flags & HasReadOnly) && !readStream(chunk, 1, count, &readOnly)) return false;
+
+    // 先检查所有行号，损坏的数据块不写入任何单元格
+    for (quint32 i = 0; i < count; ++i) {
+        if (qFromLittleEndian<qint32>(rows.constData() + i * 4) < 0) {
+            return false;
+        }
+    }
+
+    for (quint32 i = 0; i < count; ++i) {
+        const qint32 row = qFromLittleEndian<qint32>(rows.constData() + i * 4);
+        const quint8 cellKind = kind == KindMixed ? quint8(kinds[i]) : kind;
+        const quint64 slot = readSlot(valueStream.constData() + i * width, width);
+
+        auto cell = worksheet->cell(row, column);
+        quint32 formula = (flags & HasFormulas) ? qFromLittleEndian<quint32>(formulas.constData() + i * 4)
+                                                : NoString;
+        const quint64 formulaIndex = quint64(formula) + stringBase;
+        if (formula != NoString && formulaIndex < quint64(strings.size())) {
+            cell->setFormula(strings.at(qsizetype(formulaIndex)));
+        }
+        else {
+            cell->setValue(decodeValue(cellKind, slot, strings, stringBase));
+        }
+        cell->setReadOnly((flags & HasReadOnly) && readOnly[i] != 0);
+    }
+
+    return true;
+}
+
+// 索引中的数据块记录
+struct ChunkEntry {
+    qint32 column;
+    qint32 firstRow;
+    quint32 cellCount;
+    quint64 offset;
+    quint32 size;
+};
+
+struct SheetEntry {
+    quint32 nameIndex;
+    qint32 rowCount;
+    qint32 colCount;
+    quint32 stringBase; // 本工作表字符串段的起始编号
+    QList<ChunkEntry> chunks;
+};
+
+// 一个工作表序列化后的数据块，可在工作线程中独立生成
+struct SheetBlob {
+    QByteArray data;          // 全部数据块
+    QList<ChunkEntry> chunks; // 偏移相对于data起始
+    QStringList strings;      // 本工作表的字符串段
+};
+
+// 序列化工作表的全部数据块：按ChunkRows行一组遍历，组内按列收集后逐列写出
+SheetBlob serializeSheet(const Worksheet *worksheet)
+{
+    SheetBlob blob;
+    StringTable strings; // 工作表内去重
+    QMap<int, ColumnBuilder> columns; // 当前行组内各列的单元格
+    int blockStart = 0;
+
+    auto flushBlock = [&]() {
+        for (auto it = columns.constBegin(); it != columns.constEnd(); ++it) {
+            if (it->rows.isEmpty()) {
+                continue;
+            }
+            QByteArray chunk = serializeChunk(it.key(), blockStart, it.value());
+            blob.chunks.append(ChunkEntry{it.key(), blockStart, quint32(it->rows.size()),
+                                          quint64(blob.data.size()), quint32(chunk.size())});
+            blob.data.append(chunk);
+        }
+        columns.clear();
+    };
+
+    const auto &rows = worksheet->rows();
+    for (auto rowIt = rows.constBegin(); rowIt != rows.constEnd(); ++rowIt) {
+        if (rowIt.key() >= blockStart + SspFormat::ChunkRows) { // 进入新的行组
+            flushBlock();
+            blockStart = rowIt.key() - rowIt.key() % SspFormat::ChunkRows;
+        }
+
+        for (auto it = rowIt->constBegin(); it != rowIt->constEnd(); ++it) {
+            const Cell *cell = it.value().get();
+            if (!cell || cell->isEmpty()) { // 只保存非空单元格
+                continue;
+            }
+
+            ColumnBuilder &builder = columns[it.key()];
+            quint64 slot = 0;
+            builder.rows.append(rowIt.key());
+            builder.kinds.append(encodeValue(cell->value(), strings, &slot));
+            builder.values.append(slot);
+
+            if (!cell->formula().isEmpty()) {
+                builder.formulas.append(strings.add(cell->formula()));
+                builder.hasFormulas = true;
+            }
+            else {
+                builder.formulas.append(NoString);
+            }
+
+            builder.readOnly.append(cell->isReadOnly() ? 1 : 0);
+            builder.hasReadOnly = builder.hasReadOnly || cell->isReadOnly();
+        }
+    }
+
+    flushBlock();
+    blob.strings = strings.strings();
+    return blob;
+}
+
+// 打开的.ssp文件：尚未载入的工作表共享该对象，全部载入后释放文件映射
+struct SspSource {
+    QFile file;
+    QByteArray fallback; // 无法映射时的文件内容
+    const char *data = nullptr;
+    qsizetype size = 0;
+    QStringList strings;
+};
+
+// 按索引解码一个工作表的全部数据块
+bool loadSheet(const SspSource &source, const SheetEntry &sheet, Worksheet *worksheet)
+{
+    for (const ChunkEntry &chunk : sheet.chunks) {
+        if (chunk.offset + chunk.size > quint64(source.size)
+            || !loadChunk(source.data + chunk.offset, chunk.size, source.strings, sheet.stringBase, worksheet)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+// 逐个工作表写出的内部状态：数据块直接写入文件，只保留索引与字符串段
+struct SspFormat::Writer::Private {
+    QSaveFile file;
+    QStringList strings;
+    QList<SheetEntry> sheets;
+    QStringList names;
+    qsizetype userDataSize = 0;
+    bool ok = false;
+
+    bool addBlob(const SheetBlob &blob, const Worksheet *worksheet)
+    {
+        SheetEntry entry{0, worksheet->rowCount(), worksheet->columnCount(), quint32(strings.size()), {}};
+        const quint64 base = quint64(file.pos());
+        for (ChunkEntry chunk : blob.chunks) {
+            chunk.offset += base;
+            entry.chunks.append(chunk);
+        }
+        strings += blob.strings;
+        sheets.append(entry);
+        names.append(worksheet->name());
+        ok = file.write(blob.data) == blob.data.size();
+        return ok;
+    }
+};
+
+SspFormat::Writer::Writer(const QString &fileName)
+    : d(std::make_unique<Private>())
+{
+    d->file.setFileName(fileName); // 写入临时文件，提交时替换原文件
+}
+
+SspFormat::Writer::~Writer() = default; // 未提交时丢弃临时文件
+
+bool SspFormat::Writer::open(int currentIndex, const QByteArray &userData)
+{
+    if (!d->file.open(QIODevice::WriteOnly)) {
+        qDebug() << "Failed to open file for writing:" << d->file.fileName();
+        return false;
+    }
+
+    // 文件头：工作表数在完成时回填；附加数据紧随其后，读取工作表时按偏移跳过
+    QByteArray header;
+    appendLE<quint32>(header, HeaderMagic);
+    appendLE<quint16>(header, FormatVersion);
+    appendLE<quint16>(header, userData.isEmpty() ? 0 : HasUserData);
+    appendLE<quint32>(header, 0);
+    appendLE<qint32>(header, qMax(0, currentIndex));
+    if (!userData.isEmpty()) {
+        appendLE<quint32>(header, quint32(userData.size()));
+        header.append(userData);
+    }
+    d->userDataSize = userData.size();
+    d->ok = d->file.write(header) == header.size();
+    return d->ok;
+}
+
+bool SspFormat::Writer::addWorksheet(const Worksheet *worksheet)
+{
+    return d->ok && worksheet && d->addBlob(serializeSheet(worksheet), worksheet);
+}
+
+bool SspFormat::Writer::finish(const QByteArray &userData)
+{
+    if (!d->ok || (!userData.isEmpty() && userData.size() != d->userDataSize)) {
+        return false;
+    }
+
+    // 工作表名位于所有字符串段之后
+    for (int i = 0; i < d->sheets.size(); ++i) {
+        d->sheets[i].nameIndex = quint32(d->strings.size());
+        d->strings.append(d->names.at(i));
+    }
+
+    // 字符串表
+    const quint64 stringTableOffset = quint64(d->file.pos());
+    // 字符串表整体作为一个字节流编码（通常选用zlib）
+    QByteArray rawStrings = StringTable::serialize(d->strings);
+    QByteArray stringTable;
+    appendLE<quint32>(stringTable, quint32(rawStrings.size()));
+    appendStream(stringTable, rawStrings, 1);
+    if (d->file.write(stringTable) != stringTable.size()) {
+        return false;
+    }
+
+    // 索引与文件尾
+    const quint64 indexOffset = quint64(d->file.pos());
+    QByteArray index;
+    appendLE<quint32>(index, quint32(d->sheets.size()));
+    for (const SheetEntry &sheet : std::as_const(d->sheets)) {
+        appendLE<quint32>(index, sheet.nameIndex);
+        appendLE<qint32>(index, sheet.rowCount);
+        appendLE<qint32>(index, sheet.colCount);
+        appendLE<quint32>(index, sheet.stringBase);
+        appendLE<quint32>(index, quint32(sheet.chunks.size()));
+        for (const ChunkEntry &chunk : sheet.chunks) {
+            appendLE<qint32>(index, chunk.column);
+            appendLE<qint32>(index, chunk.firstRow);
+            appendLE<quint32>(index, chunk.cellCount);
+            appendLE<quint64>(index, chunk.offset);
+            appendLE<quint32>(index, chunk.size);
+        }
+    }
+    appendLE<quint64>(index, stringTableOffset);
+    appendLE<quint64>(index, indexOffset);
+    appendLE<quint32>(index, TrailerMagic);
+    if (d->file.write(index) != index.size()) {
+        return false;
+    }
+
+    // 回填文件头中的工作表数
+    QByteArray count;
+    appendLE<quint32>(count, quint32(d->sheets.size()));
+    if (!d->file.seek(8) || d->file.write(count) != count.size()) {
+        return false;
+    }
+    // 回填附加数据：位于16字节的文件头与4字节的长度之后
+    if (!userData.isEmpty() && (!d->file.seek(16 + 4) || d->file.write(userData) != userData.size())) {
+        return false;
+    }
+    return d->file.commit();
+}
+
+// 保存为二进制格式
+bool SspFormat::save(const Workbook *workbook, const QString &fileName,
+                     const FileManager::ProgressCallback &progress)
+{
+    if (!workbook) return false;
+
+    Writer writer(fileName);
+    if (!writer.open(workbook->currentIndex())) {
+        return false;
+    }
+
+    // 数据块：每个工作表在线程池中独立序列化，按顺序写入并拼接各自的字符串段
+    const bool written = runOrdered<SheetBlob>(workbook->worksheetCount(), [workbook](int index) {
+        return serializeSheet(workbook->worksheet(index).get());
+    }, [&](int index, SheetBlob &blob) {
+        if (!writer.d->addBlob(blob, workbook->worksheet(index).get())) {
+            return false;
+        }
+        return !progress || progress(index + 1, workbook->worksheetCount());
+    });
+
+    return written && writer.finish();
+}
+
+// 读取文件头之后的附加数据
+QByteArray SspFormat::readUserData(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+
+    const QByteArray header = file.read(16 + 4);
+    ByteReader reader(header.constData(), header.size());
+    const quint32 magic = reader.read<quint32>();
+    const quint16 version = reader.read<quint16>();
+    const quint16 flags = reader.read<quint16>();
+    reader.read<quint32>();
+    reader.read<qint32>();
+    const quint32 size = reader.read<quint32>();
+    if (!reader.ok() || magic != HeaderMagic || version > FormatVersion || !(flags & HasUserData)
+        || qint64(size) > file.size() - file.pos()) {
+        return QByteArray();
+    }
+    return file.read(size);
+}
+
+// 读取二进制格式
+bool SspFormat::load(Workbook *workbook, const QString &fileName)
+{
+    if (!workbook) return false;
+
+    auto source = std::make_shared<SspSource>();
+    source->file.setFileName(fileName);
+    if (!source->file.open(QIODevice::ReadOnly)) {
+        qDebug() << "Failed to open file for reading:" << fileName;
+        return false;
+    }
+
+    // 优先内存映射整个文件，失败时退回一次性读取
+    source->size = source->file.size();
+    source->data = reinterpret_cast<const char *>(source->file.map(0, source->size));
+    if (!source->data) {
+        source->fallback = source->file.readAll();
+        source->data = source->fallback.constData();
+        source->size = source->fallback.size();
+    }
+    const char *data = source->data;
+    const qsizetype size = source->size;
+
+    // 文件头
+    ByteReader header(data, size);
+    const quint32 magic = header.read<quint32>();
+    const quint16 version = header.read<quint16>();
+    if (magic != HeaderMagic || version < MinFormatVersion || version > FormatVersion) {
+        qDebug() << "Invalid SSP file:" << fileName;
+        return false;
+    }
+    header.read<quint16>();
+    header.read<quint32>(); // 工作表数，以索引为准
+    const qint32 currentSheet = header.read<qint32>();
+
+    // 文件尾
+    const qsizetype trailerSize = 8 + 8 + 4;
+    if (!header.ok() || size < trailerSize) {
+        return false;
+    }
+    ByteReader trailer(data + size - trailerSize, trailerSize);
+    const quint64 stringTableOffset = trailer.read<quint64>();
+    const quint64 indexOffset = trailer.read<quint64>();
+    if (trailer.read<quint32>() != TrailerMagic
+        || stringTableOffset > quint64(size) || indexOffset > quint64(size - trailerSize)) {
+        qDebug() << "Corrupted SSP file:" << fileName;
+        return false;
+    }
+
+    // 字符串表
+    QStringList &strings = source->strings;
+    if (indexOffset < stringTableOffset) {
+        return false;
+    }
+    ByteReader stringReader(data + stringTableOffset, qsizetype(indexOffset - stringTableOffset));
+    QByteArray rawStrings;
+    if (version >= 2) {
+        const quint32 rawSize = stringReader.read<quint32>();
+        if (!readStream(stringReader, 1, rawSize, &rawStrings)) {
+            return false;
+        }
+    }
+    else {
+        rawStrings = QByteArray::fromRawData(data + stringTableOffset, qsizetype(indexOffset - stringTableOffset));
+    }
+    ByteReader rawStringReader(rawStrings.constData(), rawStrings.size());
+    if (!StringTable::parse(rawStringReader, &strings)) {
+        return false;
+    }
+
+    // 索引
+    ByteReader index(data + indexOffset, size - trailerSize - qsizetype(indexOffset));
+    QList<SheetEntry> sheets;
+    const quint32 sheetCount = index.read<quint32>();
+    for (quint32 i = 0; i < sheetCount && index.ok(); ++i) {
+        SheetEntry sheet;
+        sheet.nameIndex = index.read<quint32>();
+        sheet.rowCount = index.read<qint32>();
+        sheet.colCount = index.read<qint32>();
+        sheet.stringBase = version >= 3 ? index.read<quint32>() : 0; // 旧版本共用一个字符串编号空间
+        const quint32 chunkCount = index.read<quint32>();
+        for (quint32 j = 0; j < chunkCount && index.ok(); ++j) {
+            ChunkEntry chunk;
+            chunk.column = index.read<qint32>();
+            chunk.firstRow = index.read<qint32>();
+            chunk.cellCount = index.read<quint32>();
+            chunk.offset = index.read<quint64>();
+            chunk.size = index.read<quint32>();
+            sheet.chunks.append(chunk);
+        }
+        sheets.append(sheet);
+    }
+    if (!index.ok()) {
+        return false;
+    }
+
+    // 重建工作表目录：数据块在工作表首次使用时才从文件中解码
+    workbook->clear();
+    for (const SheetEntry &sheet : sheets) {
+        workbook->addWorksheet(sheet.nameIndex < quint32(strings.size()) ? strings.at(int(sheet.nameIndex))
+                                                                         : QString());
+        auto worksheet = workbook->worksheet(workbook->worksheetCount() - 1);
+        worksheet->setSize(qBound(1, sheet.rowCount, int(Worksheet::MaxRows)), // 载入前即可显示完整尺寸
+                           qBound(1, sheet.colCount, int(Worksheet::MaxColumns)));
+        worksheet->setLoader([source, sheet](Worksheet *target) {
+            return loadSheet(*source, sheet, target);
+        });
+    }
+
+    // 没有工作表，则创建一个默认工作表
+    if (workbook->worksheetCount() == 0) {
+        workbook->addWorksheet("Sheet1");
+    }
+    workbook->setCurrentWorksheet(currentSheet);
+
+    // 立即载入当前工作表，其余工作表延迟到切换时载入
+    auto current = workbook->currentWorksheet();
+    if (current && !current->ensureLoaded()) {
+        qDebug() << "Corrupted chunk in SSP file:" << fileName;
+        return false;
+    }
+
+    return true;
+}
+
+bool SspFormat::isSspFile(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QByteArray magic = file.read(4);
+    return magic.size() == 4 && qFromLittleEndian<quint32>(magic.constData()) == HeaderMagic;
+}
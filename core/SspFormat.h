@@ -0,0 +1,54 @@
+#pragma once
+
+#include <QString>
+#include <QByteArray>
+#include <memory>
+
+#include "Workbook.h"
+#include "FileManager.h"
+
+// 原生二进制工作簿格式（.ssp），所有整数均为小端序
+//
+//   文件头   magic "SSPB" | 版本 | 标志 | 工作表数 | 当前工作表 [| 附加数据长度 | 附加数据]
+//   数据块   每个工作表按列分块（每块覆盖ChunkRows行），带类型与长度前缀；
+//            块内行号、值、公式等各为一个数据流，分别选用游程/增量/帧参考/字典/zlib编码
+//   字符串表 字符串值、公式（每个工作表一段，段内去重）和工作表名的UTF-8文本，整体编码为一个数据流
+//   索引     每个工作表的名称、尺寸、字符串段起始编号及各数据块的位置，支持随机访问
+//
+// 各工作表的数据块与字符串段互相独立，保存时每个工作表由线程池中的一个任务序列化
+//   文件尾   字符串表偏移 | 索引偏移 | magic "SSPE"
+class SspFormat
+{
+public:
+    static constexpr int ChunkRows = 65536; // 每个数据块覆盖的行数
+
+    // 进度以工作表为单位；失败或中止时原文件不变
+    static bool save(const Workbook *workbook, const QString &fileName,
+                     const FileManager::ProgressCallback &progress = FileManager::ProgressCallback());
+    static bool load(Workbook *workbook, const QString &fileName);
+
+    static bool isSspFile(const QString &fileName); // 根据文件头识别格式
+
+    // 文件头之后的附加数据（由Writer写入，不影响工作表数据），没有时返回空
+    static QByteArray readUserData(const QString &fileName);
+
+    // 逐个写出工作表：数据块直接写入文件，内存中只保留索引与字符串表（字符串表位于文件末尾）。
+    // 用于无法一次取得全部工作表的场合；finish之前失败或未调用finish时原文件不变
+    class Writer
+    {
+    public:
+        explicit Writer(const QString &fileName);
+        ~Writer();
+
+        bool open(int currentIndex = 0, const QByteArray &userData = QByteArray());
+        bool addWorksheet(const Worksheet *worksheet);
+        // 写出字符串表与索引并提交；userData非空时替换open时写入的附加数据（长度须相同，
+        // 用于完成时才能确定的内容，如写入过程中计算的哈希）
+        bool finish(const QByteArray &userData = QByteArray());
+
+    private:
+        friend class SspFormat;
+        struct Private;
+        std::unique_ptr<Private> d;
+    };
+};
@@ -20,6 +20,16 @@ std::shared_ptr<Worksheet> Workbook::worksheet(int index) const
     return nullptr;
 }
 
+int Workbook::indexOf(const Worksheet *worksheet) const
+{
+    for (int i = 0; i < m_worksheets.size(); ++i) {
+        if (m_worksheets[i].get() == worksheet) {
+            return i;
+        }
+    }
+    return -1;
+}
+
 // 访问当前工作表
 std::shared_ptr<Worksheet> Workbook::currentWorksheet() const
 {
@@ -73,6 +83,13 @@ void Workbook::setCurrentWorksheet(int index)
     }
 }
 
+// 移除所有工作表，不保留默认工作表，由调用方随后添加
+void Workbook::clear()
+{
+    m_worksheets.clear();
+    m_currentIndex = -1;
+}
+
 // 保存文件（未完全实现）
 bool Workbook::saveToFile(const QString &fileName)
 {
@@ -19,11 +19,14 @@ public:
     // 工作表访问
     std::shared_ptr<Worksheet> worksheet(int index) const;
     std::shared_ptr<Worksheet> currentWorksheet() const;
+    int currentIndex() const { return m_currentIndex; }
+    int indexOf(const Worksheet *worksheet) const; // 不存在时返回-1
 
     // 工作表管理
     void addWorksheet(const QString &name = QString());
     void removeWorksheet(int index);
     void setCurrentWorksheet(int index);
+    void clear(); // 移除所有工作表（加载文件前使用）
 
     // 文件IO
     bool saveToFile(const QString &fileName);
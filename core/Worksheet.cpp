@@ -1,10 +1,12 @@
 #include "Worksheet.h"
+#include "WorksheetSort.h"
 
 Worksheet::Worksheet(const QString &name, QObject *parent)
     : QObject(parent)
     , m_name(name)
-    , m_rowCount(100)
-    , m_colCount(26)
+    , m_rowCount(DefaultRows)
+    , m_colCount(DefaultColumns)
+    , m_cellColumns(0)
 {}
 
 void Worksheet::setName(const QString &name)
@@ -18,55 +20,359 @@ void Worksheet::setName(const QString &name)
 // 单元格访问
 std::shared_ptr<Cell> Worksheet::cell(int row, int col)
 {
-    QPair<int, int> key(row, col);
+    Row &cells = m_rows[row];
+    auto it = cells.find(col);
 
-    if (!m_cells.contains(key)) { // 单元格不存在则创建
-        auto newCell = std::make_shared<Cell>(row, col, this);
-        m_cells[key] = newCell;
+    if (it == cells.end()) { // 单元格不存在则创建
+        auto newCell = std::make_shared<Cell>(row, col);
+        it = cells.insert(col, newCell);
+        attachCell(row, col, newCell.get());
+    }
+
+    return it.value();
+}
+
+void Worksheet::attachCell(int row, int col, Cell *cell)
+{
+    cell->setParent(this);
+    cell->setPosition(row, col);
+    includeCell(row, col);
+
+    // 信号槽连接：cell对象发送单元格内容改变信号，从而触发工作表的单元格改变信号
+    // 坐标在发送时从单元格读取，排序等移动单元格时只需更新坐标，不必重新连接
+    connect(cell, &Cell::valueChanged,
+            this, [this, cell]() { emit cellChanged(cell->row(), cell->column()); });
+    // 捕获列表[this, cell]中，this捕获当前对象，允许调用成员函数。
+}
+
+void Worksheet::includeCell(int row, int col)
+{
+    m_rowCount = qMax(m_rowCount, row + 1);
+    m_colCount = qMax(m_colCount, col + 1);
+    m_cellColumns = qMax(m_cellColumns, col + 1);
+}
 
-        // 信号槽连接：cell对象发送单元格内容改变信号，从而触发工作表的单元格改变信号
-        connect(newCell.get(), &Cell::valueChanged,
-                this, [this, row, col]() { emit cellChanged(row, col); });
-        // 捕获列表[this, row, col]中，this捕获当前对象，允许调用成员函数。
+void Worksheet::setSize(int rows, int cols)
+{
+    rows = qMax(qMax(rows, 1), m_rows.isEmpty() ? 0 : m_rows.lastKey() + 1);
+    cols = qMax(qMax(cols, 1), m_cellColumns);
+    if (rows != m_rowCount || cols != m_colCount) {
+        m_rowCount = rows;
+        m_colCount = cols;
+        emit sizeChanged(rows, cols);
     }
+}
 
-    return m_cells[key];
+std::shared_ptr<Cell> Worksheet::cellAt(int row, int col) const
+{
+    auto rowIt = m_rows.constFind(row);
+    if (rowIt == m_rows.constEnd()) {
+        return nullptr;
+    }
+    return rowIt->value(col); // 不存在时返回默认构造的空指针
 }
 
+void Worksheet::usedRange(int *maxRow, int *maxCol) const
+{
+    int lastRow = -1, lastCol = -1;
+    for (auto rowIt = m_rows.constBegin(); rowIt != m_rows.constEnd(); ++rowIt) {
+        for (auto it = rowIt->constBegin(); it != rowIt->constEnd(); ++it) {
+            if (it.value() && !it.value()->isEmpty()) {
+                lastRow = rowIt.key(); // 行号递增遍历，最后一个有数据的行即最大行
+                lastCol = qMax(lastCol, it.key());
+            }
+        }
+    }
+
+    if (maxRow) *maxRow = lastRow;
+    if (maxCol) *maxCol = lastCol;
+}
 
 void Worksheet::setCell(int row, int col, std::shared_ptr<Cell> cell)
 {
-    QPair<int, int> key(row, col);
-    m_cells[key] = cell; // 传入单元格覆盖指定位置。
+    m_rows[row][col] = cell; // 传入单元格覆盖指定位置。
+    includeCell(row, col);
     emit cellChanged(row, col);
 }
 
 // 插入or删除行列暂未实现
 void Worksheet::insertRow(int row)
 {
-    m_rowCount++;
+    setSize(m_rowCount + 1, m_colCount);
 }
 
 void Worksheet::insertColumn(int col)
 {
-    m_colCount++;
+    setSize(m_rowCount, m_colCount + 1);
 }
 
 void Worksheet::removeRow(int row)
 {
-    if (m_rowCount > 1) {
-        m_rowCount--;
-    }
+    setSize(m_rowCount - 1, m_colCount);
 }
 
 void Worksheet::removeColumn(int col)
 {
-    if (m_colCount > 1) {
-        m_colCount--;
-    }
+    setSize(m_rowCount, m_colCount - 1);
 }
 
 void Worksheet::clear()
 {
-    m_cells.clear(); // 移除所有单元格
+    m_rows.clear(); // 移除所有单元格（尺寸不变）
+    m_cellColumns = 0;
+}
+
+void Worksheet::sort(const SortSpec &spec)
+{
+    if (spec.keys.isEmpty() || spec.firstRow > spec.lastRow || spec.firstColumn > spec.lastColumn) {
+        return;
+    }
+
+    emit aboutToSort(spec);
+
+    // 参与排序的行：范围内有单元格的行（指向m_rows中的行对象，收集后到重排结束不再发送信号）
+    std::vector<Row *> sources;
+    for (auto it = m_rows.lowerBound(spec.firstRow); it != m_rows.end() && it.key() <= spec.lastRow; ++it) {
+        auto cellIt = it->lowerBound(spec.firstColumn);
+        if (cellIt != it->end() && cellIt.key() <= spec.lastColumn) {
+            sources.push_back(&it.value());
+        }
+    }
+    if (!sources.empty()) {
+        const std::vector<const Row *> rows(sources.cbegin(), sources.cend());
+        permuteRows(spec, sources, WorksheetSort::permutation(rows, spec.keys));
+    }
+    emit sorted(spec);
+}
+
+void Worksheet::permuteRows(const SortSpec &spec, const std::vector<Row *> &sources, const std::vector<int> &order)
+{
+    // 取出每行在范围内的片段；整行都在范围内时直接移走行对象
+    std::vector<Row> segments(sources.size());
+    for (size_t i = 0; i < sources.size(); ++i) {
+        Row &row = *sources[i];
+        if (row.firstKey() >= spec.firstColumn && row.lastKey() <= spec.lastColumn) {
+            segments[i] = std::move(row);
+            row.clear();
+            continue;
+        }
+        auto it = row.lowerBound(spec.firstColumn);
+        while (it != row.end() && it.key() <= spec.lastColumn) {
+            segments[i].insert(segments[i].cend(), it.key(), it.value());
+            it = row.erase(it);
+        }
+    }
+
+    // 按顺序放入firstRow开始的各行：目标行号递增，沿m_rows顺序前进，不逐行查找
+    auto target = m_rows.lowerBound(spec.firstRow);
+    for (size_t i = 0; i < order.size(); ++i) {
+        const int row = spec.firstRow + int(i);
+        while (target != m_rows.end() && target.key() < row) {
+            ++target;
+        }
+        if (target == m_rows.end() || target.key() != row) {
+            target = m_rows.insert(target, row, Row());
+        }
+
+        Row &segment = segments[order[i]];
+        for (auto it = segment.cbegin(); it != segment.cend(); ++it) {
+            if (it.value()) {
+                it.value()->setPosition(row, it.key());
+            }
+        }
+        if (target->isEmpty()) {
+            *target = std::move(segment);
+        }
+        else {
+            for (auto it = segment.cbegin(); it != segment.cend(); ++it) {
+                target->insert(it.key(), it.value());
+            }
+        }
+    }
+
+    // 移除取出片段后变空的行
+    for (auto it = m_rows.lowerBound(spec.firstRow); it != m_rows.end() && it.key() <= spec.lastRow;) {
+        it = it->isEmpty() ? m_rows.erase(it) : std::next(it);
+    }
+}
+
+CellBlock Worksheet::copyCells(int firstRow, int lastRow, int firstColumn, int lastColumn) const
+{
+    std::vector<CellBlock::Entry> entries;
+    for (auto rowIt = m_rows.lowerBound(firstRow); rowIt != m_rows.cend() && rowIt.key() <= lastRow; ++rowIt) {
+        for (auto it = rowIt->lowerBound(firstColumn); it != rowIt->cend() && it.key() <= lastColumn; ++it) {
+            const Cell *cell = it.value().get();
+            if (cell && !cell->isEmpty()) {
+                entries.push_back(CellBlock::Entry{rowIt.key() - firstRow, it.key() - firstColumn,
+                                                   cell->value(), cell->formula()});
+            }
+        }
+    }
+    return CellBlock(lastRow - firstRow + 1, lastColumn - firstColumn + 1, std::move(entries));
+}
+
+void Worksheet::pasteCells(const CellBlock &block, int row, int col)
+{
+    if (block.rowCount() <= 0 || block.columnCount() <= 0) {
+        return;
+    }
+    const int lastRow = row + block.rowCount() - 1;
+    const int lastColumn = col + block.columnCount() - 1;
+    std::vector<std::pair<int, int>> changed; // 修改完成后再发送cellChanged，修改期间不调用外部代码
+
+    // 先删除区域内block中没有内容的位置的单元格：block按行列有序，与各行的单元格同步前进
+    const std::vector<CellBlock::Entry> &entries = block.entries();
+    auto entry = entries.cbegin();
+    for (auto rowIt = m_rows.lowerBound(row); rowIt != m_rows.end() && rowIt.key() <= lastRow;) {
+        const int relativeRow = rowIt.key() - row;
+        while (entry != entries.cend() && entry->row < relativeRow) {
+            ++entry;
+        }
+        for (auto it = rowIt->lowerBound(col); it != rowIt->end() && it.key() <= lastColumn;) {
+            const int relativeColumn = it.key() - col;
+            while (entry != entries.cend() && entry->row == relativeRow && entry->column < relativeColumn) {
+                ++entry;
+            }
+            const bool replaced = entry != entries.cend() && entry->row == relativeRow && entry->column == relativeColumn;
+            if (replaced || (it.value() && it.value()->isReadOnly())) {
+                ++it;
+                continue;
+            }
+            changed.emplace_back(rowIt.key(), it.key());
+            it = rowIt->erase(it);
+        }
+        rowIt = rowIt->isEmpty() ? m_rows.erase(rowIt) : std::next(rowIt);
+    }
+
+    // 再写入block的内容：目标行依次递增，沿m_rows顺序前进；新单元格多数追加在行尾
+    auto target = m_rows.lowerBound(row);
+    for (const CellBlock::Entry &source : entries) {
+        const int targetRow = row + source.row;
+        const int targetColumn = col + source.column;
+        while (target != m_rows.end() && target.key() < targetRow) {
+            ++target;
+        }
+        if (target == m_rows.end() || target.key() != targetRow) {
+            target = m_rows.insert(target, targetRow, Row());
+        }
+
+        auto it = target->isEmpty() || target->lastKey() < targetColumn ? target->end() : target->find(targetColumn);
+        if (it == target->end()) {
+            auto cell = std::make_shared<Cell>(targetRow, targetColumn);
+            it = target->insert(targetColumn, cell);
+            attachCell(targetRow, targetColumn, cell.get());
+        }
+        else if (!it.value() || it.value()->isReadOnly()) {
+            continue;
+        }
+
+        Cell *cell = it.value().get();
+        if (source.formula.isEmpty() || source.value.isValid()) {
+            cell->setContents(source.value, source.formula);
+        }
+        else {
+            QSignalBlocker blocker(cell);
+            cell->setContents(QVariant(), QString());
+            cell->setFormula(source.formula); // 其他程序复制的公式尚未求值
+        }
+        changed.emplace_back(targetRow, targetColumn);
+    }
+
+    for (const auto &position : changed) {
+        emit cellChanged(position.first, position.second);
+    }
+}
+
+void Worksheet::clearCells(int firstRow, int lastRow, int firstColumn, int lastColumn)
+{
+    std::vector<std::pair<int, int>> changed;
+    for (auto rowIt = m_rows.lowerBound(firstRow); rowIt != m_rows.end() && rowIt.key() <= lastRow;) {
+        for (auto it = rowIt->lowerBound(firstColumn); it != rowIt->end() && it.key() <= lastColumn;) {
+            if (it.value() && it.value()->isReadOnly()) {
+                ++it;
+                continue;
+            }
+            changed.emplace_back(rowIt.key(), it.key());
+            it = rowIt->erase(it);
+        }
+        rowIt = rowIt->isEmpty() ? m_rows.erase(rowIt) : std::next(rowIt);
+    }
+
+    for (const auto &position : changed) {
+        emit cellChanged(position.first, position.second);
+    }
+}
+
+bool Worksheet::ensureLoaded()
+{
+    if (!m_loader) {
+        return true;
+    }
+    Loader loader = std::move(m_loader);
+    m_loader = nullptr; // 先清空，避免载入过程中重入
+
+    // 载入到临时工作表，成功后才接管单元格：失败时本工作表不含部分数据，恢复loader，
+    // 仍为未载入状态（保存时再次尝试载入，不会以不完整的数据覆盖原文件）
+    Worksheet loaded(m_name);
+    loaded.setSize(1, 1); // 尺寸只来自载入的数据，不带入默认尺寸
+    if (!loader(&loaded)) {
+        m_loader = std::move(loader);
+        return false;
+    }
+    QSignalBlocker blocker(this); // 载入不是修改，不发送cellChanged、sizeChanged
+    takeCells(&loaded);
+    setSize(qMax(m_rowCount, loaded.rowCount()), qMax(m_colCount, loaded.columnCount())); // 文件中记录的尺寸
+    return true;
+}
+
+Worksheet::Loader Worksheet::takeLoader()
+{
+    Loader loader = std::move(m_loader);
+    m_loader = nullptr;
+    return loader;
+}
+
+void Worksheet::takeCells(Worksheet *other)
+{
+    m_rows = std::move(other->m_rows);
+    other->m_rows.clear();
+
+    for (auto rowIt = m_rows.begin(); rowIt != m_rows.end(); ++rowIt) {
+        for (auto it = rowIt->begin(); it != rowIt->end(); ++it) {
+            Cell *cell = it.value().get();
+            if (cell) {
+                cell->disconnect(other); // 断开到原工作表的转发
+                attachCell(rowIt.key(), it.key(), cell);
+            }
+        }
+    }
+}
+
+void Worksheet::mergeCells(Worksheet *other, const QSet<qint64> &keep)
+{
+    const QMap<int, Row> rows = std::move(other->m_rows);
+    other->m_rows.clear();
+
+    // 先扩展到合并后的尺寸，接收cellChanged的视图只需扩展一次
+    if (!rows.isEmpty()) {
+        includeCell(rows.lastKey(), other->m_cellColumns - 1);
+    }
+
+    for (auto rowIt = rows.cbegin(); rowIt != rows.cend(); ++rowIt) {
+        Row &target = m_rows[rowIt.key()];
+        for (auto it = rowIt->cbegin(); it != rowIt->cend(); ++it) {
+            Cell *cell = it.value().get();
+            if (!cell) {
+                continue;
+            }
+            cell->disconnect(other);
+            if (!keep.isEmpty() && keep.contains((qint64(rowIt.key()) << 32) | quint32(it.key()))) {
+                cell->setParent(nullptr); // 丢弃导入的单元格
+                continue;
+            }
+            target.insert(it.key(), it.value()); // 替换原有单元格
+            attachCell(rowIt.key(), it.key(), cell);
+            emit cellChanged(rowIt.key(), it.key());
+        }
+    }
 }
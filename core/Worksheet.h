@@ -1,16 +1,42 @@
 #pragma once
 
 #include <QObject>
-#include <QHash>
+#include <QMap>
+#include <QList>
+#include <QSet>
 #include <memory>
+#include <functional>
+#include <vector>
 
 #include "Cell.h"
+#include "CellBlock.h"
 
 class Worksheet : public QObject
 {
     Q_OBJECT
 
 public:
+    using Row = QMap<int, std::shared_ptr<Cell>>; // 一行中已分配的单元格，按列号有序
+    using Loader = std::function<bool(Worksheet *worksheet)>; // 延迟加载函数，成功返回true
+
+    static constexpr int DefaultRows = 100;
+    static constexpr int DefaultColumns = 26;
+    static constexpr int MaxRows = 1 << 24; // 手动设置尺寸的上限，导入的数据不受此限制
+    static constexpr int MaxColumns = 16384; // A..XFD
+
+    // 排序：范围内有数据的行按各关键字依次比较后重新排列，只移动范围内的列
+    struct SortKey {
+        int column;
+        bool ascending;
+    };
+    struct SortSpec {
+        int firstRow;
+        int lastRow;
+        int firstColumn;
+        int lastColumn;
+        QList<SortKey> keys; // 第一个为主要关键字
+    };
+
     explicit Worksheet(const QString &name = "Sheet1", QObject *parent = nullptr);
 
     // 名称访问与设置
@@ -20,10 +46,18 @@ public:
     // 单元格访问与设置
     std::shared_ptr<Cell> cell(int row, int col);
     void setCell(int row, int col, std::shared_ptr<Cell> cell);
+    std::shared_ptr<Cell> cellAt(int row, int col) const; // 只读访问，单元格不存在时返回nullptr而不创建
 
-    // 表格尺寸查询
+    // 按行号顺序访问已分配的单元格（行号 -> 行）
+    const QMap<int, Row> &rows() const { return m_rows; }
+
+    // 实际使用范围：有值或公式的单元格的最大行列号，无数据时均为-1
+    void usedRange(int *maxRow, int *maxCol) const;
+
+    // 表格尺寸：至少覆盖所有已分配的单元格，分配单元格时自动扩展（不发送sizeChanged，由cellChanged体现）
     int rowCount() const { return m_rowCount; }
     int columnCount() const { return m_colCount; }
+    void setSize(int rows, int cols); // 不会小于已分配单元格的范围
 
     // 表格操作
     void insertRow(int row);
@@ -33,13 +67,48 @@ public:
 
     void clear();
 
+    // 稳定排序，顺序为数字（含数字文本、日期）< 文本（不区分大小写）< 逻辑值，降序时相反；
+    // 空单元格总在最后，范围内完全没有数据的行移到范围末尾。排列由WorksheetSort并行计算，
+    // 然后一次重排存储：整行在范围内时移动整个行对象，单元格只更新坐标
+    void sort(const SortSpec &spec);
+
+    // 延迟加载：打开文件时只建立工作表目录，数据在首次使用前由loader载入
+    void setLoader(Loader loader) { m_loader = std::move(loader); }
+    bool isLoaded() const { return !m_loader; }
+    bool ensureLoaded(); // 尚未载入时执行loader（成功后不再执行；失败时保留loader，仍为未载入状态）
+    Loader takeLoader(); // 取出loader由调用方执行（如在工作线程中载入到临时工作表）
+
+    // 接管other的全部单元格（重新设置父对象与信号连接），other须与本工作表位于同一线程
+    void takeCells(Worksheet *other);
+    // 以other的单元格覆盖本工作表的对应位置（其余单元格保留），逐个发送cellChanged；线程要求同上。
+    // keep中的位置（行 << 32 | 列）保留原有单元格，如渐进式导入期间用户已编辑的单元格
+    void mergeCells(Worksheet *other, const QSet<qint64> &keep = QSet<qint64>());
+
+    // 复制粘贴：快照只引用单元格的内容数据（见CellBlock），不复制文本
+    CellBlock copyCells(int firstRow, int lastRow, int firstColumn, int lastColumn) const;
+    // 以block覆盖从(row, col)开始的区域：区域内block中没有内容的位置被清空，只读单元格保持不变；逐个发送cellChanged
+    void pasteCells(const CellBlock &block, int row, int col);
+    // 删除区域内的单元格（只读单元格除外），逐个发送cellChanged
+    void clearCells(int firstRow, int lastRow, int firstColumn, int lastColumn);
+
 signals:
     void cellChanged(int row, int col);
     void nameChanged(const QString &name);
+    void sizeChanged(int rows, int cols); // setSize及插入、删除行列时发送
+    void aboutToSort(const Worksheet::SortSpec &spec); // 排序前发送（编辑日志在此之前记录已有的修改）
+    void sorted(const Worksheet::SortSpec &spec); // 排序后发送，范围内的单元格不逐个发送cellChanged
 
 private:
+    void attachCell(int row, int col, Cell *cell); // 设置父对象并转发单元格内容改变信号
+    void includeCell(int row, int col); // 扩展尺寸以包含该位置
+    // 按order重排：第i个位置放入sources中第order[i]行的片段，依次写入firstRow开始的各行
+    void permuteRows(const Worksheet::SortSpec &spec, const std::vector<Row *> &sources, const std::vector<int> &order);
+
     QString m_name; // 工作表名称
-    QHash<QPair<int, int>, std::shared_ptr<Cell>> m_cells; // 哈希表存储单元格，只为有数据的单元格分配内存，减少开销
+    QMap<int, Row> m_rows; // 按行、列有序存储单元格，只为有数据的单元格分配内存，并支持按行序遍历
     int m_rowCount;
     int m_colCount; // 行列数
+    int m_cellColumns; // 已分配单元格的列范围（只增不减），行范围即m_rows的最后一个键
+
+    Loader m_loader; // 非空表示数据尚未载入
 };
@@ -0,0 +1,234 @@
+#include "WorksheetSort.h"
+#include "OrderedTasks.h"
+#include "Cell.h"
+
+#include <QDateTime>
+#include <QTimeZone>
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+// 类别按升序时的先后排列；空单元格不论升降序都排在最后
+enum KeyKind : quint8 {
+    NumberKey,
+    TextKey,
+    BoolKey,
+    BlankKey
+};
+
+// 规范化后的关键字：按(类别, 编码)比较即为最终顺序，升降序与空单元格的位置已包含在编码中
+struct SortValue {
+    quint8 kind;
+    quint64 bits;
+
+    bool operator<(const SortValue &other) const
+    {
+        return kind != other.kind ? kind < other.kind : bits < other.bits;
+    }
+    bool operator!=(const SortValue &other) const { return kind != other.kind || bits != other.bits; }
+};
+
+using KeyColumn = std::vector<SortValue>; // 按行序号存放
+
+// 排序的元素：关键字与行序号放在一起
+struct Entry {
+    SortValue primary;
+    int row;
+};
+
+// 保持大小顺序的整数编码：正数置符号位，负数按位取反
+quint64 orderedBits(double value)
+{
+    value += 0.0; // -0与0相同
+    quint64 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const quint64 sign = quint64(1) << 63;
+    return (bits & sign) ? ~bits : (bits | sign);
+}
+
+// 分段数与行数成比例，段数不超过线程数
+int chunkCount(size_t count)
+{
+    if (count < size_t(WorksheetSort::ParallelThreshold)) {
+        return 1;
+    }
+    return int(qMin<size_t>(size_t(qMax(1, QThreadPool::globalInstance()->maxThreadCount())),
+                            count / (WorksheetSort::ParallelThreshold / 2)));
+}
+
+// 并行稳定排序：各段分别stable_sort，然后逐轮归并相邻的段（std::merge在相等时先取前一段，保持稳定）
+template <typename T, typename Less>
+void parallelStableSort(std::vector<T> &items, Less less)
+{
+    const int chunks = chunkCount(items.size());
+    if (chunks <= 1) {
+        std::stable_sort(items.begin(), items.end(), less);
+        return;
+    }
+
+    std::vector<size_t> bounds(chunks + 1);
+    for (int i = 0; i <= chunks; ++i) {
+        bounds[i] = items.size() * size_t(i) / size_t(chunks);
+    }
+    const auto ignore = [](int, bool) { return true; };
+    runOrdered<bool>(chunks, [&](int i) {
+        std::stable_sort(items.begin() + bounds[i], items.begin() + bounds[i + 1], less);
+        return true;
+    }, ignore);
+
+    std::vector<T> merged(items.size());
+    while (bounds.size() > 2) {
+        const int segments = int(bounds.size()) - 1;
+        runOrdered<bool>((segments + 1) / 2, [&](int pair) {
+            const size_t begin = bounds[2 * pair];
+            const size_t middle = bounds[qMin(2 * pair + 1, segments)];
+            const size_t end = bounds[qMin(2 * pair + 2, segments)];
+            std::merge(items.begin() + begin, items.begin() + middle, items.begin() + middle, items.begin() + end,
+                       merged.begin() + begin, less); // 落单的最后一段原样复制
+            return true;
+        }, ignore);
+
+        items.swap(merged);
+        std::vector<size_t> next;
+        for (int i = 0; i < segments; i += 2) {
+            next.push_back(bounds[i]);
+        }
+        next.push_back(bounds.back());
+        bounds.swap(next);
+    }
+}
+
+// 单元格的关键字；文本返回TextKey，由调用方汇总后换算为名次
+KeyKind normalize(const Cell *cell, double *number, QString *text)
+{
+    if (!cell) {
+        return BlankKey;
+    }
+    const QVariant value = cell->value();
+    switch (value.typeId()) {
+    case QMetaType::UnknownType:
+        return BlankKey;
+    case QMetaType::Bool:
+        *number = value.toBool() ? 1 : 0;
+        return BoolKey;
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::LongLong:
+    case QMetaType::ULongLong:
+    case QMetaType::Double:
+    case QMetaType::Float:
+        *number = value.toDouble();
+        return NumberKey;
+    case QMetaType::QDate:
+        *number = double(value.toDate().startOfDay(QTimeZone::UTC).toMSecsSinceEpoch());
+        return NumberKey;
+    case QMetaType::QDateTime:
+        *number = double(value.toDateTime().toMSecsSinceEpoch());
+        return NumberKey;
+    case QMetaType::QTime:
+        *number = value.toTime().msecsSinceStartOfDay();
+        return NumberKey;
+    default:
+        break;
+    }
+
+    *text = value.toString();
+    if (text->isEmpty()) {
+        return BlankKey;
+    }
+    bool ok = false;
+    const double parsed = text->toDouble(&ok); // CSV导入的数字以文本保存
+    if (ok && !qIsNaN(parsed)) {
+        *number = parsed;
+        return NumberKey;
+    }
+    return TextKey;
+}
+
+// 关键字列的规范化：各段并行读取单元格，文本按段的顺序汇总后并行排序，相同（不区分大小写）的文本名次相同
+KeyColumn normalizeColumn(const std::vector<const Worksheet::Row *> &rows, const Worksheet::SortKey &key)
+{
+    const size_t count = rows.size();
+    std::vector<quint8> kinds(count);
+    std::vector<double> values(count);
+
+    using Texts = std::vector<std::pair<int, QString>>;
+    const int chunks = chunkCount(count);
+    Texts texts;
+    runOrdered<Texts>(chunks, [&](int chunk) {
+        Texts chunkTexts;
+        const size_t end = count * size_t(chunk + 1) / size_t(chunks);
+        for (size_t i = count * size_t(chunk) / size_t(chunks); i < end; ++i) {
+            double number = 0;
+            QString text;
+            const KeyKind kind = normalize(rows[i]->value(key.column).get(), &number, &text);
+            kinds[i] = kind;
+            values[i] = number;
+            if (kind == TextKey) {
+                chunkTexts.emplace_back(int(i), std::move(text));
+            }
+        }
+        return chunkTexts;
+    }, [&](int, Texts &chunkTexts) {
+        texts.insert(texts.end(), std::make_move_iterator(chunkTexts.begin()), std::make_move_iterator(chunkTexts.end()));
+        return true;
+    });
+
+    std::vector<int> ranking(texts.size());
+    for (size_t i = 0; i < ranking.size(); ++i) {
+        ranking[i] = int(i);
+    }
+    parallelStableSort(ranking, [&texts](int a, int b) {
+        return QString::compare(texts[a].second, texts[b].second, Qt::CaseInsensitive) < 0;
+    });
+
+    double rank = 0;
+    for (size_t i = 0; i < ranking.size(); ++i) {
+        if (i > 0 && QString::compare(texts[ranking[i - 1]].second, texts[ranking[i]].second, Qt::CaseInsensitive) != 0) {
+            ++rank;
+        }
+        values[texts[ranking[i]].first] = rank;
+    }
+
+    // 降序时类别与数值都反转，空单元格仍在最后
+    KeyColumn column(count);
+    for (size_t i = 0; i < count; ++i) {
+        if (kinds[i] == BlankKey) {
+            column[i] = SortValue{BlankKey, 0};
+        }
+        else if (key.ascending) {
+            column[i] = SortValue{kinds[i], orderedBits(values[i])};
+        }
+        else {
+            column[i] = SortValue{quint8(BoolKey - kinds[i]), ~orderedBits(values[i])};
+        }
+    }
+    return column;
+}
+
+} // namespace
+
+std::vector<int> WorksheetSort::permutation(const std::vector<const Worksheet::Row *> &rows,
+                                            const QList<Worksheet::SortKey> &keys)
+{
+    std::vector<int> order(rows.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = int(i);
+    }
+
+    // 从最后一个关键字开始，每个关键字做一次稳定排序：每次比较只读取元素自身，不随机访问其他关键字
+    std::vector<Entry> entries(rows.size());
+    for (qsizetype k = keys.size() - 1; k >= 0; --k) {
+        const KeyColumn column = normalizeColumn(rows, keys.at(k));
+        for (size_t i = 0; i < entries.size(); ++i) {
+            entries[i] = Entry{column[order[i]], order[i]};
+        }
+        parallelStableSort(entries, [](const Entry &a, const Entry &b) { return a.primary < b.primary; });
+        for (size_t i = 0; i < entries.size(); ++i) {
+            order[i] = entries[i].row;
+        }
+    }
+    return order;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <vector>
+
+#include "Worksheet.h"
+
+// 多关键字排序的排列计算：不移动单元格，只求出行的新顺序，由Worksheet::sort一次重排存储
+//
+//   1. 规范化：每个关键字列转换为可直接比较的(类别, 64位编码)——数字、数字文本与日期取数值，
+//      文本取其在该列所有文本中的名次（不区分大小写），升降序体现在编码中，比较时不再访问单元格或比较字符串
+//   2. 排序：从最后一个关键字开始，每个关键字对(编码, 行序号)数组做一次稳定排序；
+//      数组分段在线程池中排序，再逐轮两两归并（各轮的归并并行进行）
+class WorksheetSort
+{
+public:
+    static constexpr int ParallelThreshold = 1 << 16; // 行数少于此值时在当前线程排序
+
+    // rows为参与排序的行（按原顺序），返回排序后的顺序：第i个位置为rows中的第order[i]行
+    static std::vector<int> permutation(const std::vector<const Worksheet::Row *> &rows,
+                                        const QList<Worksheet::SortKey> &keys);
+};
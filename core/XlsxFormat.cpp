@@ -0,0 +1,965 @@
+#include "XlsxFormat.h"
+#include "Cell.h"
+#include "Worksheet.h"
+#include "ZipArchive.h"
+
+#include <QSaveFile>
+#include <QXmlStreamReader>
+#include <QHash>
+#include <QSet>
+#include <QDate>
+#include <QDateTime>
+#include <QDir>
+#include <QLocale>
+#include <QStringList>
+#include <QDebug>
+#include <cmath>
+#include <memory>
+
+namespace {
+
+const char MainNamespace[] = "http://schemas.openxmlformats.org/spreadsheetml/2006/main";
+const char RelationshipNamespace[] = "http://schemas.openxmlformats.org/officeDocument/2006/relationships";
+const char PackageRelationshipNamespace[] = "http://schemas.openxmlformats.org/package/2006/relationships";
+const char XmlDeclaration[] = "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n";
+const qsizetype FlushSize = 64 * 1024; // 工作表XML每积累这么多字节交给压缩
+
+// 保存时写出的样式表：cellXfs的第1、2项分别是日期与日期时间格式
+enum SavedStyle {
+    StyleDefault = 0,
+    StyleDate = 1,
+    StyleDateTime = 2
+};
+
+const char StylesXml[] =
+    "<styleSheet xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\">"
+    "<numFmts count=\"1\"><numFmt numFmtId=\"164\" formatCode=\"yyyy-mm-dd hh:mm:ss\"/></numFmts>"
+    "<fonts count=\"1\"><font><sz val=\"11\"/><name val=\"Calibri\"/></font></fonts>"
+    "<fills count=\"2\"><fill><patternFill patternType=\"none\"/></fill>"
+    "<fill><patternFill patternType=\"gray125\"/></fill></fills>"
+    "<borders count=\"1\"><border><left/><right/><top/><bottom/><diagonal/></border></borders>"
+    "<cellStyleXfs count=\"1\"><xf numFmtId=\"0\" fontId=\"0\" fillId=\"0\" borderId=\"0\"/></cellStyleXfs>"
+    "<cellXfs count=\"3\">"
+    "<xf numFmtId=\"0\" fontId=\"0\" fillId=\"0\" borderId=\"0\" xfId=\"0\"/>"
+    "<xf numFmtId=\"14\" fontId=\"0\" fillId=\"0\" borderId=\"0\" xfId=\"0\" applyNumberFormat=\"1\"/>"
+    "<xf numFmtId=\"164\" fontId=\"0\" fillId=\"0\" borderId=\"0\" xfId=\"0\" applyNumberFormat=\"1\"/>"
+    "</cellXfs>"
+    "<cellStyles count=\"1\"><cellStyle name=\"Normal\" xfId=\"0\" builtinId=\"0\"/></cellStyles>"
+    "</styleSheet>";
+
+// 样式的数字格式决定数值的含义
+enum NumberKind : quint8 {
+    PlainNumber,
+    DateNumber,
+    DateTimeNumber
+};
+
+// 日期序列号的起点。1900日期系统的序列号沿用了1900年2月29日这一不存在的日期，
+// 以1899-12-30为起点时1900年3月以后的日期正确
+QDate dateEpoch(bool date1904)
+{
+    return date1904 ? QDate(1904, 1, 1) : QDate(1899, 12, 30);
+}
+
+QVariant serialToDate(double serial, NumberKind kind, bool date1904)
+{
+    const double days = std::floor(serial);
+    const QDate date = dateEpoch(date1904).addDays(qint64(days));
+    if (kind == DateNumber) {
+        return date;
+    }
+    return QDateTime(date, QTime(0, 0)).addMSecs(qRound64((serial - days) * 86400000.0));
+}
+
+double dateToSerial(const QDate &date)
+{
+    return double(dateEpoch(false).daysTo(date));
+}
+
+// ---------------------------------------------------------------- 单元格引用与转义
+
+// A1形式的引用，行列从0开始
+void appendCellReference(QByteArray &out, int row, int col)
+{
+    char letters[8];
+    int count = 0;
+    for (int c = col + 1; c > 0; c = (c - 1) / 26) {
+        letters[count++] = char('A' + (c - 1) % 26);
+    }
+    while (count > 0) {
+        out += letters[--count];
+    }
+    out += QByteArray::number(row + 1);
+}
+
+bool parseCellReference(QStringView ref, int *row, int *col)
+{
+    qint64 c = 0;
+    qint64 r = 0;
+    qsizetype i = 0;
+    for (; i < ref.size() && c <= XlsxFormat::MaxColumns; ++i) {
+        const char16_t letter = ref.at(i).unicode() & ~char16_t(0x20); // 转为大写
+        if (letter < u'A' || letter > u'Z') {
+            break;
+        }
+        c = c * 26 + (letter - u'A' + 1);
+    }
+    for (; i < ref.size() && r <= XlsxFormat::MaxRows; ++i) {
+        const char16_t digit = ref.at(i).unicode();
+        if (digit < u'0' || digit > u'9') {
+            break;
+        }
+        r = r * 10 + (digit - u'0');
+    }
+    if (i != ref.size() || c < 1 || c > XlsxFormat::MaxColumns || r < 1 || r > XlsxFormat::MaxRows) {
+        return false;
+    }
+    *row = int(r - 1);
+    *col = int(c - 1);
+    return true;
+}
+
+bool isHexDigit(char c)
+{
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+// OOXML中XML不允许的字符写为_xHHHH_，字面上形如_xHHHH_的文本则把下划线写为_x005F_
+bool looksLikeEscape(const QByteArray &text, qsizetype i)
+{
+    return i + 6 < text.size() && text.at(i + 1) == 'x' && text.at(i + 6) == '_'
+           && isHexDigit(text.at(i + 2)) && isHexDigit(text.at(i + 3))
+           && isHexDigit(text.at(i + 4)) && isHexDigit(text.at(i + 5));
+}
+
+void appendEscaped(QByteArray &out, const QString &text)
+{
+    static const char hex[] = "0123456789ABCDEF";
+    const QByteArray utf8 = text.toUtf8();
+    for (qsizetype i = 0; i < utf8.size(); ++i) {
+        const char c = utf8.at(i);
+        switch (c) {
+        case '&': out += "&amp;"; break;
+        case '<': out += "&lt;"; break;
+        case '>': out += "&gt;"; break;
+        case '"': out += "&quot;"; break;
+        case '_':
+            out += looksLikeEscape(utf8, i) ? "_x005F_" : "_";
+            break;
+        default:
+            if (uchar(c) < 0x20 && c != '\t' && c != '\n') { // 包括\r，否则读取时会被规范化为\n
+                out += "_x00";
+                out += hex[uchar(c) >> 4];
+                out += hex[uchar(c) & 0x0F];
+                out += '_';
+            }
+            else {
+                out += c;
+            }
+            break;
+        }
+    }
+}
+
+QString decodeEscapes(const QString &text)
+{
+    if (!text.contains(QLatin1String("_x"))) {
+        return text;
+    }
+    QString result;
+    result.reserve(text.size());
+    for (qsizetype i = 0; i < text.size(); ++i) {
+        if (text.at(i) == QLatin1Char('_') && i + 6 < text.size() && text.at(i + 1) == QLatin1Char('x')
+            && text.at(i + 6) == QLatin1Char('_')) {
+            bool ok = false;
+            const ushort code = QStringView(text).mid(i + 2, 4).toUShort(&ok, 16);
+            if (ok) {
+                result += QChar(code);
+                i += 6;
+                continue;
+            }
+        }
+        result += text.at(i);
+    }
+    return result;
+}
+
+// ---------------------------------------------------------------- 读取
+
+struct XlsxSource {
+    ZipReader zip;
+    QStringList sharedStrings;
+    QList<NumberKind> styles; // cellXfs序号 -> 数值含义
+    bool date1904 = false;
+};
+
+struct Relationship {
+    QString type;
+    QString target; // 已解析为包内的完整路径
+};
+
+// 流式读取一个XML部件：QXmlStreamReader的数据用完时从解压流补充下一段
+class PartReader
+{
+public:
+    PartReader(const ZipReader &zip, const ZipReader::Entry &entry)
+        : m_stream(zip.stream(entry))
+    {}
+
+    QXmlStreamReader::TokenType readNext()
+    {
+        QXmlStreamReader::TokenType token = m_xml.readNext();
+        while (m_xml.error() == QXmlStreamReader::PrematureEndOfDocumentError) {
+            const QByteArray chunk = m_stream.read();
+            if (chunk.isEmpty()) {
+                break;
+            }
+            m_xml.addData(chunk);
+            token = m_xml.readNext();
+        }
+        return token;
+    }
+
+    bool atEnd() const { return m_xml.tokenType() == QXmlStreamReader::EndDocument || hasError(); }
+    bool hasError() const { return m_xml.hasError() || m_stream.hasError(); }
+    QXmlStreamReader &xml() { return m_xml; }
+
+private:
+    ZipReader::Stream m_stream;
+    QXmlStreamReader m_xml;
+};
+
+// 部件part的关系文件：<目录>/_rels/<文件名>.rels
+QString relationshipPart(const QString &part)
+{
+    const qsizetype slash = part.lastIndexOf(QLatin1Char('/'));
+    return part.left(slash + 1) + QLatin1String("_rels/") + part.mid(slash + 1) + QLatin1String(".rels");
+}
+
+// 关系目标相对于源部件所在目录，以'/'开头时为包内绝对路径
+QString resolveTarget(const QString &part, const QString &target)
+{
+    if (target.startsWith(QLatin1Char('/'))) {
+        return target.mid(1);
+    }
+    const qsizetype slash = part.lastIndexOf(QLatin1Char('/'));
+    return QDir::cleanPath(part.left(slash + 1) + target);
+}
+
+// 读取部件part的关系（Id -> 关系），没有关系文件时返回空
+QHash<QString, Relationship> readRelationships(const ZipReader &zip, const QString &part)
+{
+    QHash<QString, Relationship> relationships;
+    const ZipReader::Entry *entry = zip.entry(relationshipPart(part));
+    if (!entry) {
+        return relationships;
+    }
+
+    PartReader reader(zip, *entry);
+    while (!reader.atEnd()) {
+        if (reader.readNext() == QXmlStreamReader::StartElement
+            && reader.xml().name() == QLatin1String("Relationship")) {
+            const QXmlStreamAttributes attributes = reader.xml().attributes();
+            if (attributes.value(QLatin1String("TargetMode")) == QLatin1String("External")) {
+                continue;
+            }
+            relationships.insert(attributes.value(QLatin1String("Id")).toString(),
+                                 {attributes.value(QLatin1String("Type")).toString(),
+                                  resolveTarget(part, attributes.value(QLatin1String("Target")).toString())});
+        }
+    }
+    return relationships;
+}
+
+struct SheetInfo {
+    QString name;
+    QString part; // 不是普通工作表（如图表工作表）时为空
+};
+
+bool readWorkbookPart(XlsxSource &source, const QString &part, const QHash<QString, Relationship> &relationships,
+                      QList<SheetInfo> *sheets, int *activeTab)
+{
+    const ZipReader::Entry *entry = source.zip.entry(part);
+    if (!entry) {
+        return false;
+    }
+
+    PartReader reader(source.zip, *entry);
+    QXmlStreamReader &xml = reader.xml();
+    while (!reader.atEnd()) {
+        if (reader.readNext() != QXmlStreamReader::StartElement) {
+            continue;
+        }
+        const QStringView name = xml.name();
+        const QXmlStreamAttributes attributes = xml.attributes();
+        if (name == QLatin1String("workbookPr")) {
+            const QStringView date1904 = attributes.value(QLatin1String("date1904"));
+            source.date1904 = date1904 == QLatin1String("1") || date1904 == QLatin1String("true");
+        }
+        else if (name == QLatin1String("workbookView")) {
+            *activeTab = attributes.value(QLatin1String("activeTab")).toInt();
+        }
+        else if (name == QLatin1String("sheet")) {
+            SheetInfo sheet;
+            sheet.name = attributes.value(QLatin1String("name")).toString();
+            for (const QXmlStreamAttribute &attribute : attributes) {
+                if (attribute.name() == QLatin1String("id")) { // r:id，命名空间前缀不固定
+                    const Relationship relationship = relationships.value(attribute.value().toString());
+                    if (relationship.type.endsWith(QLatin1String("/worksheet"))) {
+                        sheet.part = relationship.target;
+                    }
+                }
+            }
+            sheets->append(sheet);
+        }
+    }
+    return !reader.hasError();
+}
+
+bool readSharedStrings(XlsxSource &source, const QString &part)
+{
+    const ZipReader::Entry *entry = source.zip.entry(part);
+    if (!entry) {
+        return false;
+    }
+
+    // 富文本的各段<r><t>依次拼接，注音<rPh>中的文字不属于字符串
+    PartReader reader(source.zip, *entry);
+    QXmlStreamReader &xml = reader.xml();
+    QString text;
+    bool inText = false;
+    int phonetic = 0;
+    while (!reader.atEnd()) {
+        switch (reader.readNext()) {
+        case QXmlStreamReader::StartElement: {
+            const QStringView name = xml.name();
+            if (name == QLatin1String("si")) {
+                text.clear();
+            }
+            else if (name == QLatin1String("t")) {
+                inText = phonetic == 0;
+            }
+            else if (name == QLatin1String("rPh")) {
+                ++phonetic;
+            }
+            else if (name == QLatin1String("sst")) {
+                const int count = xml.attributes().value(QLatin1String("uniqueCount")).toInt();
+                source.sharedStrings.reserve(qBound(0, count, 1 << 24));
+            }
+            break;
+        }
+        case QXmlStreamReader::Characters:
+            if (inText) {
+                text += xml.text();
+            }
+            break;
+        case QXmlStreamReader::EndElement: {
+            const QStringView name = xml.name();
+            if (name == QLatin1String("t")) {
+                inText = false;
+            }
+            else if (name == QLatin1String("rPh")) {
+                --phonetic;
+            }
+            else if (name == QLatin1String("si")) {
+                source.sharedStrings.append(decodeEscapes(text));
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    return !reader.hasError();
+}
+
+// 数字格式是否表示日期：内置格式按编号，自定义格式查找引号、方括号与转义以外的年、日与时、秒占位符
+NumberKind numberFormatKind(int id, const QString &code)
+{
+    if (id >= 14 && id <= 17) {
+        return DateNumber;
+    }
+    if (id == 22) {
+        return DateTimeNumber;
+    }
+
+    bool hasDate = false;
+    bool hasTime = false;
+    bool quoted = false;
+    bool bracketed = false;
+    for (qsizetype i = 0; i < code.size(); ++i) {
+        const char16_t c = code.at(i).toLower().unicode();
+        if (quoted) {
+            quoted = c != u'"';
+            continue;
+        }
+        if (bracketed) {
+            bracketed = c != u']';
+            continue;
+        }
+        switch (c) {
+        case u'"': quoted = true; break;
+        case u'[': bracketed = true; break;
+        case u'\\':
+        case u'_':
+        case u'*': ++i; break; // 后面的一个字符是字面文字或填充字符
+        case u'y':
+        case u'd': hasDate = true; break;
+        case u'h':
+        case u's': hasTime = true; break;
+        default: break;
+        }
+    }
+    return !hasDate ? PlainNumber : hasTime ? DateTimeNumber : DateNumber;
+}
+
+bool readStyles(XlsxSource &source, const QString &part)
+{
+    const ZipReader::Entry *entry = source.zip.entry(part);
+    if (!entry) {
+        return false;
+    }
+
+    PartReader reader(source.zip, *entry);
+    QXmlStreamReader &xml = reader.xml();
+    QHash<int, QString> formats;
+    bool inCellXfs = false;
+    while (!reader.atEnd()) {
+        const QXmlStreamReader::TokenType token = reader.readNext();
+        if (token == QXmlStreamReader::EndElement && xml.name() == QLatin1String("cellXfs")) {
+            inCellXfs = false;
+        }
+        if (token != QXmlStreamReader::StartElement) {
+            continue;
+        }
+        const QStringView name = xml.name();
+        const QXmlStreamAttributes attributes = xml.attributes();
+        if (name == QLatin1String("numFmt")) {
+            formats.insert(attributes.value(QLatin1String("numFmtId")).toInt(),
+                           attributes.value(QLatin1String("formatCode")).toString());
+        }
+        else if (name == QLatin1String("cellXfs")) {
+            inCellXfs = true;
+        }
+        else if (inCellXfs && name == QLatin1String("xf")) {
+            const int id = attributes.value(QLatin1String("numFmtId")).toInt();
+            source.styles.append(numberFormatKind(id, formats.value(id)));
+        }
+    }
+    return !reader.hasError();
+}
+
+// 一个<c>元素的内容
+struct CellData {
+    int row = 0;
+    int col = 0;
+    QString type; // t属性，缺省为数值
+    int style = 0;
+    QString value; // <v>
+    QString formula; // <f>，共享公式的从属单元格为空
+    bool hasFormula = false;
+    QString inlineText; // <is>中的文字
+};
+
+void storeCell(const XlsxSource &source, const CellData &data, Worksheet *worksheet)
+{
+    QVariant value;
+    if (data.type == QLatin1String("s")) {
+        bool ok = false;
+        const int index = data.value.toInt(&ok);
+        if (ok && index >= 0 && index < source.sharedStrings.size()) {
+            value = source.sharedStrings.at(index);
+        }
+    }
+    else if (data.type == QLatin1String("inlineStr")) {
+        value = decodeEscapes(data.inlineText);
+    }
+    else if (data.type == QLatin1String("b")) {
+        value = data.value.trimmed() == QLatin1String("1");
+    }
+    else if (data.type == QLatin1String("str") || data.type == QLatin1String("e")) {
+        value = decodeEscapes(data.value); // 公式的文本结果或错误值（如#N/A）
+    }
+    else if (data.type == QLatin1String("d")) {
+        value = data.value.contains(QLatin1Char('T')) ? QVariant(QDateTime::fromString(data.value, Qt::ISODate))
+                                                      : QVariant(QDate::fromString(data.value, Qt::ISODate));
+    }
+    else if (!data.value.isEmpty()) {
+        bool ok = false;
+        const double number = data.value.toDouble(&ok);
+        const NumberKind kind = data.style >= 0 && data.style < source.styles.size() ? source.styles.at(data.style)
+                                                                                      : PlainNumber;
+        if (ok) {
+            value = kind == PlainNumber ? QVariant(number) : serialToDate(number, kind, source.date1904);
+        }
+    }
+
+    const bool hasFormula = data.hasFormula && !data.formula.isEmpty();
+    if (!hasFormula && value.isNull()) {
+        return; // 只有格式的空单元格不分配
+    }
+
+    auto cell = worksheet->cell(data.row, data.col);
+    if (hasFormula) {
+        cell->setFormula(QLatin1Char('=') + data.formula);
+    }
+    else {
+        cell->setValue(value);
+    }
+}
+
+// 流式解析一个工作表部件，逐个单元格写入worksheet
+bool loadSheet(const XlsxSource &source, const QString &part, Worksheet *worksheet)
+{
+    const ZipReader::Entry *entry = source.zip.entry(part);
+    if (!entry) {
+        return false;
+    }
+
+    enum TextTarget {
+        NoText,
+        ValueText,
+        FormulaText,
+        InlineText
+    };
+
+    PartReader reader(source.zip, *entry);
+    QXmlStreamReader &xml = reader.xml();
+    CellData cell;
+    TextTarget target = NoText;
+    bool inCell = false;
+    int phonetic = 0;
+    int currentRow = -1;
+    int nextCol = 0;
+
+    while (!reader.atEnd()) {
+        switch (reader.readNext()) {
+        case QXmlStreamReader::StartElement: {
+            const QStringView name = xml.name();
+            if (name == QLatin1String("c")) {
+                // 行列号缺省时接在同一行的上一个单元格之后
+                const QXmlStreamAttributes attributes = xml.attributes();
+                const QStringView ref = attributes.value(QLatin1String("r"));
+                if (ref.isEmpty() || !parseCellReference(ref, &cell.row, &cell.col)) {
+                    cell.row = currentRow;
+                    cell.col = nextCol;
+                }
+                nextCol = cell.col + 1;
+                cell.type = attributes.value(QLatin1String("t")).toString();
+                cell.style = attributes.value(QLatin1String("s")).toInt();
+                cell.value.clear();
+                cell.formula.clear();
+                cell.inlineText.clear();
+                cell.hasFormula = false;
+                inCell = cell.row >= 0 && cell.row < XlsxFormat::MaxRows && cell.col < XlsxFormat::MaxColumns;
+            }
+            else if (name == QLatin1String("row")) {
+                bool ok = false;
+                const int number = xml.attributes().value(QLatin1String("r")).toInt(&ok);
+                currentRow = ok && number > 0 ? number - 1 : currentRow + 1;
+                nextCol = 0;
+            }
+            else if (inCell && name == QLatin1String("v")) {
+                target = ValueText;
+            }
+            else if (inCell && name == QLatin1String("f")) {
+                target = FormulaText;
+                cell.hasFormula = true;
+            }
+            else if (inCell && name == QLatin1String("rPh")) {
+                ++phonetic;
+            }
+            else if (inCell && name == QLatin1String("t") && phonetic == 0) {
+                target = InlineText;
+            }
+            break;
+        }
+        case QXmlStreamReader::Characters:
+            switch (target) {
+            case ValueText: cell.value += xml.text(); break;
+            case FormulaText: cell.formula += xml.text(); break;
+            case InlineText: cell.inlineText += xml.text(); break;
+            case NoText: break;
+            }
+            break;
+        case QXmlStreamReader::EndElement: {
+            const QStringView name = xml.name();
+            if (name == QLatin1String("c")) {
+                if (inCell) {
+                    storeCell(source, cell, worksheet);
+                }
+                inCell = false;
+            }
+            else if (name == QLatin1String("rPh")) {
+                --phonetic;
+            }
+            else if (name == QLatin1String("v") || name == QLatin1String("f") || name == QLatin1String("t")) {
+                target = NoText;
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    return !reader.hasError();
+}
+
+// ---------------------------------------------------------------- 保存
+
+// Excel的工作表名不能含有[]:*?/\，不超过31个字符，且不区分大小写地唯一
+QStringList sheetNames(const Workbook *workbook)
+{
+    const int MaxNameLength = 31;
+    QStringList names;
+    QSet<QString> used;
+    for (int i = 0; i < workbook->worksheetCount(); ++i) {
+        auto worksheet = workbook->worksheet(i);
+        QString name = worksheet ? worksheet->name() : QString();
+        for (QChar &c : name) {
+            if (QStringLiteral("[]:*?/\\").contains(c)) {
+                c = QLatin1Char('_');
+            }
+        }
+        name = name.left(MaxNameLength);
+        if (name.trimmed().isEmpty()) {
+            name = QStringLiteral("Sheet%1").arg(i + 1);
+        }
+
+        QString unique = name;
+        for (int suffix = 2; used.contains(unique.toLower()); ++suffix) {
+            const QString tail = QStringLiteral(" (%1)").arg(suffix);
+            unique = name.left(MaxNameLength - tail.size()) + tail;
+        }
+        used.insert(unique.toLower());
+        names.append(unique);
+    }
+    return names;
+}
+
+QByteArray contentTypes(int sheetCount)
+{
+    QByteArray xml = XmlDeclaration;
+    xml += "<Types xmlns=\"http://schemas.openxmlformats.org/package/2006/content-types\">"
+           "<Default Extension=\"rels\" ContentType=\"application/vnd.openxmlformats-package.relationships+xml\"/>"
+           "<Default Extension=\"xml\" ContentType=\"application/xml\"/>"
+           "<Override PartName=\"/xl/workbook.xml\" "
+           "ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.sheet.main+xml\"/>"
+           "<Override PartName=\"/xl/styles.xml\" "
+           "ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.styles+xml\"/>";
+    for (int i = 1; i <= sheetCount; ++i) {
+        xml += "<Override PartName=\"/xl/worksheets/sheet" + QByteArray::number(i) + ".xml\" "
+               "ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.worksheet+xml\"/>";
+    }
+    xml += "</Types>";
+    return xml;
+}
+
+QByteArray packageRelationships()
+{
+    QByteArray xml = XmlDeclaration;
+    xml += "<Relationships xmlns=\"";
+    xml += PackageRelationshipNamespace;
+    xml += "\"><Relationship Id=\"rId1\" Type=\"";
+    xml += RelationshipNamespace;
+    xml += "/officeDocument\" Target=\"xl/workbook.xml\"/></Relationships>";
+    return xml;
+}
+
+// 工作表的关系为rId1..rIdN，样式为rId(N+1)
+QByteArray workbookRelationships(int sheetCount)
+{
+    QByteArray xml = XmlDeclaration;
+    xml += "<Relationships xmlns=\"";
+    xml += PackageRelationshipNamespace;
+    xml += "\">";
+    for (int i = 1; i <= sheetCount; ++i) {
+        xml += "<Relationship Id=\"rId" + QByteArray::number(i) + "\" Type=\"";
+        xml += RelationshipNamespace;
+        xml += "/worksheet\" Target=\"worksheets/sheet" + QByteArray::number(i) + ".xml\"/>";
+    }
+    xml += "<Relationship Id=\"rId" + QByteArray::number(sheetCount + 1) + "\" Type=\"";
+    xml += RelationshipNamespace;
+    xml += "/styles\" Target=\"styles.xml\"/></Relationships>";
+    return xml;
+}
+
+QByteArray workbookXml(const QStringList &names, int currentIndex)
+{
+    QByteArray xml = XmlDeclaration;
+    xml += "<workbook xmlns=\"";
+    xml += MainNamespace;
+    xml += "\" xmlns:r=\"";
+    xml += RelationshipNamespace;
+    xml += "\"><bookViews><workbookView activeTab=\"" + QByteArray::number(qMax(0, currentIndex)) + "\"/></bookViews><sheets>";
+    for (int i = 0; i < names.size(); ++i) {
+        xml += "<sheet name=\"";
+        appendEscaped(xml, names.at(i));
+        xml += "\" sheetId=\"" + QByteArray::number(i + 1) + "\" r:id=\"rId" + QByteArray::number(i + 1) + "\"/>";
+    }
+    xml += "</sheets></workbook>";
+    return xml;
+}
+
+void appendCell(QByteArray &out, int row, int col, const Cell *cell)
+{
+    const QVariant value = cell->value();
+    QString formula = cell->formula();
+    if (formula.startsWith(QLatin1Char('='))) {
+        formula.remove(0, 1);
+    }
+
+    // 值的表示：数值写入<v>；文本在有公式时为公式结果（t="str"），否则为内联字符串
+    QByteArray number;
+    QString text;
+    bool isText = false;
+    const char *type = nullptr;
+    int style = StyleDefault;
+    switch (value.typeId()) {
+    case QMetaType::UnknownType:
+        break;
+    case QMetaType::Bool:
+        type = "b";
+        number = value.toBool() ? "1" : "0";
+        break;
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::LongLong:
+    case QMetaType::ULongLong:
+    case QMetaType::Short:
+    case QMetaType::UShort:
+        number = QByteArray::number(value.toLongLong());
+        break;
+    case QMetaType::Double:
+    case QMetaType::Float: {
+        const double d = value.toDouble();
+        if (std::isfinite(d)) {
+            number = QByteArray::number(d, 'g', QLocale::FloatingPointShortest);
+        }
+        else {
+            isText = true; // Excel没有无穷大与NaN
+            text = value.toString();
+        }
+        break;
+    }
+    case QMetaType::QDate:
+        if (value.toDate().isValid()) {
+            style = StyleDate;
+            number = QByteArray::number(dateToSerial(value.toDate()), 'g', QLocale::FloatingPointShortest);
+        }
+        break;
+    case QMetaType::QDateTime: {
+        const QDateTime dateTime = value.toDateTime();
+        if (dateTime.isValid()) {
+            style = StyleDateTime;
+            const double serial = dateToSerial(dateTime.date()) + dateTime.time().msecsSinceStartOfDay() / 86400000.0;
+            number = QByteArray::number(serial, 'g', QLocale::FloatingPointShortest);
+        }
+        break;
+    }
+    default:
+        isText = true;
+        text = value.toString();
+        break;
+    }
+    if (isText) {
+        type = formula.isEmpty() ? "inlineStr" : "str";
+    }
+
+    out += "<c r=\"";
+    appendCellReference(out, row, col);
+    out += '"';
+    if (type) {
+        out += " t=\"";
+        out += type;
+        out += '"';
+    }
+    if (style != StyleDefault) {
+        out += " s=\"" + QByteArray::number(style) + '"';
+    }
+    out += '>';
+    if (!formula.isEmpty()) {
+        out += "<f>";
+        appendEscaped(out, formula);
+        out += "</f>";
+    }
+    if (isText && formula.isEmpty()) {
+        out += "<is><t xml:space=\"preserve\">";
+        appendEscaped(out, text);
+        out += "</t></is>";
+    }
+    else if (isText) {
+        out += "<v>";
+        appendEscaped(out, text);
+        out += "</v>";
+    }
+    else if (!number.isEmpty()) {
+        out += "<v>" + number + "</v>";
+    }
+    out += "</c>";
+}
+
+// 逐行生成工作表XML，每积累FlushSize字节交给压缩，内存中只保留当前这一段
+bool writeWorksheet(ZipWriter &zip, const Worksheet *worksheet, int number)
+{
+    if (!zip.beginEntry(QStringLiteral("xl/worksheets/sheet%1.xml").arg(number))) {
+        return false;
+    }
+
+    int maxRow = -1;
+    int maxCol = -1;
+    worksheet->usedRange(&maxRow, &maxCol);
+
+    QByteArray out = XmlDeclaration;
+    out += "<worksheet xmlns=\"";
+    out += MainNamespace;
+    out += "\" xmlns:r=\"";
+    out += RelationshipNamespace;
+    out += "\"><dimension ref=\"A1";
+    if (maxRow >= 0 && maxCol >= 0) {
+        out += ':';
+        appendCellReference(out, qMin(maxRow, XlsxFormat::MaxRows - 1), qMin(maxCol, XlsxFormat::MaxColumns - 1));
+    }
+    out += "\"/><sheetData>";
+
+    const QMap<int, Worksheet::Row> &rows = worksheet->rows();
+    for (auto rowIt = rows.cbegin(); rowIt != rows.cend() && rowIt.key() < XlsxFormat::MaxRows; ++rowIt) {
+        const qsizetype rowStart = out.size();
+        out += "<row r=\"" + QByteArray::number(rowIt.key() + 1) + "\">";
+        const qsizetype cellsStart = out.size();
+        const Worksheet::Row &cells = rowIt.value();
+        for (auto it = cells.cbegin(); it != cells.cend() && it.key() < XlsxFormat::MaxColumns; ++it) {
+            const Cell *cell = it.value().get();
+            if (cell && !cell->isEmpty()) {
+                appendCell(out, rowIt.key(), it.key(), cell);
+            }
+        }
+        if (out.size() == cellsStart) {
+            out.truncate(rowStart); // 没有内容的行不写出
+            continue;
+        }
+        out += "</row>";
+
+        if (out.size() >= FlushSize) {
+            if (!zip.write(out)) {
+                return false;
+            }
+            out.clear();
+        }
+    }
+    out += "</sheetData></worksheet>";
+    return zip.write(out) && zip.endEntry();
+}
+
+} // namespace
+
+// 保存为.xlsx
+bool XlsxFormat::save(const Workbook *workbook, const QString &fileName, const FileManager::ProgressCallback &progress)
+{
+    if (!workbook) return false;
+
+    QSaveFile file(fileName); // 写入临时文件，提交时替换原文件
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "Failed to open file for writing:" << fileName;
+        return false;
+    }
+
+    const int count = workbook->worksheetCount();
+    ZipWriter zip(&file);
+    bool ok = zip.addEntry(QStringLiteral("[Content_Types].xml"), contentTypes(count))
+              && zip.addEntry(QStringLiteral("_rels/.rels"), packageRelationships())
+              && zip.addEntry(QStringLiteral("xl/workbook.xml"), workbookXml(sheetNames(workbook), workbook->currentIndex()))
+              && zip.addEntry(QStringLiteral("xl/_rels/workbook.xml.rels"), workbookRelationships(count))
+              && zip.addEntry(QStringLiteral("xl/styles.xml"), QByteArray(StylesXml));
+
+    for (int i = 0; i < count && ok; ++i) {
+        auto worksheet = workbook->worksheet(i);
+        ok = worksheet && writeWorksheet(zip, worksheet.get(), i + 1);
+        if (ok && progress && !progress(i + 1, count)) {
+            return false;
+        }
+    }
+
+    if (!ok || !zip.finish() || !file.commit()) {
+        qDebug() << "Failed to write file:" << fileName;
+        return false;
+    }
+    return true;
+}
+
+// 读取.xlsx
+bool XlsxFormat::load(Workbook *workbook, const QString &fileName)
+{
+    if (!workbook) return false;
+
+    auto source = std::make_shared<XlsxSource>();
+    if (!source->zip.open(fileName)) {
+        return false;
+    }
+
+    // 包关系指向工作簿部件，工作簿的关系指向各工作表、共享字符串表与样式
+    QString workbookPart = QStringLiteral("xl/workbook.xml");
+    for (const Relationship &relationship : readRelationships(source->zip, QString())) {
+        if (relationship.type.endsWith(QLatin1String("/officeDocument"))) {
+            workbookPart = relationship.target;
+        }
+    }
+    const QHash<QString, Relationship> relationships = readRelationships(source->zip, workbookPart);
+
+    QList<SheetInfo> sheets;
+    int activeTab = 0;
+    if (!readWorkbookPart(*source, workbookPart, relationships, &sheets, &activeTab)) {
+        qDebug() << "Invalid XLSX file:" << fileName;
+        return false;
+    }
+    for (const Relationship &relationship : relationships) {
+        if (relationship.type.endsWith(QLatin1String("/sharedStrings"))
+            && !readSharedStrings(*source, relationship.target)) {
+            qDebug() << "Invalid shared strings in XLSX file:" << fileName;
+            return false;
+        }
+        if (relationship.type.endsWith(QLatin1String("/styles"))) {
+            readStyles(*source, relationship.target); // 样式只用于识别日期，读取失败时按普通数值处理
+        }
+    }
+
+    // 重建工作表目录：工作表部件在首次使用时才解析；图表工作表等没有单元格数据的工作表被跳过
+    workbook->clear();
+    int currentSheet = 0;
+    for (int i = 0; i < sheets.size(); ++i) {
+        const SheetInfo &sheet = sheets.at(i);
+        if (sheet.part.isEmpty()) {
+            continue;
+        }
+        if (i <= activeTab) {
+            currentSheet = workbook->worksheetCount();
+        }
+        workbook->addWorksheet(sheet.name);
+        auto worksheet = workbook->worksheet(workbook->worksheetCount() - 1);
+        const QString part = sheet.part;
+        worksheet->setLoader([source, part](Worksheet *target) {
+            return loadSheet(*source, part, target);
+        });
+    }
+
+    // 没有工作表，则创建一个默认工作表
+    if (workbook->worksheetCount() == 0) {
+        workbook->addWorksheet("Sheet1");
+    }
+    workbook->setCurrentWorksheet(currentSheet);
+
+    // 立即载入当前工作表，其余工作表延迟到切换时载入
+    auto current = workbook->currentWorksheet();
+    if (current && !current->ensureLoaded()) {
+        qDebug() << "Corrupted worksheet in XLSX file:" << fileName;
+        return false;
+    }
+
+    return true;
+}
+
+bool XlsxFormat::isXlsxFile(const QString &fileName)
+{
+    return ZipReader::isZipFile(fileName);
+}
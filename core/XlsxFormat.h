@@ -0,0 +1,28 @@
+#pragma once
+
+#include <QString>
+
+#include "Workbook.h"
+#include "FileManager.h"
+
+// Office Open XML工作簿（.xlsx）的读写，ZIP容器与deflate由ZipArchive与Deflate实现
+//
+// 读取：根据关系文件找到工作簿、工作表、共享字符串表与样式部件；共享字符串表与样式（只用于识别日期格式）
+//       在打开时读入，工作表在首次使用时解析。工作表部件边解压边由QXmlStreamReader流式解析，
+//       不建立DOM，内存中除单元格本身外只有一段解压数据与当前单元格
+// 保存：工作表逐行生成XML并边写边压缩；字符串写为内联字符串，不需要先收集共享字符串表；
+//       公式去掉前导'='写入<f>并附带当前值，日期与日期时间写为序列号并使用对应的日期样式。
+//       只读标记不保存，超出Excel行列上限的单元格被忽略
+class XlsxFormat
+{
+public:
+    static constexpr int MaxRows = 1048576;
+    static constexpr int MaxColumns = 16384;
+
+    // 进度以工作表为单位；失败或中止时原文件不变
+    static bool save(const Workbook *workbook, const QString &fileName,
+                     const FileManager::ProgressCallback &progress = FileManager::ProgressCallback());
+    static bool load(Workbook *workbook, const QString &fileName);
+
+    static bool isXlsxFile(const QString &fileName); // 根据ZIP文件头识别格式
+};
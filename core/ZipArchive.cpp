@@ -0,0 +1,439 @@
+#include "ZipArchive.h"
+
+#include <QDateTime>
+#include <QIODevice>
+#include <QtEndian>
+#include <QDebug>
+#include <cstring>
+
+namespace {
+
+const quint32 LocalHeaderSignature = 0x04034b50;
+const quint32 CentralHeaderSignature = 0x02014b50;
+const quint32 EndOfDirectorySignature = 0x06054b50;
+const quint32 Zip64EndOfDirectorySignature = 0x06064b50;
+const quint32 Zip64LocatorSignature = 0x07064b50;
+
+const qint64 LocalHeaderSize = 30;
+const qint64 CentralHeaderSize = 46;
+const qint64 EndOfDirectorySize = 22;
+const qint64 Zip64LocatorSize = 20;
+const qint64 MaxCommentSize = 0xFFFF;
+const quint32 Overflow32 = 0xFFFFFFFFu; // 实际值在ZIP64扩展字段中
+
+const quint16 MethodStored = 0;
+const quint16 MethodDeflated = 8;
+const quint16 FlagEncrypted = 0x0001;
+const quint16 FlagUtf8 = 0x0800;
+const quint16 VersionNeeded = 20; // 2.0：deflate
+
+template <typename T>
+T readLE(const char *data)
+{
+    return qFromLittleEndian<T>(data);
+}
+
+template <typename T>
+void appendLE(QByteArray &out, T value)
+{
+    value = qToLittleEndian(value);
+    out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+// MS-DOS格式的修改时间与日期
+void dosDateTime(const QDateTime &dateTime, quint16 *time, quint16 *date)
+{
+    const QDate d = dateTime.date();
+    const QTime t = dateTime.time();
+    *time = quint16(t.hour() << 11 | t.minute() << 5 | t.second() / 2);
+    *date = quint16(qMax(0, d.year() - 1980) << 9 | d.month() << 5 | d.day());
+}
+
+QString normalizedName(const QString &name)
+{
+    QString key = name.toLower();
+    while (key.startsWith(QLatin1Char('/'))) {
+        key.remove(0, 1);
+    }
+    return key;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------- 读取
+
+ZipReader::Stream::Stream(const Entry &entry, const char *data, qint64 compressedSize, bool valid)
+    : m_data(data)
+    , m_compressedSize(compressedSize)
+    , m_position(0)
+    , m_expectedCrc(entry.crc)
+    , m_expectedSize(entry.size)
+    , m_crc(0)
+    , m_size(0)
+    , m_finished(false)
+    , m_error(!valid)
+{
+    if (valid && entry.method == MethodDeflated) {
+        m_inflater = std::make_unique<Deflate::Inflater>(data, qsizetype(compressedSize));
+    }
+}
+
+QByteArray ZipReader::Stream::read()
+{
+    if (m_finished || m_error) {
+        return QByteArray();
+    }
+
+    QByteArray chunk;
+    if (m_inflater) {
+        chunk = m_inflater->read();
+        m_error = m_inflater->hasError();
+        m_finished = m_inflater->atEnd() && chunk.isEmpty();
+    }
+    else {
+        const qint64 length = qMin(StoredChunkSize, m_compressedSize - m_position);
+        chunk = QByteArray(m_data + m_position, qsizetype(length));
+        m_position += length;
+        m_finished = length == 0;
+    }
+
+    m_crc = Deflate::crc32(chunk.constData(), chunk.size(), m_crc);
+    m_size += chunk.size();
+    if (m_size > m_expectedSize || (m_finished && (m_size != m_expectedSize || m_crc != m_expectedCrc))) {
+        m_error = true;
+    }
+    if (!m_finished && !m_error && chunk.isEmpty()) {
+        m_error = true; // 压缩数据提前结束
+    }
+    return m_error ? QByteArray() : chunk;
+}
+
+qint64 ZipReader::Stream::consumed() const
+{
+    return m_inflater ? m_inflater->consumed() : m_position;
+}
+
+ZipReader::ZipReader()
+    : m_data(nullptr)
+    , m_size(0)
+{}
+
+ZipReader::~ZipReader()
+{
+    if (m_data) {
+        m_file.unmap(reinterpret_cast<uchar *>(const_cast<char *>(m_data)));
+    }
+}
+
+bool ZipReader::open(const QString &fileName)
+{
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        qDebug() << "Failed to open file for reading:" << fileName;
+        return false;
+    }
+    m_size = m_file.size();
+    m_data = reinterpret_cast<const char *>(m_file.map(0, m_size));
+    if (!m_data || !readCentralDirectory()) {
+        qDebug() << "Invalid ZIP file:" << fileName;
+        return false;
+    }
+    return true;
+}
+
+bool ZipReader::isZipFile(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QByteArray signature = file.read(4);
+    return signature.size() == 4 && readLE<quint32>(signature.constData()) == LocalHeaderSignature;
+}
+
+bool ZipReader::readCentralDirectory()
+{
+    // 从文件尾向前查找目录结束记录（其后最多跟64KB注释）
+    qint64 end = -1;
+    for (qint64 pos = m_size - EndOfDirectorySize; pos >= 0 && pos >= m_size - EndOfDirectorySize - MaxCommentSize; --pos) {
+        if (readLE<quint32>(m_data + pos) == EndOfDirectorySignature) {
+            end = pos;
+            break;
+        }
+    }
+    if (end < 0) {
+        return false;
+    }
+
+    qint64 count = readLE<quint16>(m_data + end + 10);
+    qint64 directorySize = readLE<quint32>(m_data + end + 12);
+    qint64 directoryOffset = readLE<quint32>(m_data + end + 16);
+
+    // ZIP64：目录结束记录之前的定位记录指向ZIP64目录结束记录
+    if (end >= Zip64LocatorSize && readLE<quint32>(m_data + end - Zip64LocatorSize) == Zip64LocatorSignature) {
+        const quint64 record = readLE<quint64>(m_data + end - Zip64LocatorSize + 8);
+        if (record > quint64(m_size - 56) || readLE<quint32>(m_data + record) != Zip64EndOfDirectorySignature) {
+            return false;
+        }
+        count = qint64(readLE<quint64>(m_data + record + 32));
+        directorySize = qint64(readLE<quint64>(m_data + record + 40));
+        directoryOffset = qint64(readLE<quint64>(m_data + record + 48));
+    }
+    if (directoryOffset < 0 || directorySize < 0 || directoryOffset > m_size || directorySize > m_size - directoryOffset) {
+        return false;
+    }
+
+    const char *pos = m_data + directoryOffset;
+    const char *directoryEnd = pos + directorySize;
+    for (qint64 i = 0; i < count; ++i) {
+        if (directoryEnd - pos < CentralHeaderSize || readLE<quint32>(pos) != CentralHeaderSignature) {
+            return false;
+        }
+        const quint16 flags = readLE<quint16>(pos + 8);
+        const quint16 nameLength = readLE<quint16>(pos + 28);
+        const quint16 extraLength = readLE<quint16>(pos + 30);
+        const quint16 commentLength = readLE<quint16>(pos + 32);
+        if (directoryEnd - pos < CentralHeaderSize + nameLength + extraLength + commentLength) {
+            return false;
+        }
+
+        Entry entry;
+        const char *name = pos + CentralHeaderSize;
+        entry.name = (flags & FlagUtf8) ? QString::fromUtf8(name, nameLength) : QString::fromLatin1(name, nameLength);
+        entry.method = readLE<quint16>(pos + 10);
+        entry.crc = readLE<quint32>(pos + 16);
+        const quint32 compressedSize = readLE<quint32>(pos + 20);
+        const quint32 size = readLE<quint32>(pos + 24);
+        const quint32 offset = readLE<quint32>(pos + 42);
+        entry.compressedSize = compressedSize;
+        entry.size = size;
+        entry.localHeaderOffset = offset;
+
+        // ZIP64扩展字段：依次为溢出的原始大小、压缩大小、本地文件头偏移
+        const char *extra = name + nameLength;
+        const char *extraEnd = extra + extraLength;
+        while (extraEnd - extra >= 4) {
+            const quint16 id = readLE<quint16>(extra);
+            const quint16 length = readLE<quint16>(extra + 2);
+            const char *field = extra + 4;
+            const char *fieldEnd = field + qMin<qint64>(length, extraEnd - field);
+            if (id == 0x0001) {
+                if (size == Overflow32 && fieldEnd - field >= 8) {
+                    entry.size = qint64(readLE<quint64>(field));
+                    field += 8;
+                }
+                if (compressedSize == Overflow32 && fieldEnd - field >= 8) {
+                    entry.compressedSize = qint64(readLE<quint64>(field));
+                    field += 8;
+                }
+                if (offset == Overflow32 && fieldEnd - field >= 8) {
+                    entry.localHeaderOffset = qint64(readLE<quint64>(field));
+                }
+            }
+            extra = fieldEnd;
+        }
+
+        if (!(flags & FlagEncrypted) && (entry.method == MethodStored || entry.method == MethodDeflated)) {
+            m_index.insert(normalizedName(entry.name), int(m_entries.size()));
+            m_entries.append(entry);
+        }
+        pos += CentralHeaderSize + nameLength + extraLength + commentLength;
+    }
+    return true;
+}
+
+const ZipReader::Entry *ZipReader::entry(const QString &name) const
+{
+    auto it = m_index.constFind(normalizedName(name));
+    return it == m_index.constEnd() ? nullptr : &m_entries.at(it.value());
+}
+
+ZipReader::Stream ZipReader::stream(const Entry &entry) const
+{
+    // 数据位于本地文件头之后，本地文件头的扩展字段长度可能与中央目录中不同
+    const qint64 header = entry.localHeaderOffset;
+    bool valid = header >= 0 && header <= m_size - LocalHeaderSize
+                 && readLE<quint32>(m_data + header) == LocalHeaderSignature;
+    qint64 dataOffset = 0;
+    if (valid) {
+        dataOffset = header + LocalHeaderSize + readLE<quint16>(m_data + header + 26) + readLE<quint16>(m_data + header + 28);
+        valid = entry.compressedSize >= 0 && dataOffset <= m_size && entry.compressedSize <= m_size - dataOffset;
+    }
+    return Stream(entry, valid ? m_data + dataOffset : nullptr, valid ? entry.compressedSize : 0, valid);
+}
+
+QByteArray ZipReader::read(const QString &name) const
+{
+    const Entry *found = entry(name);
+    if (!found) {
+        return QByteArray();
+    }
+
+    Stream input = stream(*found);
+    QByteArray data;
+    data.reserve(qsizetype(qMin<qint64>(found->size, 64 * 1024 * 1024)));
+    while (!input.atEnd() && !input.hasError()) {
+        data.append(input.read());
+    }
+    return input.hasError() ? QByteArray() : data;
+}
+
+// ---------------------------------------------------------------- 写入
+
+struct ZipWriter::Private {
+    struct WrittenEntry {
+        QByteArray name;
+        quint32 crc;
+        quint32 compressedSize;
+        quint32 size;
+        quint32 offset;
+    };
+
+    QIODevice *device;
+    quint16 time;
+    quint16 date;
+    QList<WrittenEntry> entries;
+    bool ok = true;
+
+    // 当前条目
+    std::unique_ptr<Deflate::Deflater> deflater;
+    qint64 headerOffset = 0;
+    quint32 crc = 0;
+    qint64 size = 0;
+
+    bool fits32(qint64 value)
+    {
+        if (value >= qint64(Overflow32)) {
+            qDebug() << "ZIP entry or archive exceeds 4GB";
+            ok = false;
+        }
+        return ok;
+    }
+};
+
+ZipWriter::ZipWriter(QIODevice *device)
+    : d(std::make_unique<Private>())
+{
+    d->device = device;
+    dosDateTime(QDateTime::currentDateTime(), &d->time, &d->date);
+}
+
+ZipWriter::~ZipWriter() = default;
+
+bool ZipWriter::beginEntry(const QString &name)
+{
+    if (!d->ok || d->deflater || !d->fits32(d->device->pos())) {
+        return false;
+    }
+
+    d->headerOffset = d->device->pos();
+    d->crc = 0;
+    d->size = 0;
+    const QByteArray utf8 = name.toUtf8();
+
+    // CRC与大小先写0，条目结束时回填
+    QByteArray header;
+    appendLE<quint32>(header, LocalHeaderSignature);
+    appendLE<quint16>(header, VersionNeeded);
+    appendLE<quint16>(header, FlagUtf8);
+    appendLE<quint16>(header, MethodDeflated);
+    appendLE<quint16>(header, d->time);
+    appendLE<quint16>(header, d->date);
+    appendLE<quint32>(header, 0);
+    appendLE<quint32>(header, 0);
+    appendLE<quint32>(header, 0);
+    appendLE<quint16>(header, quint16(utf8.size()));
+    appendLE<quint16>(header, 0);
+    header.append(utf8);
+    d->ok = d->device->write(header) == header.size();
+
+    d->entries.append({utf8, 0, 0, 0, quint32(d->headerOffset)});
+    d->deflater = std::make_unique<Deflate::Deflater>(d->device);
+    return d->ok;
+}
+
+bool ZipWriter::write(const QByteArray &data)
+{
+    if (!d->ok || !d->deflater) {
+        return false;
+    }
+    d->crc = Deflate::crc32(data.constData(), data.size(), d->crc);
+    d->size += data.size();
+    d->ok = d->fits32(d->size) && d->deflater->write(data);
+    return d->ok;
+}
+
+bool ZipWriter::endEntry()
+{
+    if (!d->ok || !d->deflater || !d->deflater->finish()) {
+        d->ok = false;
+        return false;
+    }
+    const qint64 compressedSize = d->deflater->compressedSize();
+    d->deflater.reset();
+    if (!d->fits32(compressedSize) || !d->fits32(d->device->pos())) {
+        return false;
+    }
+
+    Private::WrittenEntry &entry = d->entries.last();
+    entry.crc = d->crc;
+    entry.compressedSize = quint32(compressedSize);
+    entry.size = quint32(d->size);
+
+    // 回填本地文件头
+    QByteArray sizes;
+    appendLE<quint32>(sizes, entry.crc);
+    appendLE<quint32>(sizes, entry.compressedSize);
+    appendLE<quint32>(sizes, entry.size);
+    const qint64 end = d->device->pos();
+    d->ok = d->device->seek(d->headerOffset + 14) && d->device->write(sizes) == sizes.size() && d->device->seek(end);
+    return d->ok;
+}
+
+bool ZipWriter::addEntry(const QString &name, const QByteArray &data)
+{
+    return beginEntry(name) && write(data) && endEntry();
+}
+
+bool ZipWriter::finish()
+{
+    if (!d->ok || d->deflater) {
+        return false;
+    }
+
+    const qint64 directoryOffset = d->device->pos();
+    QByteArray directory;
+    for (const Private::WrittenEntry &entry : d->entries) {
+        appendLE<quint32>(directory, CentralHeaderSignature);
+        appendLE<quint16>(directory, VersionNeeded);
+        appendLE<quint16>(directory, VersionNeeded);
+        appendLE<quint16>(directory, FlagUtf8);
+        appendLE<quint16>(directory, MethodDeflated);
+        appendLE<quint16>(directory, d->time);
+        appendLE<quint16>(directory, d->date);
+        appendLE<quint32>(directory, entry.crc);
+        appendLE<quint32>(directory, entry.compressedSize);
+        appendLE<quint32>(directory, entry.size);
+        appendLE<quint16>(directory, quint16(entry.name.size()));
+        appendLE<quint16>(directory, 0); // 扩展字段
+        appendLE<quint16>(directory, 0); // 注释
+        appendLE<quint16>(directory, 0); // 磁盘号
+        appendLE<quint16>(directory, 0); // 内部属性
+        appendLE<quint32>(directory, 0); // 外部属性
+        appendLE<quint32>(directory, entry.offset);
+        directory.append(entry.name);
+    }
+
+    const qint64 directorySize = directory.size();
+    appendLE<quint32>(directory, EndOfDirectorySignature);
+    appendLE<quint16>(directory, 0);
+    appendLE<quint16>(directory, 0);
+    appendLE<quint16>(directory, quint16(d->entries.size()));
+    appendLE<quint16>(directory, quint16(d->entries.size()));
+    appendLE<quint32>(directory, quint32(directorySize));
+    appendLE<quint32>(directory, quint32(directoryOffset));
+    appendLE<quint16>(directory, 0);
+
+    d->ok = d->fits32(directoryOffset + directory.size()) && d->device->write(directory) == directory.size();
+    return d->ok;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QByteArray>
+#include <memory>
+
+#include "Deflate.h"
+
+class QIODevice;
+
+// ZIP容器的读取：映射整个文件并解析中央目录（支持ZIP64），条目可整体读出，也可分段流式解压。
+// 只支持不压缩（stored）与deflate两种方法，不支持加密。打开后只读，可在多个线程中同时读取不同的流
+class ZipReader
+{
+public:
+    struct Entry {
+        QString name;
+        quint16 method = 0;
+        quint32 crc = 0;
+        qint64 compressedSize = 0;
+        qint64 size = 0;
+        qint64 localHeaderOffset = 0;
+    };
+
+    // 一个条目的解压流：每次取出一段数据，读完时校验CRC与长度。ZipReader须在读取期间保持有效
+    class Stream
+    {
+    public:
+        QByteArray read(); // 下一段数据，结束或出错时返回空
+        bool atEnd() const { return m_finished; }
+        bool hasError() const { return m_error; }
+        qint64 consumed() const; // 已读取的压缩数据字节数
+        qint64 compressedSize() const { return m_compressedSize; }
+
+    private:
+        friend class ZipReader;
+        Stream(const Entry &entry, const char *data, qint64 compressedSize, bool valid);
+
+        const char *m_data;
+        qint64 m_compressedSize;
+        qint64 m_position; // 不压缩的条目已读取的位置
+        std::unique_ptr<Deflate::Inflater> m_inflater;
+        quint32 m_expectedCrc;
+        qint64 m_expectedSize;
+        quint32 m_crc;
+        qint64 m_size;
+        bool m_finished;
+        bool m_error;
+    };
+
+    static constexpr qint64 StoredChunkSize = 256 * 1024; // 不压缩条目每次取出的字节数
+
+    ZipReader();
+    ~ZipReader();
+
+    bool open(const QString &fileName);
+    static bool isZipFile(const QString &fileName); // 根据本地文件头签名识别
+
+    const QList<Entry> &entries() const { return m_entries; }
+    const Entry *entry(const QString &name) const; // 名称不区分大小写，可带前导'/'，不存在时返回nullptr
+
+    Stream stream(const Entry &entry) const;
+    QByteArray read(const QString &name) const; // 整个条目（用于较小的条目），不存在或出错时返回空
+
+private:
+    bool readCentralDirectory();
+
+    QFile m_file;
+    const char *m_data;
+    qint64 m_size;
+    QList<Entry> m_entries;
+    QHash<QString, int> m_index; // 小写名称 -> 条目
+};
+
+// ZIP容器的写入：条目依次写出，每个条目边写边用deflate压缩，写完后回填本地文件头中的CRC与大小，
+// 因此device必须可随机写（如QSaveFile）。不写ZIP64记录，单个条目与整个文件不能超过4GB
+class ZipWriter
+{
+public:
+    explicit ZipWriter(QIODevice *device);
+    ~ZipWriter();
+
+    bool beginEntry(const QString &name);
+    bool write(const QByteArray &data);
+    bool endEntry();
+
+    bool addEntry(const QString &name, const QByteArray &data); // 一次写出整个条目
+
+    bool finish(); // 写出中央目录
+
+private:
+    struct Private;
+    std::unique_ptr<Private> d;
+};
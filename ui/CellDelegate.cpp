@@ -0,0 +1,58 @@
+#include "CellDelegate.h"
+
+#include <QPainter>
+#include <QFontMetrics>
+
+CellDelegate::CellDelegate(QObject *parent)
+    : QStyledItemDelegate(parent)
+    , m_layouts(CacheSize)
+{}
+
+// 取得排好的文本：单行显示，超出宽度时截断并加省略号，因此绘制时不需要裁剪
+const QStaticText *CellDelegate::layout(const QString &text, const QFont &font, int width) const
+{
+    LayoutKey key{text, font, width};
+    if (const QStaticText *cached = m_layouts.object(key)) {
+        return cached;
+    }
+
+    QString line = text;
+    line.replace(QLatin1Char('\n'), QLatin1Char(' '));
+    const QString elided = QFontMetrics(font).elidedText(line, Qt::ElideRight, width);
+
+    auto staticText = new QStaticText(elided);
+    staticText->setTextFormat(Qt::PlainText);
+    staticText->setPerformanceHint(QStaticText::AggressiveCaching); // 同时缓存绘制数据
+    staticText->prepare(QTransform(), font);
+
+    m_layouts.insert(std::move(key), staticText); // 超出容量时淘汰最久未使用的排版结果
+    return staticText;
+}
+
+void CellDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    const bool selected = option.state & QStyle::State_Selected;
+    const QPalette::ColorGroup group = (option.state & QStyle::State_Enabled)
+            ? ((option.state & QStyle::State_Active) ? QPalette::Active : QPalette::Inactive)
+            : QPalette::Disabled;
+
+    if (selected) {
+        painter->fillRect(option.rect, option.palette.brush(group, QPalette::Highlight));
+    }
+
+    const QString text = index.data(Qt::DisplayRole).toString();
+    const int width = option.rect.width() - 2 * Padding;
+    if (!text.isEmpty() && width > 0) {
+        const QStaticText *staticText = layout(text, option.font, width);
+        const qreal y = option.rect.top() + (option.rect.height() - staticText->size().height()) / 2;
+        painter->setPen(option.palette.color(group, selected ? QPalette::HighlightedText : QPalette::Text));
+        painter->setFont(option.font);
+        painter->drawStaticText(QPointF(option.rect.left() + Padding, y), *staticText);
+    }
+
+    // 当前单元格的边框
+    if (option.state & QStyle::State_HasFocus) {
+        painter->setPen(option.palette.color(group, QPalette::Highlight));
+        painter->drawRect(option.rect.adjusted(0, 0, -1, -1));
+    }
+}
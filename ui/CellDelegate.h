@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QStyledItemDelegate>
+#include <QStaticText>
+#include <QCache>
+#include <QFont>
+
+// 单元格绘制：文本的排版结果（截断后的QStaticText）按(文本, 字体, 宽度)缓存在LRU缓存中，
+// 滚动时只绘制已排好的字形，不重复排版；网格线不由各单元格绘制，而由SpreadsheetView一次画出。
+// 编辑仍使用QStyledItemDelegate的默认编辑器
+class CellDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+
+public:
+    static constexpr int CacheSize = 16384; // 缓存的排版结果数，约为4K屏幕满屏单元格数的数倍
+    static constexpr int Padding = 3; // 文本与单元格左右边缘的距离
+
+    explicit CellDelegate(QObject *parent = nullptr);
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+
+private:
+    struct LayoutKey {
+        QString text;
+        QFont font;
+        int width;
+
+        bool operator==(const LayoutKey &other) const
+        {
+            return width == other.width && text == other.text && font == other.font;
+        }
+    };
+    friend size_t qHash(const LayoutKey &key, size_t seed = 0)
+    {
+        return qHashMulti(seed, key.text, key.font, key.width);
+    }
+
+    const QStaticText *layout(const QString &text, const QFont &font, int width) const;
+
+    mutable QCache<LayoutKey, QStaticText> m_layouts;
+};
@@ -0,0 +1,37 @@
+#include "CellMimeData.h"
+
+#include <QString>
+
+CellMimeData::CellMimeData(const CellBlock &block)
+    : m_block(block)
+{}
+
+QStringList CellMimeData::formats() const
+{
+    return {"text/plain", "text/html"};
+}
+
+bool CellMimeData::hasFormat(const QString &mimeType) const
+{
+    return formats().contains(mimeType);
+}
+
+// 每次请求时生成（通常只请求一次），不缓存大块文本
+QVariant CellMimeData::retrieveData(const QString &mimeType, QMetaType type) const
+{
+    if (mimeType == "text/plain") {
+        const QByteArray text = m_block.toTsv();
+        if (type.id() == QMetaType::QByteArray) {
+            return text;
+        }
+        return QString::fromUtf8(text);
+    }
+    if (mimeType == "text/html") {
+        const QByteArray html = m_block.toHtml();
+        if (type.id() == QMetaType::QByteArray) {
+            return html;
+        }
+        return QString::fromUtf8(html);
+    }
+    return QMimeData::retrieveData(mimeType, type);
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <QMimeData>
+
+#include "../core/CellBlock.h"
+
+// 复制到剪贴板的单元格区域：保存CellBlock快照，不预先生成文本。
+// 本程序粘贴时直接取回快照（见block()）；其他程序请求时才生成制表符分隔文本或HTML表格
+class CellMimeData : public QMimeData
+{
+    Q_OBJECT
+
+public:
+    explicit CellMimeData(const CellBlock &block);
+
+    const CellBlock &block() const { return m_block; }
+
+    QStringList formats() const override;
+    bool hasFormat(const QString &mimeType) const override;
+
+protected:
+    QVariant retrieveData(const QString &mimeType, QMetaType type) const override;
+
+private:
+    CellBlock m_block;
+};
@@ -0,0 +1,108 @@
+#include "ColumnAutoFit.h"
+#include "../core/Worksheet.h"
+#include "../core/Cell.h"
+
+#include <algorithm>
+
+namespace {
+
+// 与CellDelegate一致：多行文本显示为一行
+QString displayLine(const Cell &cell)
+{
+    QString text = cell.displayText();
+    text.replace(QLatin1Char('\n'), QLatin1Char(' '));
+    return text;
+}
+
+void appendRow(const Worksheet::Row &row, int firstColumn, int lastColumn,
+               QVector<ColumnAutoFit::Column> &columns, QStringList ColumnAutoFit::Column::*list)
+{
+    for (auto it = row.lowerBound(firstColumn); it != row.end() && it.key() <= lastColumn; ++it) {
+        if (it.value()) {
+            QString text = displayLine(*it.value());
+            if (!text.isEmpty()) {
+                (columns[it.key() - firstColumn].*list).append(std::move(text));
+            }
+        }
+    }
+}
+
+} // namespace
+
+QVector<ColumnAutoFit::Column> ColumnAutoFit::sample(const Worksheet *worksheet, int firstColumn, int lastColumn,
+                                                     const QVector<int> &visibleRows)
+{
+    QVector<Column> columns(qMax(0, lastColumn - firstColumn + 1));
+    if (!worksheet || columns.isEmpty()) {
+        return columns;
+    }
+
+    const QMap<int, Worksheet::Row> &rows = worksheet->rows();
+    for (int row : visibleRows) {
+        auto it = rows.constFind(row);
+        if (it != rows.constEnd()) {
+            appendRow(it.value(), firstColumn, lastColumn, columns, &Column::visible);
+        }
+    }
+
+    if (rows.isEmpty()) {
+        return columns;
+    }
+    if (rows.size() <= SampleRows) {
+        for (const Worksheet::Row &row : rows) {
+            appendRow(row, firstColumn, lastColumn, columns, &Column::sampled);
+        }
+        return columns;
+    }
+
+    // 在已分配的行号范围内均匀取点，每个点取其后第一个有数据的行
+    const qint64 first = rows.firstKey();
+    const qint64 span = qint64(rows.lastKey()) - first + 1;
+    int previous = -1;
+    for (int i = 0; i < SampleRows; ++i) {
+        auto it = rows.lowerBound(int(first + span * i / SampleRows));
+        if (it != rows.constEnd() && it.key() != previous) {
+            previous = it.key();
+            appendRow(it.value(), firstColumn, lastColumn, columns, &Column::sampled);
+        }
+    }
+    return columns;
+}
+
+QVector<int> ColumnAutoFit::measure(QVector<Column> columns, const QFont &cellFont, int cellMargin,
+                                    const QFont &headerFont, int headerMargin)
+{
+    WidthCache cellWidths(cellFont);
+    WidthCache headerWidths(headerFont);
+
+    QVector<int> widths;
+    widths.reserve(columns.size());
+    for (Column &column : columns) {
+        int textWidth = 0;
+        for (const QString &text : std::as_const(column.visible)) {
+            textWidth = qMax(textWidth, cellWidths.width(text));
+        }
+
+        // 只测量字符数最多的候选
+        QStringList &sampled = column.sampled;
+        const auto longer = [](const QString &a, const QString &b) { return a.size() > b.size(); };
+        const qsizetype candidates = qMin<qsizetype>(LongestCandidates, sampled.size());
+        std::partial_sort(sampled.begin(), sampled.begin() + candidates, sampled.end(), longer);
+        for (qsizetype i = 0; i < candidates; ++i) {
+            textWidth = qMax(textWidth, cellWidths.width(sampled.at(i)));
+        }
+
+        // 没有内容的列保持原宽度
+        widths.append(textWidth > 0 ? qMax(textWidth + cellMargin, headerWidths.width(column.header) + headerMargin) : 0);
+    }
+    return widths;
+}
+
+int ColumnAutoFit::WidthCache::width(const QString &text)
+{
+    auto it = m_widths.constFind(text);
+    if (it == m_widths.constEnd()) {
+        it = m_widths.insert(text, m_metrics.horizontalAdvance(text));
+    }
+    return it.value();
+}
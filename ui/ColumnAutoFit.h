@@ -0,0 +1,46 @@
+#pragma once
+
+#include <QFont>
+#include <QFontMetrics>
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+
+class Worksheet;
+
+// 列宽自动调整：不逐行测量，只测量抽样得到的文本——表头、可见行，以及均匀间隔抽取的行中字符数最多的若干个
+// （宽度基本随字符数增长，测量最长的几个即可找到最宽的文本）。
+// 抽样在GUI线程进行，只做SampleRows次行查找，与工作表的总行数无关；测量在工作线程中进行
+class ColumnAutoFit
+{
+public:
+    static constexpr int SampleRows = 2048; // 间隔抽取的行数
+    static constexpr int LongestCandidates = 16; // 每列测量抽样行中字符数最多的文本数
+
+    struct Column {
+        QString header; // 由调用方按模型的表头填写
+        QStringList visible; // 可见行中的文本，全部测量
+        QStringList sampled; // 抽样行中的文本，只测量最长的若干个
+    };
+
+    // 收集[firstColumn, lastColumn]各列的文本（GUI线程），visibleRows为视口中显示的行
+    static QVector<Column> sample(const Worksheet *worksheet, int firstColumn, int lastColumn,
+                                  const QVector<int> &visibleRows);
+    // 各列所需的宽度：单元格文本宽度加cellMargin与表头文本宽度加headerMargin中的较大者，
+    // 没有任何文本的列为0。可在任意线程调用
+    static QVector<int> measure(QVector<Column> columns, const QFont &cellFont, int cellMargin,
+                                const QFont &headerFont, int headerMargin);
+
+private:
+    // 文本宽度缓存：相同的文本（重复值、各列共有的表头字符等）只测量一次
+    class WidthCache
+    {
+    public:
+        explicit WidthCache(const QFont &font) : m_metrics(font) {}
+        int width(const QString &text);
+
+    private:
+        QFontMetrics m_metrics;
+        QHash<QString, int> m_widths;
+    };
+};
@@ -0,0 +1,32 @@
+#include "CsvViewer.h"
+#include "MappedCsvModel.h"
+
+#include <QFileInfo>
+#include <QHeaderView>
+#include <QVBoxLayout>
+
+CsvViewer::CsvViewer(std::shared_ptr<MappedCsv> csv, QWidget *parent)
+    : QWidget(parent, Qt::Window) // 有父窗口时仍作为独立窗口显示
+    , m_csv(std::move(csv))
+    , m_model(new MappedCsvModel(m_csv, this))
+{
+    setAttribute(Qt::WA_DeleteOnClose); // 关闭时释放文件映射
+    setWindowTitle(QString("只读查看 - %1").arg(QFileInfo(m_csv->fileName()).fileName()));
+    resize(1000, 700);
+
+    auto layout = new QVBoxLayout(this);
+
+    m_infoLabel = new QLabel(QString("%1 行 × %2 列（只读）").arg(m_csv->rowCount()).arg(m_csv->columnCount()));
+    layout->addWidget(m_infoLabel);
+
+    m_tableView = new QTableView;
+    m_tableView->setModel(m_model);
+    m_tableView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_tableView->setWordWrap(false);
+
+    // 固定行高列宽：表头不逐行计算尺寸，行数很大时滚动仍然流畅
+    m_tableView->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    m_tableView->verticalHeader()->setDefaultSectionSize(25);
+    m_tableView->horizontalHeader()->setDefaultSectionSize(80);
+    layout->addWidget(m_tableView);
+}
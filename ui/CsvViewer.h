@@ -0,0 +1,25 @@
+#pragma once
+
+#include <QWidget>
+#include <QTableView>
+#include <QLabel>
+#include <memory>
+
+#include "../core/MappedCsv.h"
+
+class MappedCsvModel;
+
+// 大型CSV文件的只读查看窗口：数据直接来自文件映射，不载入工作簿
+class CsvViewer : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit CsvViewer(std::shared_ptr<MappedCsv> csv, QWidget *parent = nullptr);
+
+private:
+    std::shared_ptr<MappedCsv> m_csv;
+    MappedCsvModel *m_model;
+    QTableView *m_tableView;
+    QLabel *m_infoLabel; // 文件信息：行列数
+};
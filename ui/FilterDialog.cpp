@@ -0,0 +1,141 @@
+#include "FilterDialog.h"
+
+#include <QDialogButtonBox>
+#include <QDoubleValidator>
+#include <QFormLayout>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QLocale>
+#include <QPushButton>
+#include <QVBoxLayout>
+#include <cmath>
+
+FilterDialog::FilterDialog(const QString &columnName, const QStringList &values, const AutoFilter::Criterion &current,
+                           QWidget *parent)
+    : QDialog(parent)
+    , m_typeBox(new QComboBox)
+    , m_pages(new QStackedWidget)
+    , m_valueList(new QListWidget)
+    , m_minimumEdit(new QLineEdit)
+    , m_maximumEdit(new QLineEdit)
+    , m_textEdit(new QLineEdit)
+{
+    setWindowTitle(QString("筛选 - 列 %1").arg(columnName));
+    setWindowFlags(windowFlags() & ~Qt::WindowContextHelpButtonHint);
+
+    // 条件类型，页面顺序与AutoFilter::Criterion::Type一致
+    m_typeBox->addItem("不筛选");
+    m_typeBox->addItem("按值");
+    m_typeBox->addItem("数值范围");
+    m_typeBox->addItem("文本包含");
+
+    m_pages->addWidget(new QLabel("显示该列的所有行"));
+
+    // 按值：勾选要显示的值，未设置条件时全部勾选
+    auto valuesPage = new QWidget;
+    auto valuesLayout = new QVBoxLayout(valuesPage);
+    valuesLayout->setContentsMargins(0, 0, 0, 0);
+    for (const QString &value : values) {
+        auto item = new QListWidgetItem(value.isEmpty() ? "(空白)" : value, m_valueList);
+        item->setData(Qt::UserRole, value);
+        const bool checked = current.type != AutoFilter::Criterion::Values || current.values.contains(value);
+        item->setCheckState(checked ? Qt::Checked : Qt::Unchecked);
+    }
+    auto checkLayout = new QHBoxLayout;
+    auto checkAllButton = new QPushButton("全选");
+    auto uncheckAllButton = new QPushButton("全不选");
+    connect(checkAllButton, &QPushButton::clicked, this, [this]() { setAllChecked(true); });
+    connect(uncheckAllButton, &QPushButton::clicked, this, [this]() { setAllChecked(false); });
+    checkLayout->addWidget(checkAllButton);
+    checkLayout->addWidget(uncheckAllButton);
+    checkLayout->addStretch();
+    valuesLayout->addWidget(m_valueList);
+    valuesLayout->addLayout(checkLayout);
+    if (values.size() >= AutoFilter::MaxListedValues) {
+        valuesLayout->addWidget(new QLabel(QString("只列出前%1个值").arg(AutoFilter::MaxListedValues)));
+    }
+    m_pages->addWidget(valuesPage);
+
+    // 数值范围：留空表示不限
+    auto rangePage = new QWidget;
+    auto rangeLayout = new QFormLayout(rangePage);
+    m_minimumEdit->setValidator(new QDoubleValidator(this));
+    m_maximumEdit->setValidator(new QDoubleValidator(this));
+    m_minimumEdit->setPlaceholderText("不限");
+    m_maximumEdit->setPlaceholderText("不限");
+    if (current.type == AutoFilter::Criterion::NumberRange) {
+        const QLocale locale; // 与QDoubleValidator接受的格式一致
+        if (std::isfinite(current.minimum)) {
+            m_minimumEdit->setText(locale.toString(current.minimum));
+        }
+        if (std::isfinite(current.maximum)) {
+            m_maximumEdit->setText(locale.toString(current.maximum));
+        }
+    }
+    rangeLayout->addRow("最小值:", m_minimumEdit);
+    rangeLayout->addRow("最大值:", m_maximumEdit);
+    m_pages->addWidget(rangePage);
+
+    auto textPage = new QWidget;
+    auto textLayout = new QFormLayout(textPage);
+    m_textEdit->setText(current.text);
+    m_textEdit->setPlaceholderText("不区分大小写");
+    textLayout->addRow("包含:", m_textEdit);
+    m_pages->addWidget(textPage);
+
+    connect(m_typeBox, &QComboBox::currentIndexChanged, m_pages, &QStackedWidget::setCurrentIndex);
+    m_typeBox->setCurrentIndex(current.type);
+    m_pages->setCurrentIndex(current.type);
+
+    auto buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+    connect(buttons, &QDialogButtonBox::accepted, this, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+
+    auto mainLayout = new QVBoxLayout(this);
+    mainLayout->addWidget(m_typeBox);
+    mainLayout->addWidget(m_pages);
+    mainLayout->addWidget(buttons);
+}
+
+AutoFilter::Criterion FilterDialog::criterion() const
+{
+    AutoFilter::Criterion criterion;
+    criterion.type = AutoFilter::Criterion::Type(m_typeBox->currentIndex());
+
+    switch (criterion.type) {
+    case AutoFilter::Criterion::Values:
+        for (int i = 0; i < m_valueList->count(); ++i) {
+            const QListWidgetItem *item = m_valueList->item(i);
+            if (item->checkState() == Qt::Checked) {
+                criterion.values.insert(item->data(Qt::UserRole).toString());
+            }
+        }
+        break;
+    case AutoFilter::Criterion::NumberRange: {
+        const QLocale locale;
+        bool ok = false;
+        const double minimum = locale.toDouble(m_minimumEdit->text(), &ok);
+        if (ok) {
+            criterion.minimum = minimum;
+        }
+        const double maximum = locale.toDouble(m_maximumEdit->text(), &ok);
+        if (ok) {
+            criterion.maximum = maximum;
+        }
+        break;
+    }
+    case AutoFilter::Criterion::TextContains:
+        criterion.text = m_textEdit->text();
+        break;
+    default:
+        break;
+    }
+    return criterion;
+}
+
+void FilterDialog::setAllChecked(bool checked)
+{
+    for (int i = 0; i < m_valueList->count(); ++i) {
+        m_valueList->item(i)->setCheckState(checked ? Qt::Checked : Qt::Unchecked);
+    }
+}
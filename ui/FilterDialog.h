@@ -0,0 +1,32 @@
+#pragma once
+
+#include "../core/AutoFilter.h"
+
+#include <QDialog>
+#include <QComboBox>
+#include <QLineEdit>
+#include <QListWidget>
+#include <QStackedWidget>
+
+// 一列的筛选条件：按值（勾选列出的不同值）、数值范围或文本包含
+class FilterDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    // values为该列的不同显示文本，current为该列当前的条件
+    FilterDialog(const QString &columnName, const QStringList &values, const AutoFilter::Criterion &current,
+                 QWidget *parent = nullptr);
+
+    AutoFilter::Criterion criterion() const;
+
+private:
+    void setAllChecked(bool checked);
+
+    QComboBox *m_typeBox;
+    QStackedWidget *m_pages;
+    QListWidget *m_valueList;
+    QLineEdit *m_minimumEdit;
+    QLineEdit *m_maximumEdit;
+    QLineEdit *m_textEdit;
+};
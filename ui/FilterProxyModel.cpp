@@ -0,0 +1,256 @@
+#include "FilterProxyModel.h"
+
+#include <algorithm>
+
+FilterProxyModel::FilterProxyModel(QObject *parent)
+    : QAbstractProxyModel(parent)
+    , m_filtered(false)
+    , m_headerRow(-1)
+    , m_lastRow(-1)
+    , m_removing(false)
+{}
+
+void FilterProxyModel::setSourceModel(QAbstractItemModel *sourceModel)
+{
+    beginResetModel();
+    if (QAbstractItemModel *previous = this->sourceModel()) {
+        disconnect(previous, nullptr, this, nullptr);
+    }
+    QAbstractProxyModel::setSourceModel(sourceModel);
+    m_filtered = false;
+    m_rows.clear();
+
+    if (sourceModel) {
+        connect(sourceModel, &QAbstractItemModel::dataChanged, this, &FilterProxyModel::onDataChanged);
+        connect(sourceModel, &QAbstractItemModel::rowsAboutToBeInserted, this, &FilterProxyModel::onRowsAboutToBeInserted);
+        connect(sourceModel, &QAbstractItemModel::rowsInserted, this, &FilterProxyModel::onRowsInserted);
+        connect(sourceModel, &QAbstractItemModel::rowsAboutToBeRemoved, this, &FilterProxyModel::onRowsAboutToBeRemoved);
+        connect(sourceModel, &QAbstractItemModel::rowsRemoved, this, &FilterProxyModel::onRowsRemoved);
+
+        // 列不参与筛选，直接转发
+        connect(sourceModel, &QAbstractItemModel::columnsAboutToBeInserted, this, [this](const QModelIndex &, int first, int last) {
+            beginInsertColumns(QModelIndex(), first, last);
+        });
+        connect(sourceModel, &QAbstractItemModel::columnsInserted, this, &FilterProxyModel::endInsertColumns);
+        connect(sourceModel, &QAbstractItemModel::columnsAboutToBeRemoved, this, [this](const QModelIndex &, int first, int last) {
+            beginRemoveColumns(QModelIndex(), first, last);
+        });
+        connect(sourceModel, &QAbstractItemModel::columnsRemoved, this, &FilterProxyModel::endRemoveColumns);
+        connect(sourceModel, &QAbstractItemModel::headerDataChanged, this, &FilterProxyModel::headerDataChanged);
+
+        connect(sourceModel, &QAbstractItemModel::modelAboutToBeReset, this, &FilterProxyModel::beginResetModel);
+        connect(sourceModel, &QAbstractItemModel::modelReset, this, &FilterProxyModel::onModelReset);
+    }
+    endResetModel();
+}
+
+void FilterProxyModel::setFilter(int headerRow, int lastRow, std::vector<int> visibleRows)
+{
+    updateMapping(true, headerRow, lastRow, std::move(visibleRows));
+}
+
+void FilterProxyModel::clearFilter()
+{
+    if (m_filtered) {
+        updateMapping(false, -1, -1, std::vector<int>());
+    }
+}
+
+void FilterProxyModel::updateMapping(bool filtered, int headerRow, int lastRow, std::vector<int> rows)
+{
+    emit layoutAboutToBeChanged(QList<QPersistentModelIndex>(), QAbstractItemModel::VerticalSortHint);
+
+    // 持久索引（选区、当前单元格）按源行号换算到新的映射，被筛去的失效
+    const QModelIndexList persistent = persistentIndexList();
+    QList<int> sourceRows;
+    sourceRows.reserve(persistent.size());
+    for (const QModelIndex &index : persistent) {
+        sourceRows.append(mapRowToSource(index.row()));
+    }
+
+    m_filtered = filtered;
+    m_headerRow = headerRow;
+    m_lastRow = lastRow;
+    m_rows = std::move(rows);
+
+    QModelIndexList updated;
+    updated.reserve(persistent.size());
+    for (int i = 0; i < persistent.size(); ++i) {
+        const int row = mapRowFromSource(sourceRows.at(i));
+        updated.append(row >= 0 ? createIndex(row, persistent.at(i).column()) : QModelIndex());
+    }
+    changePersistentIndexList(persistent, updated);
+
+    emit layoutChanged(QList<QPersistentModelIndex>(), QAbstractItemModel::VerticalSortHint);
+}
+
+int FilterProxyModel::mapRowToSource(int row) const
+{
+    if (!m_filtered || row <= m_headerRow) {
+        return row;
+    }
+    const int index = row - m_headerRow - 1;
+    if (index < int(m_rows.size())) {
+        return m_rows[index];
+    }
+    return m_lastRow + 1 + (index - int(m_rows.size()));
+}
+
+int FilterProxyModel::mapRowFromSource(int sourceRow) const
+{
+    if (!m_filtered || sourceRow <= m_headerRow) {
+        return sourceRow;
+    }
+    if (sourceRow > m_lastRow) {
+        return m_headerRow + 1 + int(m_rows.size()) + (sourceRow - m_lastRow - 1);
+    }
+    auto it = std::lower_bound(m_rows.cbegin(), m_rows.cend(), sourceRow);
+    return (it != m_rows.cend() && *it == sourceRow) ? m_headerRow + 1 + int(it - m_rows.cbegin()) : -1;
+}
+
+int FilterProxyModel::lowerBound(int sourceRow) const
+{
+    if (!m_filtered || sourceRow <= m_headerRow || sourceRow > m_lastRow) {
+        return mapRowFromSource(sourceRow);
+    }
+    return m_headerRow + 1 + int(std::lower_bound(m_rows.cbegin(), m_rows.cend(), sourceRow) - m_rows.cbegin());
+}
+
+QModelIndex FilterProxyModel::mapToSource(const QModelIndex &proxyIndex) const
+{
+    if (!proxyIndex.isValid() || !sourceModel()) {
+        return QModelIndex();
+    }
+    return sourceModel()->index(mapRowToSource(proxyIndex.row()), proxyIndex.column());
+}
+
+QModelIndex FilterProxyModel::mapFromSource(const QModelIndex &sourceIndex) const
+{
+    if (!sourceIndex.isValid()) {
+        return QModelIndex();
+    }
+    const int row = mapRowFromSource(sourceIndex.row());
+    return row >= 0 ? index(row, sourceIndex.column()) : QModelIndex();
+}
+
+QModelIndex FilterProxyModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if (parent.isValid() || row < 0 || column < 0 || row >= rowCount() || column >= columnCount()) {
+        return QModelIndex();
+    }
+    return createIndex(row, column);
+}
+
+QModelIndex FilterProxyModel::parent(const QModelIndex &child) const
+{
+    Q_UNUSED(child)
+    return QModelIndex(); // 表格模型没有层次
+}
+
+int FilterProxyModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid() || !sourceModel()) {
+        return 0;
+    }
+    const int sourceRows = sourceModel()->rowCount();
+    if (!m_filtered) {
+        return sourceRows;
+    }
+    return sourceRows - (m_lastRow - m_headerRow - int(m_rows.size())); // 减去被筛去的行
+}
+
+int FilterProxyModel::columnCount(const QModelIndex &parent) const
+{
+    if (parent.isValid() || !sourceModel()) {
+        return 0;
+    }
+    return sourceModel()->columnCount();
+}
+
+QVariant FilterProxyModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (!sourceModel()) {
+        return QVariant();
+    }
+    return sourceModel()->headerData(orientation == Qt::Vertical ? mapRowToSource(section) : section, orientation, role);
+}
+
+void FilterProxyModel::onDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QList<int> &roles)
+{
+    const int first = lowerBound(topLeft.row());
+    const int last = lowerBound(bottomRight.row() + 1) - 1;
+    if (first <= last) {
+        emit dataChanged(index(first, topLeft.column()), index(last, bottomRight.column()), roles);
+    }
+}
+
+// 插入的行都显示：在标题行及以上插入时整体后移，在数据行中插入时加入通过筛选的行
+void FilterProxyModel::onRowsAboutToBeInserted(const QModelIndex &parent, int first, int last)
+{
+    Q_UNUSED(parent)
+    const int row = lowerBound(first);
+    beginInsertRows(QModelIndex(), row, row + (last - first));
+}
+
+void FilterProxyModel::onRowsInserted(const QModelIndex &parent, int first, int last)
+{
+    Q_UNUSED(parent)
+    const int count = last - first + 1;
+    if (m_filtered && first <= m_lastRow) {
+        auto it = std::lower_bound(m_rows.begin(), m_rows.end(), first);
+        for (auto shifted = it; shifted != m_rows.end(); ++shifted) {
+            *shifted += count;
+        }
+        if (first <= m_headerRow) {
+            m_headerRow += count;
+        }
+        else {
+            std::vector<int> inserted(count);
+            for (int i = 0; i < count; ++i) {
+                inserted[i] = first + i;
+            }
+            m_rows.insert(it, inserted.cbegin(), inserted.cend());
+        }
+        m_lastRow += count;
+    }
+    endInsertRows();
+}
+
+void FilterProxyModel::onRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last)
+{
+    Q_UNUSED(parent)
+    const int proxyFirst = lowerBound(first);
+    const int proxyLast = lowerBound(last + 1) - 1;
+    m_removing = proxyFirst <= proxyLast; // 删除的都是被筛去的行时显示的行不变
+    if (m_removing) {
+        beginRemoveRows(QModelIndex(), proxyFirst, proxyLast);
+    }
+}
+
+void FilterProxyModel::onRowsRemoved(const QModelIndex &parent, int first, int last)
+{
+    Q_UNUSED(parent)
+    if (m_filtered) {
+        // 删除范围之后的行号前移，落在删除范围内的边界移到范围之前
+        const int count = last - first + 1;
+        const auto shift = [=](int row) { return row < first ? row : (row > last ? row - count : first - 1); };
+        m_rows.erase(std::lower_bound(m_rows.begin(), m_rows.end(), first),
+                     std::upper_bound(m_rows.begin(), m_rows.end(), last));
+        for (int &row : m_rows) {
+            row = shift(row);
+        }
+        m_headerRow = shift(m_headerRow);
+        m_lastRow = shift(m_lastRow);
+    }
+    if (m_removing) {
+        m_removing = false;
+        endRemoveRows();
+    }
+}
+
+void FilterProxyModel::onModelReset()
+{
+    m_filtered = false; // 源模型换了工作表，筛选不再适用
+    m_rows.clear();
+    endResetModel();
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <QAbstractProxyModel>
+#include <vector>
+
+// 筛选视图的行映射：数据行（标题行之下到lastRow）中只显示通过筛选的行，标题行及以上、lastRow以下的行原样显示。
+// 只保存通过筛选的行号，单元格与表头都向源模型读取；未筛选时为恒等映射。
+// 筛选改变以纵向布局改变通知视图（VerticalSortHint），列宽不受影响；行表头显示源模型中的行号
+class FilterProxyModel : public QAbstractProxyModel
+{
+    Q_OBJECT
+
+public:
+    explicit FilterProxyModel(QObject *parent = nullptr);
+
+    void setSourceModel(QAbstractItemModel *sourceModel) override;
+
+    bool isFiltered() const { return m_filtered; }
+    void setFilter(int headerRow, int lastRow, std::vector<int> visibleRows); // visibleRows为升序的源行号
+    void clearFilter();
+
+    int mapRowToSource(int row) const;
+    int mapRowFromSource(int sourceRow) const; // 被筛去的行为-1
+
+    QModelIndex mapToSource(const QModelIndex &proxyIndex) const override;
+    QModelIndex mapFromSource(const QModelIndex &sourceIndex) const override;
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &child) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private slots:
+    void onDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QList<int> &roles);
+    void onRowsAboutToBeInserted(const QModelIndex &parent, int first, int last);
+    void onRowsInserted(const QModelIndex &parent, int first, int last);
+    void onRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
+    void onRowsRemoved(const QModelIndex &parent, int first, int last);
+    void onModelReset();
+
+private:
+    int lowerBound(int sourceRow) const; // 第一个源行号不小于sourceRow的行
+    void updateMapping(bool filtered, int headerRow, int lastRow, std::vector<int> rows); // 保持选区等持久索引
+
+    bool m_filtered;
+    int m_headerRow;
+    int m_lastRow;
+    std::vector<int> m_rows; // 通过筛选的数据行（升序）
+    bool m_removing; // 源模型删除的行中有显示的行，已调用beginRemoveRows
+};
@@ -2,7 +2,13 @@
 #include "WorksheetManager.h"
 #include "SearchWidget.h"
 #include "SpreadsheetView.h"
+#include "CsvViewer.h"
+#include "SortDialog.h"
+#include "FilterDialog.h"
+#include "PivotDialog.h"
+#include "WorksheetModel.h"
 #include "../core/FileManager.h"
+#include "../core/EditLog.h"
 
 #include <QApplication>
 #include <QFileDialog>
@@ -12,12 +18,22 @@
 #include <QToolBar>
 #include <QStatusBar>
 #include <QCloseEvent>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QFutureWatcher>
+#include <QEventLoop>
+#include <QPointer>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , m_worksheetManager(nullptr)
     , m_searchWidget(nullptr)
-    , m_workbook(std::make_unique<Workbook>())
+    , m_workbook(std::make_shared<Workbook>())
+    , m_editLog(new EditLog(this))
+    , m_csvCacheAction(nullptr)
+    , m_progressBar(nullptr)
+    , m_cancelButton(nullptr)
+    , m_isBusy(false)
     , m_isModified(false)
 {
     // 初始化
@@ -32,6 +48,7 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
+    m_editLog->close(); // 工作簿先于子对象析构，提前断开
 }
 
 void MainWindow::setupUi()
@@ -58,6 +75,16 @@ void MainWindow::setupUi()
     if (currentView) {
         m_searchWidget->setSpreadsheetView(currentView);
     }
+
+    // 状态栏中的后台任务进度与取消按钮，任务期间才显示
+    m_progressBar = new QProgressBar;
+    m_progressBar->setMaximumWidth(240);
+    m_progressBar->setVisible(false);
+    statusBar()->addPermanentWidget(m_progressBar);
+
+    m_cancelButton = new QPushButton("取消");
+    m_cancelButton->setVisible(false);
+    statusBar()->addPermanentWidget(m_cancelButton);
 }
 
 void MainWindow::setupMenus()
@@ -83,6 +110,17 @@ void MainWindow::setupMenus()
 
     auto exportCsvAction = fileMenu->addAction("导出CSV...", this, &MainWindow::exportToCsv);
     auto importCsvAction = fileMenu->addAction("导入CSV...", this, &MainWindow::importFromCsv);
+    auto viewCsvAction = fileMenu->addAction("只读查看CSV...", this, &MainWindow::viewCsv);
+
+    // 缓存解析结果（<文件名>.sspcache），再次导入未改变的文件时不必重新解析
+    m_csvCacheAction = fileMenu->addAction("导入CSV时使用缓存");
+    m_csvCacheAction->setCheckable(true);
+    m_csvCacheAction->setChecked(true);
+
+    fileMenu->addSeparator();
+
+    auto exportArrowAction = fileMenu->addAction("导出Arrow...", this, &MainWindow::exportToArrow);
+    auto importArrowAction = fileMenu->addAction("导入Arrow...", this, &MainWindow::importFromArrow);
 
     fileMenu->addSeparator();
 
@@ -101,17 +139,32 @@ void MainWindow::setupMenus()
 
     editMenu->addSeparator();
 
-    auto cutAction = editMenu->addAction("剪切(&T)");
+    auto cutAction = editMenu->addAction("剪切(&T)", this, &MainWindow::cutRange);
     cutAction->setShortcut(QKeySequence::Cut);
-    cutAction->setEnabled(false); // 暂时禁用
 
-    auto copyAction = editMenu->addAction("复制(&C)");
+    auto copyAction = editMenu->addAction("复制(&C)", this, &MainWindow::copyRange);
     copyAction->setShortcut(QKeySequence::Copy);
-    copyAction->setEnabled(false); // 暂时禁用
 
-    auto pasteAction = editMenu->addAction("粘贴(&P)");
+    auto pasteAction = editMenu->addAction("粘贴(&P)", this, &MainWindow::pasteRange);
     pasteAction->setShortcut(QKeySequence::Paste);
-    pasteAction->setEnabled(false); // 暂时禁用
+
+    // 数据菜单
+    auto dataMenu = menuBar()->addMenu("数据(&D)");
+    dataMenu->addAction("排序(&S)...", this, &MainWindow::sortRange);
+    dataMenu->addSeparator();
+    dataMenu->addAction("筛选(&F)...", this, &MainWindow::filterColumn);
+    dataMenu->addAction("重新应用筛选", this, [this]() {
+        if (auto view = m_worksheetManager->currentSpreadsheetView()) {
+            view->reapplyFilter();
+        }
+    });
+    dataMenu->addAction("清除筛选", this, [this]() {
+        if (auto view = m_worksheetManager->currentSpreadsheetView()) {
+            view->clearFilter();
+        }
+    });
+    dataMenu->addSeparator();
+    dataMenu->addAction("数据透视(&P)...", this, &MainWindow::createPivot);
 
     // 视图菜单
     auto viewMenu = menuBar()->addMenu("视图(&V)");
@@ -125,6 +178,12 @@ void MainWindow::setupMenus()
     });
     fullscreenAction->setShortcut(QKeySequence::FullScreen);
 
+    viewMenu->addAction("自动调整列宽", this, [this]() {
+        if (auto view = m_worksheetManager->currentSpreadsheetView()) {
+            view->autoFitSelectedColumns();
+        }
+    });
+
     // 帮助菜单
     auto helpMenu = menuBar()->addMenu("帮助(&H)");
     helpMenu->addAction("关于(&A)", this, &MainWindow::about);
@@ -149,10 +208,24 @@ void MainWindow::connectSignals()
     // 连接工作表管理器信号
     connect(m_worksheetManager, &WorksheetManager::currentWorksheetChanged,
             this, &MainWindow::onCurrentWorksheetChanged);
+
+    // 编辑日志记录到修改即标记为已修改
+    connect(m_editLog, &EditLog::changed, this, [this]() { m_isModified = true; });
+    connect(m_editLog, &EditLog::compactionFinished, this, [this](bool ok) {
+        if (!ok) {
+            statusBar()->showMessage("后台合并编辑日志失败，将在下次保存时重试", 3000);
+        }
+    });
 }
 
 void MainWindow::closeEvent(QCloseEvent *event)
 {
+    if (m_isBusy) { // 后台任务正在使用工作簿
+        statusBar()->showMessage("请等待当前操作完成或取消", 2000);
+        event->ignore();
+        return;
+    }
+
     if (maybeSave()) { // 关闭前确认是否需要保存
         event->accept();
     }
@@ -164,7 +237,8 @@ void MainWindow::closeEvent(QCloseEvent *event)
 void MainWindow::newFile()
 {
     if (maybeSave()) { // 新建前检查当前文件是否需要保存
-        m_workbook = std::make_unique<Workbook>(); // 创建新的工作簿实例
+        m_editLog->close(); // 先停止记录旧工作簿
+        m_workbook = std::make_shared<Workbook>(); // 创建新的工作簿实例
         m_worksheetManager->setWorkbook(m_workbook.get()); // 更新工作表管理器
 
         auto currentView = m_worksheetManager->currentSpreadsheetView();
@@ -182,10 +256,24 @@ void MainWindow::openFile()
     if (maybeSave()) {
         // 文件选择对话框，返回文件路径，第4个参数是过滤器：只显示特定扩展名的文件
         QString fileName = QFileDialog::getOpenFileName(this, "打开文件", "",
-                                                        "Spreadsheet Files (*.xlsx *.csv *.ssp);;All Files (*)");
+                                                        "Spreadsheet Files (*.ssp *.json *.xlsx *.csv);;All Files (*)");
 
         if (!fileName.isEmpty()) {
-            if (FileManager::loadWorkbook(m_workbook.get(), fileName)) { // 调用文件管理器的加载方法
+            // 在后台载入到新的工作簿，完成前当前工作簿不受影响
+            QFuture<std::shared_ptr<Workbook>> future = FileManager::loadWorkbookAsync(fileName);
+            if (!waitForTask(QFuture<void>(future), "正在打开")) {
+                statusBar()->showMessage("已取消打开文件", 2000);
+                return;
+            }
+
+            std::shared_ptr<Workbook> workbook = future.result();
+            if (workbook) {
+                m_editLog->close(); // 停止记录旧工作簿
+                m_workbook.swap(workbook); // 旧工作簿在视图切换前保持有效
+
+                // 重放编辑日志后再创建视图
+                const bool recovered = openEditLog(fileName);
+
                 // 交给工作表管理器并设置视图
                 m_worksheetManager->setWorkbook(m_workbook.get());
 
@@ -195,7 +283,7 @@ void MainWindow::openFile()
                 }
 
                 setCurrentFile(fileName);
-                m_isModified = false; // 重置修改状态
+                m_isModified = recovered; // 恢复的修改尚未保存
                 statusBar()->showMessage("文件打开成功", 2000);
             }
             else {
@@ -213,14 +301,21 @@ void MainWindow::saveFile()
         saveAsFile();
     }
     else {
-        // 保存到原文件中
-        if (FileManager::saveWorkbook(m_workbook.get(), m_currentFileName)) {
+        // 增量保存：只需提交编辑日志，日志过大时在后台合并进文件
+        if (m_editLog->isOpen() && m_editLog->commit()) {
             m_isModified = false;
             statusBar()->showMessage("文件保存成功", 2000);
+            if (m_editLog->needsCompaction()) {
+                m_editLog->compact();
+            }
+            return;
         }
-        else {
-            QMessageBox::warning(this, "错误",
-                                 QString("文件保存失败: %1").arg(m_currentFileName));
+
+        // 保存到原文件中
+        if (saveWorkbookTo(m_currentFileName)) {
+            resetEditLog(m_currentFileName);
+            m_isModified = false;
+            statusBar()->showMessage("文件保存成功", 2000);
         }
     }
 }
@@ -228,18 +323,18 @@ void MainWindow::saveFile()
 void MainWindow::saveAsFile()
 {
     QString fileName = QFileDialog::getSaveFileName(this,"保存文件","",
-                                                    "CSV Files (*.csv);;Excel Files (*.xlsx);;SSP Files (*.ssp);;All Files (*)");
+                                                    "SSP Files (*.ssp);;JSON Files (*.json);;CSV Files (*.csv);;Excel Files (*.xlsx);;All Files (*)");
 
     if (!fileName.isEmpty()) {
-        if (FileManager::saveWorkbook(m_workbook.get(), fileName)) {
+        if (QFileInfo(fileName).suffix().isEmpty()) {
+            fileName += ".ssp"; // 未指定扩展名时默认使用二进制格式
+        }
+        if (saveWorkbookTo(fileName)) {
+            resetEditLog(fileName);
             setCurrentFile(fileName);
             m_isModified = false;
             statusBar()->showMessage("文件保存成功", 2000);
         }
-        else {
-            QMessageBox::warning(this, "错误",
-                                 QString("文件保存失败: %1").arg(fileName));
-        }
     }
 }
 
@@ -257,7 +352,11 @@ void MainWindow::exportToCsv()
                                                     "CSV Files (*.csv);;All Files (*)");
 
     if (!fileName.isEmpty()) {
-        if (FileManager::exportToCsv(worksheet.get(), fileName)) { // 调用管理器的导出方法
+        QFuture<bool> future = FileManager::exportToCsvAsync(worksheet.get(), fileName); // 后台导出
+        if (!waitForTask(QFuture<void>(future), "正在导出")) {
+            statusBar()->showMessage("已取消导出", 2000);
+        }
+        else if (future.result()) {
             statusBar()->showMessage("成功导出为CSV文件", 2000);
         }
         else {
@@ -273,24 +372,316 @@ void MainWindow::importFromCsv()
     // 选择要导入的CSV文件
     QString fileName = QFileDialog::getOpenFileName(this,
                                                     "导入CSV", "",
-                                                    "CSV Files (*.csv);;All Files (*)");
+                                                    "CSV Files (*.csv);;TSV Files (*.tsv *.tab);;All Files (*)");
 
     if (!fileName.isEmpty()) {
+        // 按扩展名选择分隔符
+        QString suffix = QFileInfo(fileName).suffix().toLower();
+        auto dialect = (suffix == "tsv" || suffix == "tab") ? CsvTokenizer::tsvDialect()
+                                                            : CsvTokenizer::csvDialect();
+
         auto worksheet = m_workbook->currentWorksheet();
-        if (worksheet && FileManager::importFromCsv(worksheet.get(), fileName)) {
-            auto currentView = m_worksheetManager->currentSpreadsheetView();
-            if (currentView) {
-                currentView->refresh();
+        QPointer<SpreadsheetView> view = m_worksheetManager->currentSpreadsheetView();
+        if (!worksheet || !view) {
+            return;
+        }
+
+        // 渐进式导入：后台分批读入，每批到达即合并到工作表并显示（首批即首屏），
+        // 导入期间可以滚动、查找和编辑；在尚未载入的行中编辑的单元格不会被随后到达的批次覆盖
+        QFuture<std::shared_ptr<Worksheet>> future = FileManager::importFromCsvProgressive(fileName, dialect,
+                                                                                           m_csvCacheAction->isChecked());
+        QFutureWatcher<std::shared_ptr<Worksheet>> watcher;
+        int loadedRows = 0;
+        bool failed = false;
+        bool merging = false;
+        QSet<qint64> edited; // 导入期间在未载入的行中编辑的单元格（行 << 32 | 列）
+        connect(worksheet.get(), &Worksheet::cellChanged, &watcher, [&](int row, int col) {
+            if (!merging && row >= loadedRows) {
+                edited.insert((qint64(row) << 32) | quint32(col));
+            }
+        });
+        connect(&watcher, &QFutureWatcherBase::resultsReadyAt, this, [&](int begin, int end) {
+            for (int i = begin; i < end; ++i) {
+                auto batch = future.resultAt(i);
+                if (!batch) {
+                    failed = true;
+                    continue;
+                }
+                if (batch->rows().isEmpty()) {
+                    continue;
+                }
+
+                const int firstRow = batch->rows().firstKey();
+                const int endRow = batch->rows().lastKey() + 1;
+                int lastCol = -1;
+                batch->usedRange(nullptr, &lastCol);
+                merging = true;
+                worksheet->mergeCells(batch.get(), edited);
+                merging = false;
+                loadedRows = endRow;
+
+                // 滚动条随行数增长；视图绑定该工作表，切换到其他标签页期间仍然同步
+                if (view) {
+                    view->ensureSize(endRow, lastCol + 1);
+                    view->loadRows(firstRow, endRow);
+                }
+                m_progressBar->setFormat(QString("正在导入：已载入%1行 %p%").arg(loadedRows));
             }
+        });
+        watcher.setFuture(future);
+
+        const bool completed = waitForTask(QFuture<void>(future), "正在导入", true);
+        if (loadedRows > 0) {
             m_isModified = true; // 导入后即标记为已修改
-            statusBar()->showMessage("导入CSV文件成功", 2000);
-        } else {
+        }
+
+        if (failed) {
             QMessageBox::warning(this, "错误",
                                  QString("导入CSV失败: %1").arg(fileName));
         }
+        else if (!completed) {
+            statusBar()->showMessage(QString("已取消导入，保留已载入的%1行").arg(loadedRows), 3000);
+        }
+        else {
+            statusBar()->showMessage(QString("导入CSV文件成功，共%1行").arg(loadedRows), 2000);
+        }
     }
 }
 
+// 导出为Arrow IPC文件
+void MainWindow::exportToArrow()
+{
+    auto worksheet = m_workbook->currentWorksheet();
+    if (!worksheet) {
+        QMessageBox::information(this, "提示", "没有可导出的工作表");
+        return;
+    }
+
+    QString fileName = QFileDialog::getSaveFileName(this,
+                                                    "导出Arrow", worksheet->name() + ".arrow",
+                                                    "Arrow Files (*.arrow *.feather);;All Files (*)");
+
+    if (!fileName.isEmpty()) {
+        QFuture<bool> future = FileManager::exportToArrowAsync(worksheet.get(), fileName);
+        if (!waitForTask(QFuture<void>(future), "正在导出")) {
+            statusBar()->showMessage("已取消导出", 2000);
+        }
+        else if (future.result()) {
+            statusBar()->showMessage("成功导出为Arrow文件", 2000);
+        }
+        else {
+            QMessageBox::warning(this, "错误",
+                                 QString("导出Arrow文件失败: %1").arg(fileName));
+        }
+    }
+}
+
+// 导入Arrow IPC文件：后台读入到新的工作表，完成后合并到当前工作表（第i个字段为第i列）
+void MainWindow::importFromArrow()
+{
+    QString fileName = QFileDialog::getOpenFileName(this,
+                                                    "导入Arrow", "",
+                                                    "Arrow Files (*.arrow *.feather);;All Files (*)");
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    auto worksheet = m_workbook->currentWorksheet();
+    QPointer<SpreadsheetView> view = m_worksheetManager->currentSpreadsheetView();
+    if (!worksheet || !view) {
+        return;
+    }
+
+    QFuture<std::shared_ptr<Worksheet>> future = FileManager::importFromArrowAsync(fileName);
+    if (!waitForTask(QFuture<void>(future), "正在导入")) {
+        statusBar()->showMessage("已取消导入", 2000);
+        return;
+    }
+
+    auto imported = future.result();
+    if (!imported) {
+        QMessageBox::warning(this, "错误",
+                             QString("导入Arrow文件失败: %1").arg(fileName));
+        return;
+    }
+
+    int lastRow = -1;
+    int lastCol = -1;
+    imported->usedRange(&lastRow, &lastCol);
+    worksheet->mergeCells(imported.get());
+    if (lastRow >= 0) {
+        m_isModified = true;
+        if (view) {
+            view->ensureSize(lastRow + 1, lastCol + 1);
+            view->loadRows(0, lastRow + 1);
+        }
+    }
+    statusBar()->showMessage(QString("导入Arrow文件成功，共%1行").arg(lastRow + 1), 2000);
+}
+
+// 只读查看CSV：映射文件并建立行索引，在独立窗口中按需解析显示的行，不载入工作簿
+void MainWindow::viewCsv()
+{
+    QString fileName = QFileDialog::getOpenFileName(this,
+                                                    "只读查看CSV", "",
+                                                    "CSV Files (*.csv);;TSV Files (*.tsv *.tab);;All Files (*)");
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    QString suffix = QFileInfo(fileName).suffix().toLower();
+    auto dialect = (suffix == "tsv" || suffix == "tab") ? CsvTokenizer::tsvDialect()
+                                                        : CsvTokenizer::csvDialect();
+
+    // 建立索引不访问工作簿，期间可以继续编辑
+    QFuture<std::shared_ptr<MappedCsv>> future = FileManager::openMappedCsvAsync(fileName, dialect);
+    if (!waitForTask(QFuture<void>(future), "正在建立索引", true)) {
+        statusBar()->showMessage("已取消查看", 2000);
+        return;
+    }
+
+    auto csv = future.result();
+    if (!csv) {
+        QMessageBox::warning(this, "错误",
+                             QString("无法打开CSV文件: %1").arg(fileName));
+        return;
+    }
+
+    auto viewer = new CsvViewer(csv, this);
+    viewer->show();
+}
+
+void MainWindow::cutRange()
+{
+    if (auto view = m_worksheetManager->currentSpreadsheetView()) {
+        QApplication::setOverrideCursor(Qt::WaitCursor);
+        view->cutSelection();
+        QApplication::restoreOverrideCursor();
+        m_isModified = true;
+    }
+}
+
+void MainWindow::copyRange()
+{
+    if (auto view = m_worksheetManager->currentSpreadsheetView()) {
+        view->copySelection();
+        statusBar()->showMessage("已复制", 2000);
+    }
+}
+
+void MainWindow::pasteRange()
+{
+    if (auto view = m_worksheetManager->currentSpreadsheetView()) {
+        QApplication::setOverrideCursor(Qt::WaitCursor);
+        view->paste();
+        QApplication::restoreOverrideCursor();
+        m_isModified = true;
+    }
+}
+
+// 排序：选中多个单元格时排序选中的区域，否则排序整个工作表
+void MainWindow::sortRange()
+{
+    SpreadsheetView *view = m_worksheetManager->currentSpreadsheetView();
+    Worksheet *worksheet = view ? view->worksheet() : nullptr;
+    if (!worksheet) {
+        return;
+    }
+
+    QRect range = view->selectedRange();
+    if (range.width() * qint64(range.height()) <= 1) {
+        range = QRect(0, 0, worksheet->columnCount(), worksheet->rowCount());
+    }
+
+    const WorksheetModel *model = view->worksheetModel();
+    auto columnName = [model](int col) { return model->headerData(col, Qt::Horizontal).toString(); };
+    QList<QPair<int, QString>> columns;
+    for (int col = range.left(); col <= range.right(); ++col) {
+        columns.append({col, QString("列 %1").arg(columnName(col))});
+    }
+    const QString rangeText = QString("排序范围: %1%2:%3%4").arg(columnName(range.left())).arg(range.top() + 1)
+                                  .arg(columnName(range.right())).arg(range.bottom() + 1);
+
+    SortDialog dialog(columns, rangeText, this);
+    if (dialog.exec() != QDialog::Accepted || dialog.keys().isEmpty()) {
+        return;
+    }
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    worksheet->sort(Worksheet::SortSpec{range.top(), range.bottom(), range.left(), range.right(), dialog.keys()});
+    QApplication::restoreOverrideCursor();
+
+    m_isModified = true;
+    statusBar()->showMessage("排序完成", 2000);
+}
+
+// 筛选当前单元格所在的列；第一次筛选时以选中区域的第一行为标题行
+void MainWindow::filterColumn()
+{
+    SpreadsheetView *view = m_worksheetManager->currentSpreadsheetView();
+    AutoFilter *filter = view ? view->ensureAutoFilter() : nullptr;
+    if (!filter) {
+        return;
+    }
+
+    const QModelIndex current = view->currentIndex();
+    const int column = current.isValid() ? current.column() : 0;
+    const QString columnName = view->worksheetModel()->headerData(column, Qt::Horizontal).toString();
+
+    FilterDialog dialog(columnName, filter->distinctValues(column), filter->criterion(column), this);
+    if (dialog.exec() != QDialog::Accepted) {
+        return;
+    }
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    view->setColumnFilter(column, dialog.criterion());
+    QApplication::restoreOverrideCursor();
+}
+
+// 数据透视：后台分组汇总当前工作表（期间不可编辑），结果写入新的工作表
+void MainWindow::createPivot()
+{
+    SpreadsheetView *view = m_worksheetManager->currentSpreadsheetView();
+    auto worksheet = m_workbook->currentWorksheet();
+    if (!view || !worksheet) {
+        return;
+    }
+
+    const WorksheetModel *model = view->worksheetModel();
+    QList<QPair<int, QString>> columns;
+    for (int col = 0; col < worksheet->columnCount(); ++col) {
+        auto header = worksheet->cellAt(0, col);
+        const QString name = QString("列 %1").arg(model->headerData(col, Qt::Horizontal).toString());
+        columns.append({col, header && !header->displayText().isEmpty()
+                                 ? QString("%1 (%2)").arg(name, header->displayText()) : name});
+    }
+
+    PivotDialog dialog(columns, 0, this);
+    if (dialog.exec() != QDialog::Accepted) {
+        return;
+    }
+
+    QFuture<std::shared_ptr<Worksheet>> future = PivotTable::buildAsync(worksheet.get(), dialog.spec());
+    if (!waitForTask(QFuture<void>(future), "正在汇总")) {
+        statusBar()->showMessage("已取消数据透视", 2000);
+        return;
+    }
+    auto result = future.result();
+    if (!result) {
+        return;
+    }
+
+    m_worksheetManager->addWorksheetTab(QString("%1 透视").arg(worksheet->name()));
+    auto target = m_workbook->worksheet(m_workbook->worksheetCount() - 1);
+    int lastRow = -1;
+    int lastCol = -1;
+    result->usedRange(&lastRow, &lastCol);
+    const int groups = lastRow - 1; // 除去标题行与总计行
+    target->mergeCells(result.get());
+    m_isModified = true;
+    statusBar()->showMessage(QString("数据透视完成，共%1组").arg(groups), 2000);
+}
+
 // 工作表切换
 void MainWindow::onCurrentWorksheetChanged(int index)
 {
@@ -321,10 +712,112 @@ bool MainWindow::maybeSave()
         else if (result == QMessageBox::Cancel) { // 取消
             return false;
         }
+        m_editLog->discardUncommitted(); // 放弃：截去日志中未保存的批次
     }
     return true; // 放弃更改
 }
 
+// 打开编辑日志：重放已保存的修改，询问是否恢复崩溃前未保存的修改
+bool MainWindow::openEditLog(const QString &fileName)
+{
+    if (!EditLog::supports(fileName)) {
+        return false;
+    }
+
+    int uncommitted = 0;
+    if (!m_editLog->open(m_workbook.get(), fileName, &uncommitted)) {
+        QMessageBox::warning(this, "错误",
+                             QString("无法读取编辑日志: %1").arg(EditLog::logFileName(fileName)));
+        return false;
+    }
+
+    if (uncommitted > 0) {
+        QMessageBox::StandardButton reply = QMessageBox::question(this,
+                                                                  "恢复",
+                                                                  "检测到上次未保存的修改（程序可能异常退出）.\n是否恢复这些修改?",
+                                                                  QMessageBox::Yes | QMessageBox::No);
+        if (reply == QMessageBox::Yes) {
+            m_editLog->recoverUncommitted();
+            return true;
+        }
+        m_editLog->discardUncommitted();
+    }
+    return false;
+}
+
+// 后台完整保存：取消或失败时原文件保持不变
+bool MainWindow::saveWorkbookTo(const QString &fileName)
+{
+    QFuture<bool> future = FileManager::saveWorkbookAsync(m_workbook.get(), fileName);
+    if (!waitForTask(QFuture<void>(future), "正在保存")) {
+        statusBar()->showMessage("已取消保存", 2000);
+        return false;
+    }
+    if (!future.result()) {
+        QMessageBox::warning(this, "错误",
+                             QString("文件保存失败: %1").arg(fileName));
+        return false;
+    }
+    return true;
+}
+
+bool MainWindow::waitForTask(const QFuture<void> &future, const QString &text, bool allowEditing)
+{
+    QFutureWatcher<void> watcher;
+    QEventLoop loop;
+    connect(&watcher, &QFutureWatcher<void>::progressRangeChanged, m_progressBar, &QProgressBar::setRange);
+    connect(&watcher, &QFutureWatcher<void>::progressValueChanged, m_progressBar, &QProgressBar::setValue);
+    connect(&watcher, &QFutureWatcher<void>::finished, &loop, &QEventLoop::quit);
+    connect(m_cancelButton, &QPushButton::clicked, &watcher, &QFutureWatcher<void>::cancel);
+
+    m_progressBar->setRange(0, 0); // 报告进度前显示为忙碌状态
+    m_progressBar->setFormat(text + " %p%");
+    setBusy(true, allowEditing);
+
+    // 取消后任务可能仍在读取工作簿，始终等到任务真正结束
+    watcher.setFuture(future);
+    if (!future.isFinished()) {
+        loop.exec();
+    }
+
+    setBusy(false);
+    return !future.isCanceled();
+}
+
+void MainWindow::setBusy(bool busy, bool allowEditing)
+{
+    if (busy) {
+        // 禁用菜单、工具栏动作及其快捷键，恢复时只启用原本可用的动作
+        for (QAction *action : findChildren<QAction *>()) {
+            if (action->isEnabled()) {
+                action->setEnabled(false);
+                m_busyActions.append(action);
+            }
+        }
+    }
+    else {
+        for (QAction *action : std::as_const(m_busyActions)) {
+            action->setEnabled(true);
+        }
+        m_busyActions.clear();
+    }
+
+    centralWidget()->setEnabled(!busy || allowEditing);
+    m_progressBar->setVisible(busy);
+    m_cancelButton->setVisible(busy);
+    m_isBusy = busy;
+}
+
+void MainWindow::resetEditLog(const QString &fileName)
+{
+    if (EditLog::supports(fileName)) {
+        m_editLog->reset(m_workbook.get(), fileName);
+    }
+    else {
+        m_editLog->close();
+    }
+}
+
 // 设置当前文件名
 void MainWindow::setCurrentFile(const QString &fileName)
 {
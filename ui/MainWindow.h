@@ -6,12 +6,16 @@
 #include <QToolBar>
 #include <QStatusBar> // 界面组件
 #include <QVBoxLayout>
+#include <QFuture>
 #include <memory>
 
 #include "../core/Workbook.h"
 
 class WorksheetManager;
 class SearchWidget;
+class EditLog;
+class QProgressBar;
+class QPushButton;
 
 class MainWindow : public QMainWindow
 {
@@ -34,6 +38,19 @@ private slots:
     // 文件格式
     void exportToCsv();
     void importFromCsv();
+    void viewCsv(); // 只读查看大型CSV文件
+    void exportToArrow(); // Arrow IPC列式文件，供数据分析工具直接读取
+    void importFromArrow();
+
+    // 编辑：单元格区域的剪切、复制与粘贴（编辑单元格时快捷键由编辑框处理）
+    void cutRange();
+    void copyRange();
+    void pasteRange();
+
+    // 数据
+    void sortRange(); // 按关键字排序选中的区域或整个工作表
+    void filterColumn(); // 设置当前列的筛选条件
+    void createPivot(); // 分组汇总当前工作表，结果放在新的工作表中
 
     void about();
 
@@ -46,10 +63,26 @@ private:
     void connectSignals();
     bool maybeSave();
     void setCurrentFile(const QString &fileName);
+    bool openEditLog(const QString &fileName); // 打开编辑日志，返回是否恢复了未保存的修改
+    void resetEditLog(const QString &fileName); // 完整保存后以新文件为基准
+    bool saveWorkbookTo(const QString &fileName); // 后台完整保存，失败时提示
+
+    // 后台任务：等待期间界面保持响应，显示进度与取消按钮，并禁止其他文件操作；
+    // 任务读取工作簿时同时禁止编辑（allowEditing为false）。返回false表示已取消
+    bool waitForTask(const QFuture<void> &future, const QString &text, bool allowEditing = false);
+    void setBusy(bool busy, bool allowEditing = false);
 
     WorksheetManager *m_worksheetManager;
     SearchWidget *m_searchWidget;
-    std::unique_ptr<Workbook> m_workbook;
+    std::shared_ptr<Workbook> m_workbook;
+    EditLog *m_editLog; // 增量保存与崩溃恢复
+
+    QAction *m_csvCacheAction; // 导入CSV时是否使用旁路缓存
+
+    QProgressBar *m_progressBar;
+    QPushButton *m_cancelButton;
+    QList<QAction *> m_busyActions; // 后台任务期间被禁用的动作
+    bool m_isBusy;
 
     QString m_currentFileName; // 当前文件的路径
     bool m_isModified; // 修改标志
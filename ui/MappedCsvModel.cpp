@@ -0,0 +1,60 @@
+#include "MappedCsvModel.h"
+
+#include <climits>
+
+MappedCsvModel::MappedCsvModel(std::shared_ptr<MappedCsv> csv, QObject *parent)
+    : QAbstractTableModel(parent)
+    , m_csv(std::move(csv))
+{}
+
+int MappedCsvModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid() || !m_csv) {
+        return 0;
+    }
+    return int(qMin<qint64>(m_csv->rowCount(), INT_MAX)); // 视图的行号为int
+}
+
+int MappedCsvModel::columnCount(const QModelIndex &parent) const
+{
+    if (parent.isValid() || !m_csv) {
+        return 0;
+    }
+    return m_csv->columnCount();
+}
+
+QVariant MappedCsvModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || !m_csv || role != Qt::DisplayRole) {
+        return QVariant();
+    }
+    return m_csv->field(index.row(), index.column());
+}
+
+QVariant MappedCsvModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    if (orientation == Qt::Vertical) {
+        return section + 1; // 行号 (1, 2, 3, ...)
+    }
+
+    // 列标题 (A, B, C, ...)
+    QString label;
+    int n = section;
+    while (n >= 0) {
+        label.prepend(QChar('A' + (n % 26)));
+        n = n / 26 - 1;
+    }
+    return label;
+}
+
+Qt::ItemFlags MappedCsvModel::flags(const QModelIndex &index) const
+{
+    if (!index.isValid()) {
+        return Qt::NoItemFlags;
+    }
+    return Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <QAbstractTableModel>
+#include <memory>
+
+#include "../core/MappedCsv.h"
+
+// 只读CSV查看的表格模型：视图请求哪些行才解析哪些行
+class MappedCsvModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    explicit MappedCsvModel(std::shared_ptr<MappedCsv> csv, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override; // 只可选中，不可编辑
+
+private:
+    std::shared_ptr<MappedCsv> m_csv;
+};
@@ -0,0 +1,123 @@
+#include "PivotDialog.h"
+
+#include <QDialogButtonBox>
+#include <QFormLayout>
+#include <QGroupBox>
+#include <QHBoxLayout>
+#include <QVBoxLayout>
+
+namespace {
+
+const int AggregateRole = Qt::UserRole + 1;
+
+}
+
+PivotDialog::PivotDialog(const QList<QPair<int, QString>> &columns, int headerRow, QWidget *parent)
+    : QDialog(parent)
+{
+    setWindowTitle("数据透视");
+    setWindowFlags(windowFlags() & ~Qt::WindowContextHelpButtonHint);
+
+    auto mainLayout = new QVBoxLayout(this);
+
+    auto formLayout = new QFormLayout;
+    m_headerRowSpin = new QSpinBox;
+    m_headerRowSpin->setRange(1, 1048576);
+    m_headerRowSpin->setValue(headerRow + 1); // 显示从1开始的行号
+    formLayout->addRow("标题行:", m_headerRowSpin);
+    mainLayout->addLayout(formLayout);
+
+    // 分组列
+    auto groupBox = new QGroupBox("分组列");
+    auto groupLayout = new QVBoxLayout(groupBox);
+    m_groupList = new QListWidget;
+    for (const auto &column : columns) {
+        auto item = new QListWidgetItem(column.second, m_groupList);
+        item->setData(Qt::UserRole, column.first);
+        item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+        item->setCheckState(Qt::Unchecked);
+    }
+    groupLayout->addWidget(m_groupList);
+    mainLayout->addWidget(groupBox);
+
+    // 汇总项
+    auto valueBox = new QGroupBox("汇总项");
+    auto valueLayout = new QVBoxLayout(valueBox);
+    auto fieldLayout = new QHBoxLayout;
+    m_valueColumnBox = new QComboBox;
+    for (const auto &column : columns) {
+        m_valueColumnBox->addItem(column.second, column.first);
+    }
+    m_aggregateBox = new QComboBox;
+    for (auto aggregate : {PivotTable::Sum, PivotTable::Count, PivotTable::Average,
+                           PivotTable::Minimum, PivotTable::Maximum}) {
+        m_aggregateBox->addItem(PivotTable::aggregateName(aggregate), aggregate);
+    }
+    auto addButton = new QPushButton("添加");
+    auto removeButton = new QPushButton("删除");
+    fieldLayout->addWidget(m_valueColumnBox, 1);
+    fieldLayout->addWidget(m_aggregateBox);
+    fieldLayout->addWidget(addButton);
+    fieldLayout->addWidget(removeButton);
+    valueLayout->addLayout(fieldLayout);
+    m_valueList = new QListWidget;
+    valueLayout->addWidget(m_valueList);
+    mainLayout->addWidget(valueBox);
+
+    auto buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+    m_okButton = buttons->button(QDialogButtonBox::Ok);
+    connect(buttons, &QDialogButtonBox::accepted, this, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+    mainLayout->addWidget(buttons);
+
+    connect(addButton, &QPushButton::clicked, this, &PivotDialog::addValueField);
+    connect(removeButton, &QPushButton::clicked, this, &PivotDialog::removeValueField);
+    connect(m_groupList, &QListWidget::itemChanged, this, &PivotDialog::updateOkButton);
+    updateOkButton();
+}
+
+PivotTable::Spec PivotDialog::spec() const
+{
+    PivotTable::Spec spec;
+    spec.headerRow = m_headerRowSpin->value() - 1;
+    for (int i = 0; i < m_groupList->count(); ++i) {
+        const QListWidgetItem *item = m_groupList->item(i);
+        if (item->checkState() == Qt::Checked) {
+            spec.groupColumns.append(item->data(Qt::UserRole).toInt());
+        }
+    }
+    for (int i = 0; i < m_valueList->count(); ++i) {
+        const QListWidgetItem *item = m_valueList->item(i);
+        spec.values.append(PivotTable::ValueField{item->data(Qt::UserRole).toInt(),
+                                                  PivotTable::Aggregate(item->data(AggregateRole).toInt())});
+    }
+    return spec;
+}
+
+void PivotDialog::addValueField()
+{
+    if (m_valueColumnBox->currentIndex() < 0) {
+        return;
+    }
+    auto item = new QListWidgetItem(QString("%1 - %2").arg(m_aggregateBox->currentText(), m_valueColumnBox->currentText()),
+                                    m_valueList);
+    item->setData(Qt::UserRole, m_valueColumnBox->currentData());
+    item->setData(AggregateRole, m_aggregateBox->currentData());
+    updateOkButton();
+}
+
+void PivotDialog::removeValueField()
+{
+    delete m_valueList->currentItem();
+    updateOkButton();
+}
+
+// 至少需要一个分组列或汇总项
+void PivotDialog::updateOkButton()
+{
+    bool hasGroup = false;
+    for (int i = 0; i < m_groupList->count() && !hasGroup; ++i) {
+        hasGroup = m_groupList->item(i)->checkState() == Qt::Checked;
+    }
+    m_okButton->setEnabled(hasGroup || m_valueList->count() > 0);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "../core/PivotTable.h"
+
+#include <QDialog>
+#include <QComboBox>
+#include <QListWidget>
+#include <QPushButton>
+#include <QSpinBox>
+
+// 数据透视对话框：选择标题行、分组列（可多选）与汇总项（列与汇总方式，可添加多个）
+class PivotDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    // columns为可选的列（列号与显示名称）
+    PivotDialog(const QList<QPair<int, QString>> &columns, int headerRow, QWidget *parent = nullptr);
+
+    PivotTable::Spec spec() const;
+
+private slots:
+    void addValueField();
+    void removeValueField();
+    void updateOkButton();
+
+private:
+    QSpinBox *m_headerRowSpin;
+    QListWidget *m_groupList;
+    QComboBox *m_valueColumnBox;
+    QComboBox *m_aggregateBox;
+    QListWidget *m_valueList; // 每项的数据为列号与汇总方式
+    QPushButton *m_okButton;
+};
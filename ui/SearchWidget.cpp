@@ -1,6 +1,9 @@
 #include "SearchWidget.h"
 #include "SpreadsheetView.h"
+#include "WorksheetModel.h"
+#include "../core/Cell.h"
 #include <QMessageBox>
+#include <QRegularExpression>
 
 SearchWidget::SearchWidget(QWidget *parent)
     : QWidget(parent)
@@ -94,12 +97,24 @@ void SearchWidget::performSearch()
     Qt::CaseSensitivity caseSensitivity = m_caseSensitiveCheck->isChecked() ?
                                           Qt::CaseSensitive : Qt::CaseInsensitive; // 是否区分大小写
 
-    // 搜索所有单元格
-    for (int row = 0; row < m_spreadsheetView->rowCount(); ++row) {
-        for (int col = 0; col < m_spreadsheetView->columnCount(); ++col) {
-            auto item = m_spreadsheetView->item(row, col);
-            if (item) { // 只检查非空单元格
-                QString cellText = item->text();
+    Worksheet *sheet = m_spreadsheetView->worksheet();
+    if (!sheet) {
+        return;
+    }
+
+    // 只遍历工作表中已分配的单元格（按行、列顺序），限于视图范围内
+    const auto &rows = sheet->rows();
+    const int rowCount = m_spreadsheetView->rowCount();
+    const int columnCount = m_spreadsheetView->columnCount();
+    for (auto rowIt = rows.cbegin(); rowIt != rows.cend() && rowIt.key() < rowCount; ++rowIt) {
+        for (auto it = rowIt->cbegin(); it != rowIt->cend() && it.key() < columnCount; ++it) {
+            const int row = rowIt.key();
+            const int col = it.key();
+            if (it.value()) {
+                QString cellText = it.value()->displayText();
+                if (cellText.isEmpty()) { // 只检查非空单元格
+                    continue;
+                }
                 bool found = false;
 
                 if (m_wholeWordCheck->isChecked()) {
@@ -155,8 +170,7 @@ void SearchWidget::jumpToResult(int index)
 {
     if (index >= 0 && index < m_searchResults.size()) {
         const auto &result = m_searchResults[index];
-        m_spreadsheetView->setCurrentCell(result.row, result.col); // 视图移动到目标单元格位置
-        m_spreadsheetView->scrollToItem(m_spreadsheetView->item(result.row, result.col));
+        m_spreadsheetView->setCurrentCell(result.row, result.col); // 视图移动到目标单元格位置并滚动到可见
 
         m_resultLabel->setText(QString("第 %1 个（共 %2 个）").arg(index + 1).arg(m_searchResults.size()));
         emit cellFound(result.row, result.col);
@@ -186,9 +200,10 @@ void SearchWidget::onReplaceClicked()
 {
     if (m_currentResultIndex >= 0 && m_currentResultIndex < m_searchResults.size()) {
         const auto &result = m_searchResults[m_currentResultIndex];
-        auto item = m_spreadsheetView->item(result.row, result.col);
-        if (item) { // 单元格存在
-            QString newText = item->text();
+        WorksheetModel *model = m_spreadsheetView->worksheetModel();
+        const QModelIndex index = model->index(result.row, result.col);
+        if (index.isValid()) { // 单元格在视图范围内
+            QString newText = model->data(index).toString();
             QString searchText = m_searchEdit->text();
             QString replaceText = m_replaceEdit->text();
 
@@ -207,7 +222,7 @@ void SearchWidget::onReplaceClicked()
                 newText.replace(searchText, replaceText, caseSensitivity);
             }
 
-            item->setText(newText);
+            model->setData(index, newText); // 与直接编辑相同：写入工作表并刷新显示
 
             // 更新搜索结果
             performSearch();
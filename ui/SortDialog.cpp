@@ -0,0 +1,59 @@
+#include "SortDialog.h"
+
+#include <QDialogButtonBox>
+#include <QFormLayout>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QVBoxLayout>
+
+SortDialog::SortDialog(const QList<QPair<int, QString>> &columns, const QString &rangeText, QWidget *parent)
+    : QDialog(parent)
+{
+    setWindowTitle("排序");
+    setWindowFlags(windowFlags() & ~Qt::WindowContextHelpButtonHint);
+
+    auto mainLayout = new QVBoxLayout(this);
+    mainLayout->addWidget(new QLabel(rangeText));
+
+    auto formLayout = new QFormLayout;
+    const QStringList labels = {"主要关键字:", "次要关键字:", "第三关键字:"};
+    for (int k = 0; k < MaxKeys; ++k) {
+        auto columnBox = new QComboBox;
+        if (k > 0) {
+            columnBox->addItem("(无)", -1); // 次要关键字可以不选
+        }
+        for (const auto &column : columns) {
+            columnBox->addItem(column.second, column.first);
+        }
+
+        auto orderBox = new QComboBox;
+        orderBox->addItem("升序", true);
+        orderBox->addItem("降序", false);
+
+        auto rowLayout = new QHBoxLayout;
+        rowLayout->addWidget(columnBox, 1);
+        rowLayout->addWidget(orderBox);
+        formLayout->addRow(labels.at(k), rowLayout);
+
+        m_columnBoxes.append(columnBox);
+        m_orderBoxes.append(orderBox);
+    }
+    mainLayout->addLayout(formLayout);
+
+    auto buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+    connect(buttons, &QDialogButtonBox::accepted, this, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+    mainLayout->addWidget(buttons);
+}
+
+QList<Worksheet::SortKey> SortDialog::keys() const
+{
+    QList<Worksheet::SortKey> keys;
+    for (int k = 0; k < m_columnBoxes.size(); ++k) {
+        const int column = m_columnBoxes.at(k)->currentData().toInt();
+        if (column >= 0) {
+            keys.append(Worksheet::SortKey{column, m_orderBoxes.at(k)->currentData().toBool()});
+        }
+    }
+    return keys;
+}
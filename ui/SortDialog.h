@@ -0,0 +1,25 @@
+#pragma once
+
+#include "../core/Worksheet.h"
+
+#include <QDialog>
+#include <QComboBox>
+#include <QList>
+
+// 排序条件对话框：最多三个关键字，每个关键字选择列与升降序
+class SortDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    static constexpr int MaxKeys = 3;
+
+    // columns为可选的列（列号与显示名称），范围说明显示在对话框顶部
+    SortDialog(const QList<QPair<int, QString>> &columns, const QString &rangeText, QWidget *parent = nullptr);
+
+    QList<Worksheet::SortKey> keys() const; // 按选择顺序，跳过未选择列的关键字
+
+private:
+    QList<QComboBox *> m_columnBoxes;
+    QList<QComboBox *> m_orderBoxes;
+};
@@ -1,29 +1,48 @@
 #include "SpreadsheetView.h"
+#include "WorksheetModel.h"
+#include "FilterProxyModel.h"
 #include "CellDetailEditor.h"
+#include "CellDelegate.h"
+#include "ColumnAutoFit.h"
+#include "CellMimeData.h"
 #include "../core/Cell.h"
 
 #include <QDebug>
+#include <QApplication>
+#include <QClipboard>
+#include <QPainter>
+#include <QVarLengthArray>
+#include <QThreadPool>
+#include <QPromise>
+#include <QFutureWatcher>
+#include <QStyleOptionHeader>
 
 
-SpreadsheetView::SpreadsheetView(Workbook *workbook, QWidget *parent)
-    : QTableWidget(parent)
-    , m_workbook(workbook)
+SpreadsheetView::SpreadsheetView(Worksheet *worksheet, QWidget *parent)
+    : QTableView(parent)
+    , m_model(new WorksheetModel(this))
+    , m_filterModel(new FilterProxyModel(this))
+    , m_updateTimer(new QTimer(this))
+    , m_autoFitGeneration(0)
 {
-    // 初始化
-    setRowCount(100);
-    setColumnCount(26);
-
+    // 初始化：行列数取自工作表（新工作表默认100行26列）
+    m_filterModel->setSourceModel(m_model);
+    setModel(m_filterModel);
+    setItemDelegate(new CellDelegate(this));
+    setShowGrid(false); // 网格线由paintEvent统一绘制，不逐个单元格绘制
     setupHeaders();
 
-    if (m_workbook) {
-        loadData();
-    }
+    // 双击表头分隔线时用抽样测量代替QTableView逐行测量的resizeColumnToContents
+    disconnect(horizontalHeader(), SIGNAL(sectionHandleDoubleClicked(int)), this, SLOT(resizeColumnToContents(int)));
+    connect(horizontalHeader(), &QHeaderView::sectionHandleDoubleClicked, this, [this](int col) {
+        autoFitColumns(col, col);
+    });
+
+    m_updateTimer->setSingleShot(true);
+    m_updateTimer->setInterval(UpdateInterval);
+    connect(m_updateTimer, &QTimer::timeout, this, &SpreadsheetView::flushUpdates);
 
-    // 连接信号槽
-    connect(this, &QTableWidget::cellChanged,
-            this, &SpreadsheetView::onCellChanged);
-    connect(this, &QTableWidget::currentCellChanged,
-            this, &SpreadsheetView::onCurrentCellChanged);
+    setWorksheet(worksheet);
 }
 
 void SpreadsheetView::mouseDoubleClickEvent(QMouseEvent *event)
@@ -32,140 +51,411 @@ void SpreadsheetView::mouseDoubleClickEvent(QMouseEvent *event)
         editCellDetails(); // 打开编辑器
     }
     else {
-        QTableWidget::mouseDoubleClickEvent(event); // 其余事件仍由基类处理
+        QTableView::mouseDoubleClickEvent(event); // 其余事件仍由基类处理
     }
 }
 
+// 网格线：沿可见的行列边界（跳过隐藏的行列）收集线段，一次drawLines画出
+void SpreadsheetView::paintEvent(QPaintEvent *event)
+{
+    QTableView::paintEvent(event);
+
+    // 边界取自视图的模型：筛选时视图中的行数少于工作表的行数
+    const int lastRow = model()->rowCount() - 1;
+    const int lastColumn = model()->columnCount() - 1;
+    if (lastRow < 0 || lastColumn < 0) {
+        return;
+    }
+    const int right = qMin(viewport()->width(), columnViewportPosition(lastColumn) + columnWidth(lastColumn));
+    const int bottom = qMin(viewport()->height(), rowViewportPosition(lastRow) + rowHeight(lastRow));
+    if (right <= 0 || bottom <= 0) {
+        return;
+    }
+
+    QVarLengthArray<QLine, 256> lines;
+    for (int y = 0; y < bottom;) {
+        const int row = rowAt(y);
+        if (row < 0) {
+            break;
+        }
+        y = rowViewportPosition(row) + rowHeight(row);
+        lines.append(QLine(0, y - 1, right - 1, y - 1));
+    }
+    for (int x = 0; x < right;) {
+        const int col = columnAt(x);
+        if (col < 0) {
+            break;
+        }
+        x = columnViewportPosition(col) + columnWidth(col);
+        lines.append(QLine(x - 1, 0, x - 1, bottom - 1));
+    }
+
+    QStyleOptionViewItem option;
+    initViewItemOption(&option);
+    const int gridHint = style()->styleHint(QStyle::SH_Table_GridLineColor, &option, this);
+
+    QPainter painter(viewport());
+    painter.setPen(QPen(QColor::fromRgba(static_cast<QRgb>(gridHint)), 0, gridStyle()));
+    painter.drawLines(lines.constData(), int(lines.size()));
+}
+
 void SpreadsheetView::editCellDetails()
 {
-    int row = currentRow();
-    int col = currentColumn();
+    const QModelIndex index = currentIndex();
+    Worksheet *sheet = worksheet();
 
-    if (row >= 0 && col >= 0 && m_workbook && m_workbook->currentWorksheet()) {
-        auto cell = m_workbook->currentWorksheet()->cell(row, col);
+    if (index.isValid() && sheet) {
+        const int row = sourceRow(index.row());
+        auto cell = sheet->cell(row, index.column());
 
         CellDetailEditor editor(cell, this); // 创建编辑器，父窗口为当前视图
         if (editor.exec() == QDialog::Accepted) { // 应用更改
-            blockSignals(true); // 阻塞信号，防止初次创建时
-            auto item = this->item(row, col);
-            if (!item) {
-                item = new QTableWidgetItem();
-                setItem(row, col, item);
-            }
-            item->setText(cell->displayText()); // 显示同步
-            blockSignals(false);
+            markDirty(QRect(index.column(), row, 1, 1)); // 显示同步（只读标记等不经cellChanged）
         }
     }
 }
 
+// 尺寸保存在工作表中，模型收到sizeChanged后插入或删除行列
 void SpreadsheetView::resizeSheet(int rows, int cols)
 {
-    setRowCount(rows);
-    setColumnCount(cols);
-    setupHeaders();
-    loadData();
+    if (Worksheet *sheet = worksheet()) {
+        sheet->setSize(qMin(rows, int(Worksheet::MaxRows)), qMin(cols, int(Worksheet::MaxColumns)));
+    }
+}
+
+void SpreadsheetView::ensureSize(int rows, int cols)
+{
+    if (Worksheet *sheet = worksheet()) {
+        sheet->setSize(qMax(rows, sheet->rowCount()), qMax(cols, sheet->columnCount()));
+    }
+}
+
+void SpreadsheetView::loadRows(int firstRow, int endRow)
+{
+    if (firstRow < endRow) {
+        markDirty(QRect(0, firstRow, columnCount(), endRow - firstRow));
+    }
 }
 
-void SpreadsheetView::setWorkbook(Workbook *workbook)
+// 绑定工作表：模型直接读取该工作表，不复制任何单元格
+void SpreadsheetView::setWorksheet(Worksheet *worksheet)
 {
-    m_workbook = workbook;
-    loadData();
+    if (Worksheet *previous = m_model->worksheet()) {
+        disconnect(previous, &Worksheet::cellChanged, this, &SpreadsheetView::onCellChanged);
+        disconnect(previous, &Worksheet::sorted, this, &SpreadsheetView::onSorted);
+    }
+    m_updateTimer->stop();
+    m_dirty = QRect();
+    ++m_autoFitGeneration;
+    m_autoFilter.reset(); // 模型重置时代理模型也清除筛选
+
+    m_model->setWorksheet(worksheet);
+    if (worksheet) {
+        connect(worksheet, &Worksheet::cellChanged, this, &SpreadsheetView::onCellChanged);
+        connect(worksheet, &Worksheet::sorted, this, &SpreadsheetView::onSorted);
+    }
 }
 
 // 提供手动更新数据的公有接口
 void SpreadsheetView::refresh()
 {
-    loadData();
+    setWorksheet(m_model->worksheet());
 }
 
-void SpreadsheetView::setupHeaders()
+void SpreadsheetView::onCellChanged(int row, int col)
 {
-    // 设置列标题 (A, B, C, ...)
-    QStringList horizontalLabels;
-    for (int i = 0; i < columnCount(); ++i) {
-        QString label;
-        int n = i;
-        while(n >= 0){
-            label.prepend(QChar('A' + (n % 26)));
-            n = n / 26 - 1;
+    markDirty(QRect(col, row, 1, 1));
+    if (m_autoFilter) {
+        m_autoFilter->invalidateColumn(col); // 下次重新筛选时读取新内容，当前显示的行不变
+    }
+}
+
+// 排序不逐个发送cellChanged，整个范围按一次改变处理（刷新时只取可见部分）
+void SpreadsheetView::onSorted(const Worksheet::SortSpec &spec)
+{
+    markDirty(QRect(QPoint(spec.firstColumn, spec.firstRow), QPoint(spec.lastColumn, spec.lastRow)));
+    if (m_autoFilter) {
+        m_autoFilter->invalidate(); // 行已移动，按原条件重新筛选
+        applyFilter();
+    }
+}
+
+void SpreadsheetView::markDirty(const QRect &cells)
+{
+    m_dirty = m_dirty.isNull() ? cells : m_dirty.united(cells);
+    if (!m_updateTimer->isActive()) {
+        m_updateTimer->start();
+    }
+}
+
+void SpreadsheetView::flushUpdates()
+{
+    const QRect dirty = m_dirty;
+    m_dirty = QRect();
+
+    m_model->syncSize(); // 新分配的单元格可能扩展了工作表
+    m_model->cellsChanged(dirty.intersected(visibleCells()));
+}
+
+// 视口中可见的单元格范围（x为列，y为工作表中的行）；筛选时包括可见行之间被筛去的行
+QRect SpreadsheetView::visibleCells() const
+{
+    const int top = rowAt(0);
+    const int left = columnAt(0);
+    if (top < 0 || left < 0) {
+        return QRect();
+    }
+
+    int bottom = rowAt(viewport()->height() - 1);
+    int right = columnAt(viewport()->width() - 1);
+    if (bottom < 0) {
+        bottom = m_filterModel->rowCount() - 1; // 最后一行之下是空白
+    }
+    if (right < 0) {
+        right = columnCount() - 1;
+    }
+    return QRect(QPoint(left, sourceRow(top)), QPoint(right, sourceRow(bottom)));
+}
+
+int SpreadsheetView::sourceRow(int viewRow) const
+{
+    return m_filterModel->mapRowToSource(viewRow);
+}
+
+QVector<int> SpreadsheetView::visibleRows() const
+{
+    QVector<int> rows;
+    for (int y = 0; y < viewport()->height();) {
+        const int row = rowAt(y);
+        if (row < 0) {
+            break;
         }
-        horizontalLabels << label;
+        rows.append(sourceRow(row));
+        y = rowViewportPosition(row) + rowHeight(row);
     }
-    setHorizontalHeaderLabels(horizontalLabels);
+    return rows;
+}
 
-    // 设置行标题 (1, 2, 3, ...)
-    QStringList verticalLabels;
-    for (int i = 0; i < rowCount(); i++) {
-        verticalLabels << QString::number(i + 1);
+void SpreadsheetView::autoFitColumns(int firstColumn, int lastColumn)
+{
+    firstColumn = qMax(firstColumn, 0);
+    lastColumn = qMin(lastColumn, columnCount() - 1);
+    if (firstColumn > lastColumn) {
+        return;
     }
-    setVerticalHeaderLabels(verticalLabels);
 
-    // 设置默认列宽、行高
-    horizontalHeader()->setDefaultSectionSize(80);
-    verticalHeader()->setDefaultSectionSize(25);
+    QVector<ColumnAutoFit::Column> columns = ColumnAutoFit::sample(worksheet(), firstColumn, lastColumn, visibleRows());
+    for (int col = firstColumn; col <= lastColumn; ++col) {
+        columns[col - firstColumn].header = m_model->headerData(col, Qt::Horizontal).toString();
+    }
+
+    QStyleOptionHeader headerOption;
+    headerOption.initFrom(horizontalHeader());
+    const int headerMargin = 2 * style()->pixelMetric(QStyle::PM_HeaderMargin, &headerOption, horizontalHeader());
+    const int cellMargin = 2 * CellDelegate::Padding + 1; // 两侧边距与网格线
+    const QFont cellFont = font();
+    const QFont headerFont = horizontalHeader()->font();
+
+    // 视图销毁时watcher随之销毁，测量结果被丢弃
+    const int generation = ++m_autoFitGeneration;
+    auto promise = std::make_shared<QPromise<QVector<int>>>();
+    auto watcher = new QFutureWatcher<QVector<int>>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, generation, firstColumn]() {
+        if (generation == m_autoFitGeneration && watcher->future().resultCount() > 0) {
+            applyColumnWidths(firstColumn, watcher->result());
+        }
+        watcher->deleteLater();
+    });
+    watcher->setFuture(promise->future());
+
+    QThreadPool::globalInstance()->start([promise, columns = std::move(columns), cellFont, cellMargin, headerFont, headerMargin]() mutable {
+        promise->start();
+        promise->addResult(ColumnAutoFit::measure(std::move(columns), cellFont, cellMargin, headerFont, headerMargin));
+        promise->finish();
+    });
 }
 
-void SpreadsheetView::loadData()
+void SpreadsheetView::autoFitSelectedColumns()
 {
-    // 安全验证：确认工作簿和工作表存在
-    if (!m_workbook || !m_workbook->currentWorksheet()) {
+    const QModelIndexList selected = selectionModel()->selectedColumns();
+    if (selected.isEmpty()) {
+        autoFitColumns(0, columnCount() - 1);
         return;
     }
 
-    auto sheet = m_workbook->currentWorksheet();
+    int first = selected.first().column();
+    int last = first;
+    for (const QModelIndex &index : selected) {
+        first = qMin(first, index.column());
+        last = qMax(last, index.column());
+    }
+    autoFitColumns(first, last);
+}
 
-    // 阻止信号发送，以避免触发cellChanged导致递归
-    blockSignals(true);
+// 一次设置所有列宽：期间不重绘，列宽超过视口宽度的按视口宽度
+void SpreadsheetView::applyColumnWidths(int firstColumn, const QVector<int> &widths)
+{
+    QHeaderView *header = horizontalHeader();
+    const int minWidth = header->minimumSectionSize();
+    const int maxWidth = qMax(minWidth, viewport()->width());
+    const int count = qMin(int(widths.size()), columnCount() - firstColumn);
 
-    clearContents();
+    setUpdatesEnabled(false);
+    for (int i = 0; i < count; ++i) {
+        if (widths.at(i) > 0) {
+            header->resizeSection(firstColumn + i, qBound(minWidth, widths.at(i), maxWidth));
+        }
+    }
+    setUpdatesEnabled(true);
+}
+
+int SpreadsheetView::rowCount() const
+{
+    return m_model->rowCount();
+}
 
-    for (int row = 0; row < rowCount(); row++) {
-        for (int col = 0; col < columnCount(); col++) {
-            auto cell = sheet->cell(row, col);
-            if (cell && (!cell->displayText().isEmpty() || !cell->value().isNull())) {
-                // 为有内容的单元格创建item并显示文本
-                setItem(row, col, new QTableWidgetItem(cell->displayText()));
-            }
+int SpreadsheetView::columnCount() const
+{
+    return m_model->columnCount();
+}
+
+Worksheet *SpreadsheetView::worksheet() const
+{
+    return m_model->worksheet();
+}
+
+void SpreadsheetView::setCurrentCell(int row, int col)
+{
+    const QModelIndex index = m_filterModel->mapFromSource(m_model->index(row, col)); // 被筛去的行无法选中
+    if (index.isValid()) {
+        setCurrentIndex(index);
+        scrollTo(index);
+    }
+}
+
+QRect SpreadsheetView::selectedRange() const
+{
+    const QItemSelection selection = selectionModel()->selection();
+    if (selection.size() != 1) {
+        return QRect();
+    }
+    const QItemSelectionRange &range = selection.first();
+    return QRect(QPoint(range.left(), sourceRow(range.top())), QPoint(range.right(), sourceRow(range.bottom())));
+}
+
+QRect SpreadsheetView::clipboardRange() const
+{
+    Worksheet *sheet = worksheet();
+    QRect range = selectedRange();
+    if (range.isEmpty()) {
+        const QModelIndex current = currentIndex();
+        if (!sheet || !current.isValid()) {
+            return QRect();
         }
+        range = QRect(current.column(), sourceRow(current.row()), 1, 1);
     }
+    // 选中整列时只复制到最后一个有单元格的行
+    const int lastRow = sheet->rows().isEmpty() ? range.top() : qMax(range.top(), sheet->rows().lastKey());
+    range.setBottom(qMin(range.bottom(), lastRow));
+    return range;
+}
 
-    // 数据载入完成，恢复信号
-    blockSignals(false);
+void SpreadsheetView::copySelection()
+{
+    const QRect range = clipboardRange();
+    if (range.isEmpty()) {
+        return;
+    }
+    const CellBlock block = worksheet()->copyCells(range.top(), range.bottom(), range.left(), range.right());
+    QApplication::clipboard()->setMimeData(new CellMimeData(block)); // 剪贴板取得所有权
 }
 
-void SpreadsheetView::onCellChanged(int row, int column)
+void SpreadsheetView::cutSelection()
 {
-    // 安全验证
-    if (!m_workbook || !m_workbook->currentWorksheet()) {
+    const QRect range = clipboardRange();
+    if (range.isEmpty()) {
         return;
     }
+    copySelection();
+    worksheet()->clearCells(range.top(), range.bottom(), range.left(), range.right());
+}
 
-    auto sheet = m_workbook->currentWorksheet();
-    auto cell = sheet->cell(row, column);
+void SpreadsheetView::paste()
+{
+    Worksheet *sheet = worksheet();
+    const QModelIndex current = currentIndex();
+    if (!sheet || !current.isValid()) {
+        return;
+    }
 
-    auto item = this->item(row, column);
-    if (item) {
-        QString text = item->text();
-        if (text.startsWith("=")) { // 开头为“=”，识别为公式
-            // 处理公式
-            cell->setFormula(text);
-            item->setText(cell->displayText());
-        }
-        else {
-            cell->setValue(text); // 直接显示内容
-        }
+    CellBlock block;
+    const QMimeData *mimeData = QApplication::clipboard()->mimeData();
+    if (auto cells = qobject_cast<const CellMimeData *>(mimeData)) {
+        block = cells->block(); // 本程序复制的区域：共享快照，不经过文本
+    }
+    else if (mimeData && mimeData->hasText()) {
+        block = CellBlock::fromTsv(mimeData->text().toUtf8());
+    }
+    if (block.isNull()) {
+        return;
+    }
+
+    const QRect range = selectedRange();
+    const int row = range.isEmpty() ? sourceRow(current.row()) : range.top();
+    const int col = range.isEmpty() ? current.column() : range.left();
+    sheet->pasteCells(block, row, col);
+}
+
+AutoFilter *SpreadsheetView::ensureAutoFilter()
+{
+    Worksheet *sheet = worksheet();
+    if (!m_autoFilter && sheet) {
+        const QRect range = selectedRange();
+        const int headerRow = range.height() > 1 ? range.top() : 0;
+        const int lastRow = sheet->rows().isEmpty() ? headerRow : sheet->rows().lastKey();
+        m_autoFilter = std::make_unique<AutoFilter>(sheet, headerRow, lastRow);
+    }
+    return m_autoFilter.get();
+}
+
+void SpreadsheetView::setColumnFilter(int column, const AutoFilter::Criterion &criterion)
+{
+    if (AutoFilter *filter = ensureAutoFilter()) {
+        filter->setCriterion(column, criterion);
+        applyFilter();
+    }
+}
+
+void SpreadsheetView::reapplyFilter()
+{
+    if (m_autoFilter) {
+        m_autoFilter->invalidate();
+        applyFilter();
     }
 }
 
-void SpreadsheetView::onCurrentCellChanged(int currentRow, int currentColumn,
-                                           int previousRow, int previousColumn)
+void SpreadsheetView::clearFilter()
 {
-    // 暂不处理前一单元格，留待扩展功能（如保存编辑历史）
-    Q_UNUSED(previousRow)
-    Q_UNUSED(previousColumn)
+    m_autoFilter.reset();
+    m_filterModel->clearFilter();
+}
 
-    if (m_workbook && m_workbook->currentWorksheet()) {
-        auto cell = m_workbook->currentWorksheet()->cell(currentRow, currentColumn);
-        // 可以显示单元格的公式或其他信息
+void SpreadsheetView::applyFilter()
+{
+    if (!m_autoFilter || !m_autoFilter->isActive()) {
+        m_filterModel->clearFilter();
+        return;
     }
+    m_filterModel->setFilter(m_autoFilter->headerRow(), m_autoFilter->lastRow(), m_autoFilter->visibleRows());
+}
+
+void SpreadsheetView::setupHeaders()
+{
+    // 行列标题由模型按序号即时生成（A, B, C, ... / 1, 2, 3, ...），不预先建立标签列表
+    // 设置默认列宽、行高
+    horizontalHeader()->setDefaultSectionSize(80);
+    verticalHeader()->setDefaultSectionSize(25);
+
+    // 固定行高：行表头不逐行计算尺寸，百万行时调整尺寸与滚动仍然流畅
+    verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
 }
@@ -1,33 +1,90 @@
 #pragma once
-#include <QTableWidget> // 表格控件
+#include <QTableView> // 表格视图，数据由WorksheetModel按需提供
 #include <QHeaderView> // 表头视图，用于自定义行列表头
 #include <QMouseEvent> // 鼠标事件类，处理鼠标双击等操作
+#include <QTimer>
+#include <QRect>
+#include <QVector>
 
-#include "../core/Workbook.h"
+#include <memory>
 
-class SpreadsheetView : public QTableWidget
+#include "../core/Worksheet.h"
+#include "../core/AutoFilter.h"
+
+class WorksheetModel;
+class FilterProxyModel;
+
+// 工作表的单元格改变时不立即刷新：改变的区域合并为一个矩形，每帧最多发出一次dataChanged，
+// 且只包含可见区域（其余部分滚动到时由模型读取最新内容），批量修改与导入的重绘开销只与可见范围有关。
+// 每个视图显示固定的一个工作表，滚动位置、选区与列宽随视图保留，切换标签页时不需要重新载入。
+// 单元格由CellDelegate绘制（缓存排版结果），网格线在paintEvent中对整个视口一次画出。
+// 视图的模型是FilterProxyModel：自动筛选时视图中的行号不同于工作表中的行号，
+// 本类的公有接口使用的行号都是工作表中的行号
+class SpreadsheetView : public QTableView
 {
     Q_OBJECT
 
 public:
-    explicit SpreadsheetView(Workbook *workbook = nullptr, QWidget *parent = nullptr);
+    static constexpr int UpdateInterval = 16; // 合并更新的间隔（毫秒，约一帧）
+
+    explicit SpreadsheetView(Worksheet *worksheet = nullptr, QWidget *parent = nullptr);
+
+    void setWorksheet(Worksheet *worksheet); // 改为显示另一个工作表
+    void refresh(); // 重新读取工作表（单元格被整体替换后使用）
+    void resizeSheet(int rows, int cols); // 调整工作表尺寸（不小于已有数据的范围）
+
+    // 数据分批到达时使用：只扩展不缩小工作表尺寸，通知视图重新读取指定行范围
+    void ensureSize(int rows, int cols);
+    void loadRows(int firstRow, int endRow);
+
+    int rowCount() const; // 工作表的行数（含被筛去的行），不是视图中的行数
+    int columnCount() const;
+    Worksheet *worksheet() const; // 视图显示的工作表
+    WorksheetModel *worksheetModel() const { return m_model; }
+    void setCurrentCell(int row, int col); // 选中单元格并滚动到可见位置
+    QRect selectedRange() const; // 选中的矩形区域（x为列，y为行）；未选中或选中多个区域时为空
+
+    // 按内容调整列宽：在GUI线程抽样（见ColumnAutoFit），在工作线程测量，完成后一次设置所有列宽
+    void autoFitColumns(int firstColumn, int lastColumn);
+    void autoFitSelectedColumns(); // 选中的整列，未选中整列时调整所有列
+
+    // 自动筛选：尚未筛选时建立，标题行为选中区域的第一行（只选中一行时为第一行），数据行到最后一个有数据的行
+    AutoFilter *ensureAutoFilter();
+    AutoFilter *autoFilter() const { return m_autoFilter.get(); }
+    void setColumnFilter(int column, const AutoFilter::Criterion &criterion); // 只重新计算该列
+    void reapplyFilter(); // 按各列条件重新筛选（编辑后的单元格不会自动重新筛选）
+    void clearFilter();
 
-    void setWorkbook(Workbook *workbook); // 重置当前工作簿
-    void refresh(); // 刷新视图显示
-    void resizeSheet(int rows, int cols); // 调整表格尺寸
+    // 剪贴板：复制选中的区域（未选中区域时为当前单元格），剪切在复制后删除原区域的单元格；
+    // 粘贴到选中区域的左上角，本程序复制的数据直接从快照写入（见CellMimeData），其他程序的数据按制表符分隔文本解析
+    void copySelection();
+    void cutSelection();
+    void paste();
 
 protected:
     void mouseDoubleClickEvent(QMouseEvent *event) override; // 自定义鼠标双击行为
+    void paintEvent(QPaintEvent *event) override; // 绘制单元格后批量绘制网格线
 
 private slots:
-    void onCellChanged(int row, int column);
-    void onCurrentCellChanged(int currentRow, int currentColumn,
-                              int previousRow, int previousColumn);
     void editCellDetails(); // 打开单元格内容编辑界面
+    void onCellChanged(int row, int col);
+    void onSorted(const Worksheet::SortSpec &spec);
+    void flushUpdates(); // 把积累的改变区域限制在可见范围内交给模型
 
 private:
     void setupHeaders(); // 设置表头
-    void loadData(); // 视图载入数据
+    void markDirty(const QRect &cells); // 记录改变的区域（x为列，y为行），下一帧刷新
+    QRect visibleCells() const;
+    QVector<int> visibleRows() const; // 视口中显示的行（不含隐藏的行）
+    void applyColumnWidths(int firstColumn, const QVector<int> &widths);
+    void applyFilter(); // 把筛选结果交给代理模型
+    int sourceRow(int viewRow) const;
+    QRect clipboardRange() const; // 复制的范围，不超出已分配单元格的行
 
-    Workbook *m_workbook; // 指向当前工作簿
+    WorksheetModel *m_model; // 不保存单元格内容，显示时从工作表读取
+    FilterProxyModel *m_filterModel; // 视图的模型：按筛选结果映射行号
+    std::unique_ptr<AutoFilter> m_autoFilter;
+    QTimer *m_updateTimer;
+    QRect m_dirty; // 尚未刷新的改变区域
+    int m_autoFitGeneration; // 每次调整列宽或更换工作表时递增，丢弃过期的测量结果
 };
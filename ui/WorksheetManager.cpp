@@ -9,13 +9,7 @@ WorksheetManager::WorksheetManager(Workbook *workbook, QWidget *parent)
     , m_workbook(workbook)
 {
     setupUi();
-
-    if (m_workbook) {
-        // 为现有工作表创建标签页
-        for (int i = 0; i < m_workbook->worksheetCount(); ++i) {
-            addWorksheetTab(m_workbook->worksheet(i)->name());
-        }
-    }
+    populateTabs(); // 为现有工作表创建标签页
 }
 
 void WorksheetManager::setupUi()
@@ -38,14 +32,14 @@ void WorksheetManager::setupUi()
     // 尺寸设置
     controlLayout->addWidget(new QLabel("行:"));
     m_rowsSpin = new QSpinBox;
-    m_rowsSpin->setRange(1, 10000); // 限定范围
-    m_rowsSpin->setValue(100); // 默认100行
+    m_rowsSpin->setRange(1, Worksheet::MaxRows); // 限定范围
+    m_rowsSpin->setValue(Worksheet::DefaultRows); // 默认100行
     controlLayout->addWidget(m_rowsSpin);
 
     controlLayout->addWidget(new QLabel("列:"));
     m_colsSpin = new QSpinBox;
-    m_colsSpin->setRange(1, 1000);
-    m_colsSpin->setValue(26);
+    m_colsSpin->setRange(1, Worksheet::MaxColumns); // 最多到XFD列
+    m_colsSpin->setValue(Worksheet::DefaultColumns);
     controlLayout->addWidget(m_colsSpin);
 
     m_resizeButton = new QPushButton("应用");
@@ -92,16 +86,61 @@ void WorksheetManager::setWorkbook(Workbook *workbook)
 {
     m_workbook = workbook; // 切换工作簿
 
-    // 清空现有标签页与视图
-    m_tabWidget->clear();
+    // 清空现有标签页与视图（QTabWidget::clear不删除页面）
+    {
+        QSignalBlocker blocker(m_tabWidget);
+        while (m_tabWidget->count() > 0) {
+            QWidget *page = m_tabWidget->widget(0);
+            m_tabWidget->removeTab(0);
+            delete page;
+        }
+    }
     m_spreadsheetViews.clear();
 
     // 重新创建标签页
-    if (m_workbook) {
-        for (int i = 0; i < m_workbook->worksheetCount(); i++) {
-            addWorksheetTab(m_workbook->worksheet(i)->name());
+    populateTabs();
+}
+
+// 为工作簿的所有工作表创建标签页，只切换到当前工作表（其余工作表保持未载入，也不创建视图）
+void WorksheetManager::populateTabs()
+{
+    if (!m_workbook || m_workbook->worksheetCount() == 0) return;
+
+    {
+        QSignalBlocker blocker(m_tabWidget); // 创建期间不触发标签页切换
+        for (int i = 0; i < m_workbook->worksheetCount(); ++i) {
+            m_spreadsheetViews.append(nullptr);
+            m_tabWidget->addTab(createPage(), m_workbook->worksheet(i)->name());
         }
     }
+    m_jumpIndexSpin->setRange(1, m_tabWidget->count());
+
+    const int current = qBound(0, m_workbook->currentIndex(), m_tabWidget->count() - 1);
+    m_tabWidget->setCurrentIndex(current);
+    onTabChanged(current);
+}
+
+QWidget *WorksheetManager::createPage()
+{
+    auto page = new QWidget;
+    auto layout = new QVBoxLayout(page);
+    layout->setContentsMargins(0, 0, 0, 0);
+    return page;
+}
+
+SpreadsheetView *WorksheetManager::ensureView(int index)
+{
+    if (!m_workbook || index < 0 || index >= m_spreadsheetViews.size() || index >= m_workbook->worksheetCount()) {
+        return nullptr;
+    }
+
+    if (!m_spreadsheetViews[index]) {
+        QWidget *page = m_tabWidget->widget(index);
+        auto spreadsheetView = new SpreadsheetView(m_workbook->worksheet(index).get(), page);
+        page->layout()->addWidget(spreadsheetView);
+        m_spreadsheetViews[index] = spreadsheetView;
+    }
+    return m_spreadsheetViews[index];
 }
 
 SpreadsheetView* WorksheetManager::currentSpreadsheetView() const
@@ -134,17 +173,12 @@ void WorksheetManager::addWorksheetTab(const QString &name)
         m_workbook->addWorksheet(sheetName);
     }
 
-    // 创建新的视图
-    auto spreadsheetView = new SpreadsheetView(m_workbook);
-    m_spreadsheetViews.append(spreadsheetView);
+    // 视图在切换到新标签页时创建
+    m_spreadsheetViews.append(nullptr);
 
-    int index = m_tabWidget->addTab(spreadsheetView, sheetName); // 添加到标签页控件
+    int index = m_tabWidget->addTab(createPage(), sheetName); // 添加到标签页控件
     m_tabWidget->setCurrentIndex(index); // 自动切换到新标签页
 
-    if (m_workbook && index < m_workbook->worksheetCount()) {
-        m_workbook->setCurrentWorksheet(index);
-    }
-
     // 更新跳转范围
     m_jumpIndexSpin->setRange(1, m_tabWidget->count());
 }
@@ -160,18 +194,23 @@ void WorksheetManager::removeCurrentTab()
                                                                   QMessageBox::Yes | QMessageBox::No);
 
         if (reply == QMessageBox::Yes) { // 确认删除
-            m_tabWidget->removeTab(currentIndex);
-
-            if (currentIndex < m_spreadsheetViews.size()) {
-                // 删除对应视图并从列表中移除
-                delete m_spreadsheetViews[currentIndex];
-                m_spreadsheetViews.removeAt(currentIndex);
-            }
-
-            if (m_workbook) {
-                // 从工作簿中删除对应工作表
-                m_workbook->removeWorksheet(currentIndex);
+            {
+                // 先同步删除标签页、视图与工作表，再切换到新的当前标签页
+                QSignalBlocker blocker(m_tabWidget);
+                QWidget *page = m_tabWidget->widget(currentIndex);
+                m_tabWidget->removeTab(currentIndex);
+                delete page; // 连同视图
+
+                if (currentIndex < m_spreadsheetViews.size()) {
+                    m_spreadsheetViews.removeAt(currentIndex);
+                }
+
+                if (m_workbook) {
+                    // 从工作簿中删除对应工作表
+                    m_workbook->removeWorksheet(currentIndex);
+                }
             }
+            onTabChanged(m_tabWidget->currentIndex());
 
             // 更新跳转范围
             m_jumpIndexSpin->setRange(1, m_tabWidget->count());
@@ -185,10 +224,19 @@ void WorksheetManager::onTabChanged(int index)
     if (m_workbook) {
         m_workbook->setCurrentWorksheet(index);
 
-        // 刷新当前视图以显示正确的工作表数据
-        auto currentView = currentSpreadsheetView();
-        if (currentView) {
-            currentView->refresh();  // 重新加载当前工作表的数据
+        // 首次切换到该工作表时才载入数据
+        auto worksheet = m_workbook->worksheet(index);
+        if (worksheet && !worksheet->ensureLoaded()) {
+            QMessageBox::warning(this, "错误", QString("无法载入工作表 %1").arg(worksheet->name()));
+        }
+
+        // 视图绑定各自的工作表，已创建的视图直接显示（保留滚动位置、选区与列宽），不重新载入
+        ensureView(index);
+
+        // 尺寸输入框显示该工作表的尺寸
+        if (worksheet) {
+            m_rowsSpin->setValue(qMin(worksheet->rowCount(), m_rowsSpin->maximum()));
+            m_colsSpin->setValue(qMin(worksheet->columnCount(), m_colsSpin->maximum()));
         }
     }
     emit currentWorksheetChanged(index);
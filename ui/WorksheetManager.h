@@ -39,6 +39,9 @@ private slots:
 
 private:
     void setupUi();
+    void populateTabs(); // 根据工作簿重建标签页
+    QWidget *createPage(); // 标签页容器，视图在首次激活时放入
+    SpreadsheetView *ensureView(int index); // 首次激活时创建绑定该工作表的视图
     void updateTabNames();
 
     Workbook *m_workbook; // 当前工作簿
@@ -57,6 +60,6 @@ private:
     // 跳转
     QSpinBox *m_jumpIndexSpin;
 
-    // 视图管理
+    // 视图管理：与标签页一一对应，尚未激活过的标签页为nullptr
     QList<SpreadsheetView*> m_spreadsheetViews;
 };
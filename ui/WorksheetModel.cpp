@@ -0,0 +1,142 @@
+#include "WorksheetModel.h"
+#include "../core/Cell.h"
+
+WorksheetModel::WorksheetModel(QObject *parent)
+    : QAbstractTableModel(parent)
+    , m_rowCount(0)
+    , m_colCount(0)
+{}
+
+void WorksheetModel::setWorksheet(Worksheet *worksheet)
+{
+    beginResetModel();
+    if (m_worksheet) {
+        disconnect(m_worksheet, nullptr, this, nullptr);
+    }
+    m_worksheet = worksheet;
+    m_rowCount = m_worksheet ? m_worksheet->rowCount() : 0;
+    m_colCount = m_worksheet ? m_worksheet->columnCount() : 0;
+    if (m_worksheet) {
+        connect(m_worksheet, &Worksheet::sizeChanged, this, &WorksheetModel::applySize);
+    }
+    endResetModel();
+}
+
+void WorksheetModel::applySize(int rows, int cols)
+{
+    if (rows > m_rowCount) {
+        beginInsertRows(QModelIndex(), m_rowCount, rows - 1);
+        m_rowCount = rows;
+        endInsertRows();
+    }
+    else if (rows < m_rowCount) {
+        beginRemoveRows(QModelIndex(), rows, m_rowCount - 1);
+        m_rowCount = rows;
+        endRemoveRows();
+    }
+
+    if (cols > m_colCount) {
+        beginInsertColumns(QModelIndex(), m_colCount, cols - 1);
+        m_colCount = cols;
+        endInsertColumns();
+    }
+    else if (cols < m_colCount) {
+        beginRemoveColumns(QModelIndex(), cols, m_colCount - 1);
+        m_colCount = cols;
+        endRemoveColumns();
+    }
+}
+
+void WorksheetModel::syncSize()
+{
+    if (m_worksheet) {
+        applySize(m_worksheet->rowCount(), m_worksheet->columnCount());
+    }
+}
+
+void WorksheetModel::cellsChanged(const QRect &cells)
+{
+    const QRect changed = cells.intersected(QRect(0, 0, m_colCount, m_rowCount));
+    if (!changed.isEmpty()) {
+        emit dataChanged(index(changed.top(), changed.left()), index(changed.bottom(), changed.right()),
+                         {Qt::DisplayRole});
+    }
+}
+
+int WorksheetModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_rowCount;
+}
+
+int WorksheetModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_colCount;
+}
+
+QVariant WorksheetModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || !m_worksheet || (role != Qt::DisplayRole && role != Qt::EditRole)) {
+        return QVariant();
+    }
+
+    // 只读访问：空白位置不创建单元格
+    auto cell = m_worksheet->cellAt(index.row(), index.column());
+    return cell ? cell->displayText() : QString();
+}
+
+bool WorksheetModel::setData(const QModelIndex &index, const QVariant &value, int role)
+{
+    if (!index.isValid() || !m_worksheet || role != Qt::EditRole) {
+        return false;
+    }
+
+    const QString text = value.toString();
+    auto existing = m_worksheet->cellAt(index.row(), index.column());
+    if (existing ? existing->isReadOnly() : text.isEmpty()) {
+        return false; // 只读单元格不可修改，空白位置输入空内容时不创建单元格
+    }
+
+    auto cell = m_worksheet->cell(index.row(), index.column());
+    if (text.startsWith("=")) { // 开头为“=”，识别为公式
+        cell->setFormula(text);
+    }
+    else {
+        cell->setValue(text);
+    }
+    emit dataChanged(index, index, {Qt::DisplayRole, Qt::EditRole});
+    return true;
+}
+
+QVariant WorksheetModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    if (orientation == Qt::Vertical) {
+        return section + 1; // 行号 (1, 2, 3, ...)
+    }
+
+    // 列标题 (A, B, C, ...)
+    QString label;
+    int n = section;
+    while (n >= 0) {
+        label.prepend(QChar('A' + (n % 26)));
+        n = n / 26 - 1;
+    }
+    return label;
+}
+
+Qt::ItemFlags WorksheetModel::flags(const QModelIndex &index) const
+{
+    if (!index.isValid()) {
+        return Qt::NoItemFlags;
+    }
+
+    Qt::ItemFlags flags = Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+    auto cell = m_worksheet ? m_worksheet->cellAt(index.row(), index.column()) : nullptr;
+    if (!cell || !cell->isReadOnly()) {
+        flags |= Qt::ItemIsEditable;
+    }
+    return flags;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <QAbstractTableModel>
+#include <QPointer>
+#include <QRect>
+
+#include "../core/Worksheet.h"
+
+// 工作表的表格模型：不复制单元格内容，视图请求哪个单元格才读取哪个单元格，
+// 因此载入或刷新的开销与工作表大小无关。编辑经setData直接写入工作表。
+// 行列数即工作表的尺寸（Worksheet::rowCount/columnCount），表头由序号即时生成。
+// 工作表中单元格的改变不由模型逐个转发，而由视图合并后调用cellsChanged
+class WorksheetModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    explicit WorksheetModel(QObject *parent = nullptr);
+
+    Worksheet *worksheet() const { return m_worksheet; }
+    void setWorksheet(Worksheet *worksheet); // 切换显示的工作表（重置模型）
+
+    void cellsChanged(const QRect &cells); // 通知视图重新读取该区域（x为列，y为行）中的单元格
+    void syncSize(); // 按工作表的当前尺寸插入或删除行列（分配单元格扩展的尺寸不发送sizeChanged）
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override; // 只读单元格不可编辑
+
+private slots:
+    void applySize(int rows, int cols); // 以插入、删除行列的方式同步工作表的尺寸
+
+private:
+    QPointer<Worksheet> m_worksheet;
+    int m_rowCount;
+    int m_colCount;
+};